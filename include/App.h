@@ -7,6 +7,7 @@
 #include "core/DataManager.h"
 #include "core/NetworkManager.h"
 #include "ui/PlotManager.h"
+#include "ui/PanelCanvas.h"
 #include "RTClib.h"
 #include "Adafruit_GFX.h"
 #include "Adafruit_SHT4x.h"
@@ -25,9 +26,16 @@ private:
     void initStorage();
     void updateData(bool isViewUpdate);
     void renderView(int rangeIndex, const SL_Status& status, float vbat);
+    void renderPaged(bool validRange, uint32_t prepareUs);
+    void renderFullFrame(bool validRange, uint32_t prepareUs);
+    void logRenderStats();
+#ifdef RENDER_PROFILE
+    void profileView(int rangeIndex, const SL_Status& status, float vbat);
+#endif
     void enterSleep();
     //GxEPD2_GFX* display;
     GxEPD2_DISPLAY_CLASS<GxEPD2_DRIVER_CLASS, MAX_HEIGHT(GxEPD2_DRIVER_CLASS)> display;
+    PanelCanvas frame; // whole frame in PSRAM, no buffer without it (paged fallback)
     RTC_PCF8563 rtc;
     Adafruit_SHT4x sht4;
     SPIClass hspi;
@@ -36,7 +44,7 @@ private:
     NetworkManager *networkManager;
     PlotManager *plotManager;
 
-    PetDataMap allPetData;
+    PetDataStore allPetData;
     std::vector<SL_Pet> allPets;
 };
 
@@ -108,6 +108,12 @@ namespace Config
 //#define MAX_HEIGHT(EPD) 480
     constexpr double GRAMS_PER_POUND = 453.592;
 
+    // History retention on the SD card
+    constexpr int DATA_RETENTION_DAYS = 365;
+
+    // PSRAM block for the containers of one render (see RenderArena)
+    constexpr size_t RENDER_ARENA_BYTES = 1024 * 1024;
+
     // Bitmasks for ESP32 EXT1 wakeup
     // 1ULL << Pin
     constexpr uint64_t BUTTON_KEY0_MASK = (1ULL << Pins::BUTTON_KEY0);
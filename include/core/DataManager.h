@@ -4,11 +4,16 @@
 #include <Arduino.h>
 #include <FS.h>
 #include <SD.h>
+#include "core/SdCard.h"
 #include <SPI.h>
 #include <ArduinoJson.h>
 #include "core/SharedTypes.h"
 #include "core/Config.h" 
+#include "core/RecordLog.h"
+#include "core/SegmentStore.h"
+#include "core/EnvStore.h"
 #include "ui/LayoutTypes.h" 
+#include "ui/LayoutCompiler.h"
 
 class DataManager {
 public:
@@ -17,28 +22,43 @@ public:
     // Initialize SD card using the shared SPI instance
     bool begin(SPIClass &spi);
     
-    // Load historical data from SD into the provided map
-    void loadData(PetDataMap &petData);
+    // Convert pet_data.bin / pet_data.json from older firmware to monthly segments.
+    // Call before anything reads the latest timestamp or merges API records.
+    void migrateHistory(PetDataStore &petData);
+
+    // Load the monthly history segments overlapping [from, now] into the provided store
+    void loadData(PetDataStore &petData, time_t from = 0);
+
+    // Load only the per-day rollups overlapping [from, now] (used by the long ranges)
+    void loadRollups(PetDataStore &petData, time_t from);
     
-    // Save the provided map to SD, pruning old data
-    void saveData(const PetDataMap &petData);
+    // Append records added by mergeData to their monthly segments and drop expired segments
+    void saveData(PetDataStore &petData);
     
+    // Settings (status, pets, plot range, system config, layout, secrets, timezone) are
+    // read once in begin() and served from RAM. Saves update the cache and are written
+    // to the card by flush(), except secrets which are written through.
+
     //save latest status for display on plot
     void saveStatus(const SL_Status &status);
 
-    //fetch sotred status info from SD card
-    SL_Status getStatus();
+    //fetch stored status info
+    SL_Status getStatus() const { return _status; }
 
     //push new temperature adn humidity datapoint 
     void addEnvData(env_data);
 
-    std::vector<env_data> getEnvData();
+    // Temperature/humidity buckets of one resolution tier with timestamp >= from, oldest first
+    std::vector<EnvAggregate> getEnvHistory(EnvTier tier, time_t from);
+
+    // Most recent temperature/humidity sample
+    bool getLatestEnvData(env_data &sample);
 
     //save wifi and smart litterbox login to sd card
     void saveSecrets(String ssid, String wifi_pass, String SL_Account, String SL_pass);
 
     void savePlotRange(int range);
-    int getPlotRange();
+    int getPlotRange() const { return _plotRange; }
 
     String get_ssid(){return _ssid;}
     String get_wifi_pass(){return _wifi_pass;}
@@ -49,28 +69,38 @@ public:
 
 
 
-    //store to SD card vector of pet names and IDs
+    //store vector of pet names and IDs
     void savePets(std::vector<SL_Pet> pets);
     void saveTimezone(String tz, String region);
-    //fetch stored pet vector from the SD card
-    std::vector<SL_Pet> getPets();
+    //fetch stored pet vector
+    std::vector<SL_Pet> getPets() const { return _pets; }
 
-    // Merge new records from API into the main map
-    void mergeData(PetDataMap &mainData, int PetId, const std::vector<SL_Record> &newRecords);
+    // Merge new records from API into the main store, queueing new/changed ones for saveData
+    void mergeData(PetDataStore &mainData, int PetId, const std::vector<SL_Record> &newRecords);
 
-    // Helper to find the most recent timestamp in the existing data
-    time_t getLatestTimestamp(const PetDataMap &petData);
+    // Helper to find the most recent timestamp in the existing data (including segments not loaded)
+    time_t getLatestTimestamp(const PetDataStore &petData);
+
+    // Change counters of the stored history (see SegmentStore::generation)
+    uint32_t dataGeneration() const { return _segments.generation(); }
+    uint32_t rewriteGeneration() const { return _segments.rewriteGeneration(); }
 
     // Runtime Configuration
-    SystemConfig getSystemConfig();
+    SystemConfig getSystemConfig() const { return _systemConfig; }
     void saveSystemConfig(const SystemConfig& config);
 
-    // Layout Configuration
-    std::vector<WidgetConfig> loadLayout();
+    // Layout Configuration, compiled (see LayoutCompiler)
+    const std::vector<CompiledWidget> &getLayout() const { return _layout; }
     void saveLayout(const std::vector<WidgetConfig>& layout); // For creating default
 
+    // Write settings changed since begin() and report the SD opens of this wake
+    void flush();
+
 private:
-    String _filename = "/pet_data.json";
+    String _filename = "/pet_data.json"; // legacy formats, read once for migration
+    const char* _log_filename = "/pet_data.bin";
+    SegmentStore _segments{"/data"};
+    std::vector<SL_Record> _pendingRecords;
     String _status_filename = "/status.json";
     String _pets_filename = "/pets.json";
     const char* _secrets_filename = "/secrets.json";
@@ -78,7 +108,9 @@ private:
     const char* _config_filename = "/config.json";
     const char* _system_config_filename = "/system_config.json";
     const char* _layout_filename = "/layout.json";
-    const char* _env_data_filename = "/env_data.json";
+    const char* _compiled_layout_filename = "/layout.bin";
+    const char* _env_data_filename = "/env_data.json"; // legacy format
+    EnvStore _envStore;
 
     String _ssid;
     String _wifi_pass;
@@ -86,9 +118,49 @@ private:
     String _SL_pass;
     String _region;
     String _tz;
+
+    // Settings cache
+    enum DirtyFlag : uint8_t
+    {
+        DIRTY_STATUS = 1 << 0,
+        DIRTY_PETS = 1 << 1,
+        DIRTY_PLOT_RANGE = 1 << 2,
+        DIRTY_SYSTEM_CONFIG = 1 << 3,
+        DIRTY_LAYOUT = 1 << 4,
+        DIRTY_TIMEZONE = 1 << 5,
+        DIRTY_COMPILED_LAYOUT = 1 << 6,
+    };
+    SL_Status _status;
+    std::vector<SL_Pet> _pets;
+    int _plotRange = 0;
+    SystemConfig _systemConfig;
+    std::vector<CompiledWidget> _layout;
+    std::vector<WidgetConfig> _layoutSource; // only kept when the JSON must be (re)written
+    uint32_t _layoutHash = 0;
+    uint8_t _dirty = 0;
+
+    void loadSettings();
+    bool readJson(const char *path, JsonDocument &doc, const char *what, bool *missing = nullptr);
+    bool writeJson(const char *path, const JsonDocument &doc, const char *what);
     bool loadSecrets();
     bool loadTimezone();
-    void saveEnvData(std::vector<env_data>& env);
+    void loadStatus();
+    void loadPets();
+    void loadPlotRange();
+    void loadSystemConfig();
+    void loadLayout();
+    void defaultLayout();
+    void writeStatus();
+    void writePets();
+    void writePlotRange();
+    void writeSystemConfig();
+    void writeLayout();
+    bool readCompiledLayout(uint32_t hash);
+    void writeCompiledLayout();
+    void writeTimezone();
+    bool loadLegacyData(PetDataStore &petData);
+    static void skipJsonWhitespace(File &file);
+    void migrateEnvData();
 };
 
 #endif
\ No newline at end of file
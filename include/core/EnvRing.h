@@ -0,0 +1,91 @@
+#ifndef ENV_RING_H
+#define ENV_RING_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <SD.h>
+#include "core/SdCard.h"
+#include <vector>
+
+// On-disk layout of an environment ring file:
+//   [EnvHeader][Record x capacity]
+// head is the slot the next record goes into and count the number of valid slots, so
+// the oldest record (the tail) is at (head - count) mod capacity. An append writes one
+// slot and then the header; once full, the oldest record is overwritten.
+// Every record type starts with a uint32_t timestamp, which range reads search on.
+namespace EnvRingFormat
+{
+    constexpr uint32_t MAGIC = 0x564E4550; // "PENV"
+    constexpr uint16_t VERSION = 1;
+}
+
+struct __attribute__((packed)) EnvHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t capacity;
+    uint32_t head;
+    uint32_t count;
+};
+
+// One raw SHT4x sample
+struct __attribute__((packed)) EnvRecord
+{
+    uint32_t timestamp;
+    float temperature;
+    float humidity;
+};
+
+// Samples aggregated over one bucket (hour or day)
+struct __attribute__((packed)) EnvAggregate
+{
+    uint32_t timestamp; // bucket start
+    uint16_t count;
+    uint16_t reserved;
+    float tempMin;
+    float tempMean;
+    float tempMax;
+    float humidMin;
+    float humidMean;
+    float humidMax;
+};
+
+// Fixed-capacity ring of Record on the SD card. Instantiated for EnvRecord and
+// EnvAggregate in EnvRing.cpp.
+template <class Record>
+class EnvRing
+{
+public:
+    EnvRing(const char *path, uint32_t capacity);
+
+    // Read the header if the ring exists
+    bool begin();
+    bool exists() const { return _headerValid; }
+    uint32_t count() const { return _header.count; }
+
+    // Write one record into the head slot. Cost is independent of the ring size.
+    bool append(const Record &rec);
+
+    // Newest record, and overwriting it in place (for a bucket still filling up)
+    bool last(Record &rec);
+    bool replaceLast(const Record &rec);
+
+    // Replace the ring with the given records (oldest first); keeps the newest capacity
+    bool import(const std::vector<Record> &records);
+
+    // Records with from <= timestamp < to, oldest first. Only that window is read.
+    void read(time_t from, time_t to, std::vector<Record> &out);
+
+private:
+    String _path;
+    uint32_t _capacity;
+    EnvHeader _header;
+    bool _headerValid = false;
+
+    void resetHeader();
+    uint32_t slot(uint32_t i) const;
+    bool readTimestamp(File &file, uint32_t i, uint32_t &ts);
+};
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef ENV_STORE_H
+#define ENV_STORE_H
+
+#include <Arduino.h>
+#include <vector>
+#include "core/SharedTypes.h"
+#include "core/EnvRing.h"
+
+// Temperature/humidity history kept at three resolutions, each a fixed-size ring:
+//   raw samples    /env_data.bin    last 7 days
+//   hourly min/mean/max /env_hourly.bin  last 90 days
+//   daily min/mean/max  /env_daily.bin   last 365 days
+// Every sample updates all three, so storage and read cost stay bounded no matter
+// how long the device has been running.
+enum EnvTier
+{
+    ENV_TIER_RAW,
+    ENV_TIER_HOURLY,
+    ENV_TIER_DAILY,
+    ENV_TIER_COUNT
+};
+
+class EnvStore
+{
+public:
+    EnvStore();
+
+    // Open the rings; missing aggregate tiers are rebuilt from the raw ring.
+    // Returns false if there is no raw ring yet (nothing recorded or not migrated).
+    bool begin();
+
+    // Add one sample to the raw ring and fold it into the hourly and daily buckets
+    bool append(const env_data &sample);
+
+    // Replace all tiers with the given samples (oldest first), for migration
+    bool import(const std::vector<env_data> &samples);
+
+    // Newest raw sample
+    bool latest(env_data &sample);
+
+    // Buckets of a tier with timestamp >= from, oldest first. Raw samples are
+    // returned as single-sample buckets.
+    void read(EnvTier tier, time_t from, std::vector<EnvAggregate> &out);
+
+    // Coarsest tier that reaches back rangeSeconds and still has at least one
+    // bucket per pixel (or the finest tier that reaches back that far).
+    static EnvTier selectTier(long rangeSeconds, int pixels);
+
+private:
+    EnvRing<EnvRecord> _raw;
+    EnvRing<EnvAggregate> _hourly;
+    EnvRing<EnvAggregate> _daily;
+
+    bool addToTier(EnvRing<EnvAggregate> &ring, uint32_t bucketSeconds, const env_data &sample);
+    bool rebuildTiers(const std::vector<env_data> &samples);
+    static void accumulate(EnvAggregate &agg, const env_data &sample);
+    static void startBucket(EnvAggregate &agg, uint32_t bucket, const env_data &sample);
+};
+
+#endif
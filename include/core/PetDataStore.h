@@ -0,0 +1,105 @@
+#ifndef PET_DATA_STORE_H
+#define PET_DATA_STORE_H
+
+#include <Arduino.h>
+#include <map>
+#include <vector>
+#include "PetKitApi.h"
+#include "core/PsramAllocator.h"
+
+// Aggregate of one pet's visits during one UTC day. Packed because segment rollup
+// files store these as-is. Days are UTC rather than local so the files stay valid
+// when the configured time zone changes; in US zones a "day" therefore runs from
+// about 19:00 or 20:00 to the same time the next evening.
+struct __attribute__((packed)) DailyRollup
+{
+    int32_t day;            // days since epoch (UTC)
+    uint16_t count;         // visits
+    uint16_t durationCount; // visits with a recorded duration
+    uint16_t intervalCount; // visits preceded by another visit in the same month
+    uint16_t reserved;
+    float minWeight;
+    float maxWeight;
+    float sumWeight;
+    float totalDuration; // seconds
+    float intervalSum;   // seconds
+};
+
+// Visit history of a single pet, stored as parallel arrays sorted by timestamp.
+// Arrays live in PSRAM; range queries are binary searches over the timestamp column.
+class PetSeries
+{
+public:
+    size_t size() const { return _ts.size(); }
+    bool empty() const { return _ts.empty(); }
+
+    time_t timestamp(size_t i) const { return (time_t)_ts[i]; }
+    float weight(size_t i) const { return _weight[i]; }
+    float duration(size_t i) const { return _duration[i]; }
+    SL_Record record(size_t i, int petId) const;
+
+    // Index of the first record with timestamp >= ts (size() if none)
+    size_t lowerBound(time_t ts) const;
+    // Index of the first record with timestamp > ts (size() if none)
+    size_t upperBound(time_t ts) const;
+    time_t latest() const { return _ts.empty() ? 0 : (time_t)_ts.back(); }
+
+    // Insert or replace one record. Appending in time order is O(1).
+    // Returns true if the record was new or changed an existing one.
+    bool insert(const SL_Record &rec);
+
+    // Sorted merge of an API batch; equal timestamps are replaced by the batch value.
+    // Records that were new or changed are appended to changed (if given).
+    void merge(const std::vector<SL_Record> &batch, int petId, std::vector<SL_Record> *changed);
+
+    void reserve(size_t n);
+
+    // Daily rollups, sorted by day. Kept independently of the raw columns so long
+    // ranges can be drawn without loading every visit.
+    size_t dayCount() const { return _days.size(); }
+    const DailyRollup &day(size_t i) const { return _days[i]; }
+    // Index of the first rollup with day >= d
+    size_t dayLowerBound(int32_t d) const;
+    // UTC day of a timestamp (see DailyRollup)
+    static int32_t dayOf(time_t ts) { return (int32_t)(ts / 86400L); }
+
+    // Aggregate the raw visits in [from, to) into per-day rollups. Intervals are only
+    // measured between visits inside the range, so the result depends on nothing else.
+    void buildRollups(time_t from, time_t to, std::vector<DailyRollup> &out) const;
+    // Replace the rollups for days in [fromDay, toDay) with the given sorted ones
+    void replaceRollups(int32_t fromDay, int32_t toDay, const std::vector<DailyRollup> &days);
+
+private:
+    PsramVector<uint32_t> _ts;
+    PsramVector<float> _weight;
+    PsramVector<float> _duration;
+    PsramVector<DailyRollup> _days;
+
+    bool sameValues(size_t i, const SL_Record &rec) const;
+};
+
+// Columnar history for all pets: PetID -> PetSeries
+class PetDataStore
+{
+public:
+    typedef std::map<int, PetSeries>::const_iterator const_iterator;
+    typedef std::map<int, PetSeries>::iterator iterator;
+
+    // Series for a pet, created empty if missing
+    PetSeries &pet(int petId) { return _pets[petId]; }
+    const PetSeries *find(int petId) const;
+
+    const_iterator begin() const { return _pets.begin(); }
+    const_iterator end() const { return _pets.end(); }
+    iterator begin() { return _pets.begin(); }
+    iterator end() { return _pets.end(); }
+
+    size_t totalRecords() const;
+    time_t latestTimestamp() const;
+    void clear() { _pets.clear(); }
+
+private:
+    std::map<int, PetSeries> _pets;
+};
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef PSRAM_ALLOCATOR_H
+#define PSRAM_ALLOCATOR_H
+
+#include <Arduino.h>
+#include <vector>
+#include <new>
+
+// STL allocator that places container storage in PSRAM, falling back to the
+// regular heap on boards without it.
+template <class T>
+struct PsramAllocator
+{
+    typedef T value_type;
+
+    PsramAllocator() noexcept {}
+    template <class U>
+    PsramAllocator(const PsramAllocator<U> &) noexcept {}
+
+    T *allocate(size_t n)
+    {
+        void *p = heap_caps_malloc(n * sizeof(T), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!p)
+            p = malloc(n * sizeof(T));
+        if (!p)
+            throw std::bad_alloc();
+        return static_cast<T *>(p);
+    }
+
+    void deallocate(T *p, size_t) noexcept { free(p); }
+};
+
+template <class T, class U>
+bool operator==(const PsramAllocator<T> &, const PsramAllocator<U> &) { return true; }
+template <class T, class U>
+bool operator!=(const PsramAllocator<T> &, const PsramAllocator<U> &) { return false; }
+
+template <class T>
+using PsramVector = std::vector<T, PsramAllocator<T>>;
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef RECORD_LOG_H
+#define RECORD_LOG_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <SD.h>
+#include "core/SdCard.h"
+#include <vector>
+#include <map>
+#include "core/SharedTypes.h"
+
+// On-disk layout of the binary pet record log:
+//   [LogHeader][LogRecord][LogRecord]...
+// Records are fixed width and only ever appended. The header is rewritten in place
+// after each append, so a crash mid-append leaves trailing bytes that are ignored
+// (and overwritten) because readers trust header.recordCount, not the file size.
+namespace RecordLogFormat
+{
+    constexpr uint32_t MAGIC = 0x474C5450; // "PTLG"
+    constexpr uint16_t VERSION = 1;
+    constexpr int MAX_PETS = 8;
+    constexpr time_t END_OF_TIME = (time_t)0x7FFFFFFF; // fits a 32-bit time_t
+}
+
+struct __attribute__((packed)) LogPetEntry
+{
+    int32_t petId;
+    uint32_t latestTs;
+};
+
+struct __attribute__((packed)) LogHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t recordCount;
+    LogPetEntry pets[RecordLogFormat::MAX_PETS];
+};
+
+struct __attribute__((packed)) LogRecord
+{
+    int32_t petId;
+    uint32_t timestamp;
+    float weight_lbs;
+    float duration_s;
+};
+
+class RecordLog
+{
+public:
+    RecordLog(const char *path);
+
+    bool exists();
+
+    // Read every record into the store. Later records overwrite earlier ones with the same timestamp.
+    bool load(PetDataStore &petData);
+
+    // Read only the header (record count, per-pet latest timestamps)
+    bool loadHeader();
+
+    // Append records at the end of the log and update the header. Cost is O(records.size()).
+    bool append(const std::vector<SL_Record> &records);
+
+    // Rewrite the whole log from the store records with from <= timestamp < to.
+    bool compact(const PetDataStore &petData, time_t from, time_t to = RecordLogFormat::END_OF_TIME);
+
+    // Rename the log (e.g. to a .bak for manual recovery)
+    bool rename(const String &newPath);
+
+    uint32_t recordCount() const { return _header.recordCount; }
+    time_t latestTimestamp(int petId) const;
+    time_t latestTimestamp() const;
+
+private:
+    String _path;
+    String _tmpPath;
+    LogHeader _header;
+    bool _headerValid = false;
+
+    void resetHeader();
+    bool readHeader(File &file);
+    void notePet(int32_t petId, uint32_t ts);
+    static void toLogRecord(const SL_Record &rec, int petId, LogRecord &out);
+};
+
+#endif
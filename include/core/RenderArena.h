@@ -0,0 +1,64 @@
+#ifndef RENDER_ARENA_H
+#define RENDER_ARENA_H
+
+#include <Arduino.h>
+#include <vector>
+#include <new>
+
+// Bump allocator for everything one render builds and throws away: processed series,
+// plot point copies, histogram bins and the widget vectors of the RenderModel. A single
+// PSRAM block is handed out front to back and released all at once by reset(), so a
+// refresh leaves nothing behind to fragment the general heap. Requests that do not fit,
+// or arrive before begin(), fall back to the heap and are freed normally.
+namespace RenderArena
+{
+    // Reserve the block. Without PSRAM the arena stays empty and everything falls back.
+    bool begin(size_t capacity);
+
+    void *allocate(size_t bytes);
+    void deallocate(void *p);
+
+    // Release every arena allocation in O(1). Containers using the arena must already
+    // be destroyed; a warning is logged if some are still live.
+    void reset();
+
+    bool owns(const void *p);
+    size_t used();
+    size_t peak();     // highest used() since the last reset
+    size_t capacity();
+    uint32_t overflows(); // allocations since the last reset that fell back to the heap
+
+    // Log free size, largest free block and fragmentation of internal RAM and PSRAM
+    void logHeap(const char *when);
+}
+
+// STL allocator over RenderArena, for containers that live no longer than one render
+template <class T>
+struct ArenaAllocator
+{
+    typedef T value_type;
+
+    ArenaAllocator() noexcept {}
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U> &) noexcept {}
+
+    T *allocate(size_t n)
+    {
+        void *p = RenderArena::allocate(n * sizeof(T));
+        if (!p)
+            throw std::bad_alloc();
+        return static_cast<T *>(p);
+    }
+
+    void deallocate(T *p, size_t) noexcept { RenderArena::deallocate(p); }
+};
+
+template <class T, class U>
+bool operator==(const ArenaAllocator<T> &, const ArenaAllocator<U> &) { return true; }
+template <class T, class U>
+bool operator!=(const ArenaAllocator<T> &, const ArenaAllocator<U> &) { return false; }
+
+template <class T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+#endif
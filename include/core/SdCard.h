@@ -0,0 +1,19 @@
+#ifndef SD_CARD_H
+#define SD_CARD_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <SD.h>
+
+// Thin wrapper over SD.open that counts file opens, so each wake can report how
+// often it went to the card (the SPI bus is shared with the display).
+namespace SdCard
+{
+    File open(const char *path, const char *mode = FILE_READ);
+    inline File open(const String &path, const char *mode = FILE_READ) { return open(path.c_str(), mode); }
+
+    // Opens since boot (i.e. this wake, as every wake is a fresh boot)
+    uint32_t openCount();
+}
+
+#endif
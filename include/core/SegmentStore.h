@@ -0,0 +1,124 @@
+#ifndef SEGMENT_STORE_H
+#define SEGMENT_STORE_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <SD.h>
+#include "core/SdCard.h"
+#include <vector>
+#include "core/SharedTypes.h"
+#include "core/RecordLog.h"
+
+// Pet history split into one RecordLog per UTC calendar month (/data/2026-10.bin),
+// plus a small manifest listing the segments, their record counts and latest
+// timestamps. Only the segments overlapping the requested range are ever read.
+// Each segment has a companion /data/2026-10.day holding its per-pet DailyRollups,
+// rebuilt from the raw month whenever the segment changes.
+// The manifest also carries a generation counter that advances with every change to
+// the stored history, so results derived from it can be cached (see ProcessedCache).
+namespace SegmentFormat
+{
+    constexpr uint32_t MANIFEST_MAGIC = 0x4D475350; // "PSGM"
+    constexpr uint32_t ROLLUP_MAGIC = 0x52445450;   // "PTDR"
+    constexpr uint16_t VERSION = 1;          // rollup files
+    constexpr uint16_t MANIFEST_VERSION = 2; // 2: generation counters
+    constexpr uint16_t MAX_SEGMENTS = 64;
+}
+
+struct __attribute__((packed)) ManifestHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;
+    uint32_t generation;
+    uint32_t rewriteGeneration;
+};
+
+struct __attribute__((packed)) SegmentInfo
+{
+    int32_t monthKey; // year * 12 + (month - 1)
+    uint32_t recordCount;
+    uint32_t latestTs;
+};
+
+struct __attribute__((packed)) RollupHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t entrySize;
+    uint32_t count;
+    uint32_t sourceRecords; // segment recordCount the rollups were built from
+};
+
+struct __attribute__((packed)) RollupEntry
+{
+    int32_t petId;
+    DailyRollup day;
+};
+
+class SegmentStore
+{
+public:
+    SegmentStore(const char *dir);
+
+    // Create the directory and read the manifest (rebuilt from the segment files if missing)
+    bool begin();
+    bool empty() const { return _segments.empty(); }
+
+    // Load every not-yet-loaded segment that overlaps [from, now]
+    void load(PetDataStore &petData, time_t from);
+
+    // Load the daily rollups of every segment that overlaps [from, now]. A missing or
+    // out-of-date rollup file is rebuilt from its raw segment.
+    void loadRollups(PetDataStore &petData, time_t from);
+
+    // Persist queued records: appended to their month's segment, or the segment is
+    // compacted from the store when enough superseded entries have built up. The
+    // rollups of every touched month are rebuilt from the store.
+    void save(PetDataStore &petData, const std::vector<SL_Record> &pending);
+
+    // Write the whole store out as segments (migration from older formats)
+    bool import(PetDataStore &petData);
+
+    // Delete segments (and their rollups) whose month ended before the given time
+    void prune(PetDataStore &petData, time_t before);
+
+    // Move all segments aside (e.g. /data.bak) for manual recovery. An older backup
+    // there is renamed to <newDir>.<n>. Returns false, leaving the store untouched,
+    // if the segments could not be moved.
+    bool backup(const String &newDir);
+
+    time_t latestTimestamp() const;
+
+    // Advances whenever the stored history changes. Starts from a random value when the
+    // manifest is rebuilt, so numbers from before the rebuild don't match again.
+    uint32_t generation() const { return _generation; }
+    // Generation of the last change that was not purely an append of records newer than
+    // everything stored (replacements, compaction from a migration, pruning)
+    uint32_t rewriteGeneration() const { return _rewriteGeneration; }
+
+    static int monthKey(time_t ts);
+    static time_t monthStart(int key);
+
+private:
+    String _dir;
+    String _manifestPath;
+    std::vector<SegmentInfo> _segments; // sorted by monthKey
+    std::vector<int> _loaded;
+    std::vector<int> _rollupsLoaded;
+    uint32_t _generation = 0;
+    uint32_t _rewriteGeneration = 0;
+
+    String segmentPath(int key) const;
+    String rollupPath(int key) const;
+    SegmentInfo *info(int key, bool create);
+    bool isLoaded(int key) const;
+    bool saveManifest();
+    void bumpGeneration(bool rewrite);
+    bool rebuildManifest();
+    void compactSegment(const PetDataStore &petData, SegmentInfo &seg);
+    bool readRollups(PetDataStore &petData, const SegmentInfo &seg);
+    void refreshRollups(PetDataStore &petData, const SegmentInfo &seg);
+};
+
+#endif
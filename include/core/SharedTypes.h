@@ -5,12 +5,7 @@
 #include <vector>
 #include <map>
 #include "PetKitApi.h" // Ensure this library is available
-
-// Forward declaration to avoid including full heavy headers if possible
-// but for these structs we usually need the definitions.
-
-// Define the structure for our data map: PetID -> Timestamp -> Record
-typedef std::map<int, std::map<time_t, SL_Record>> PetDataMap;
+#include "core/PetDataStore.h" // PetID -> columnar visit history
 
 enum DateRangeEnum {
   LAST_7_DAYS,
@@ -24,6 +19,7 @@ struct DateRangeInfo {
   DateRangeEnum type;
   char name[32];
   long seconds;
+  bool useRollups; // draw from daily rollups instead of raw visits
 };
 
 struct env_data
@@ -0,0 +1,29 @@
+#ifndef CAPTURE_CANVAS_H
+#define CAPTURE_CANVAS_H
+
+#include <Arduino.h>
+#include "ui/PanelCanvas.h"
+
+// Off-screen PanelCanvas for render profiling and the native tests (build with
+// -D RENDER_PROFILE). Adds a frame checksum and can save the frame as a palette PNG
+// or compare it with a golden image on the SD card.
+class CaptureCanvas : public PanelCanvas
+{
+public:
+    using PanelCanvas::PanelCanvas;
+
+    uint32_t checksum() const;
+
+    // Write the frame as <basePath>.png
+    bool writeImage(const char *basePath) const;
+    // Compare with <basePath>.png. Returns the number of differing pixels,
+    // or -1 if the image is missing, unreadable or has another size.
+    int32_t compareImage(const char *basePath) const;
+
+    static constexpr const char *IMAGE_EXT = ".png";
+
+private:
+    void indexRow(int16_t y, uint8_t *out) const;
+};
+
+#endif
@@ -4,26 +4,69 @@
 #include <vector>
 #include <map>
 #include "core/SharedTypes.h"
+#include "core/EnvRing.h"
 #include "ui/PlotDataTypes.h"
+#include "ui/HistogramAccumulator.h"
+#include "ui/LayoutTypes.h"
 #include "ui/PlotManager.h" // For ColorPair access or we can move ColorPair
 
+// One weight trend: a centered moving average over smoothingWindow points, then the
+// change between neighbouring points more than an hour apart, scaled to lbs per
+// intervalDays.
+struct TrendPreset {
+    int smoothingWindow;
+    int intervalDays;
+};
+
+namespace TrendPresets {
+    constexpr TrendPreset MONTHLY_CHANGE = {7, 30}; // the "weight_change" histogram
+    constexpr TrendPreset WEEKLY_CHANGE = {5, 7};
+}
+
+struct TrendOutput {
+    TrendPreset preset;
+    ArenaVector<float> *rates; // caller's buffer, cleared and refilled
+};
 
 class DataProcessor {
 public:
     static DashboardData process(
         const std::vector<SL_Pet> &pets, 
-        const PetDataMap &allPetData, 
+        const PetDataStore &allPetData, 
         const DateRangeInfo &range,
         const std::vector<ColorPair>& colors // Pass colors explicitly
     );
 
+    // Bring a processed pet view up to date for a range starting at timeStart: points
+    // that fell out of the range are dropped and only newer records are added. Valid
+    // while the store has only grown by appends since data was processed; returns
+    // false if the series don't line up with the store (process in full then).
+    static bool extend(DashboardData &data, const PetDataStore &allPetData, time_t timeStart);
+
     static DashboardData processEnvData(
-        const std::vector<env_data>& envData,
+        const std::vector<EnvAggregate>& envData,
         const DateRangeInfo& range,
         const std::vector<ColorPair>& colors
     );
+
+    // Compute several weight trends (up to 8) over one series in a single pass. Points
+    // are read in place when already ordered by x (a sorted copy is made otherwise).
+    static void weightTrends(const ArenaVector<DataPoint> &points, const TrendOutput *outputs, size_t count);
+
+    // Stream one histogram source (interval, duration, weight, weight_change) of every
+    // series of a processed view into bins over their shared range. Returns the number
+    // of values binned.
+    static uint32_t binHistogram(const DashboardData &data, const PetDataStore &allPetData, DataSourceId source,
+                                 int bins, ArenaVector<HistogramAccumulator> &out, float &minVal, float &maxVal);
+
+    // x of a daily rollup on the plots
+    static float dayMidpoint(const DailyRollup &day);
 private:
-    static std::vector<float> getWeightChangeRates(std::vector<DataPoint> scatterPoints, int intervalDays, int smoothingWindow = 5);
+    // Append raw visits from index first (short ranges) or daily rollups from day
+    // fromDay (long ranges) to a series
+    static void addVisits(const PetSeries &petRecords, size_t first, ProcessedSeries &series);
+    static void addRollups(const PetSeries &petRecords, int32_t fromDay, ProcessedSeries &series);
+    static float dayX(int32_t day);
 
 };
 
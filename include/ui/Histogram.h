@@ -2,12 +2,13 @@
 #define EPAPER_HISTOGRAM_H
 #include "core/Config.h"
 #include <vector>
+#include "core/RenderArena.h"
 
 
  struct HistogramSeries {
         const char* name;
-        std::vector<float> data;
-        std::vector<int> bins;
+        ArenaVector<int> bins;
+        uint32_t count = 0; // values binned
         uint16_t color;
         uint16_t backcolor;
         int seriesMaxFreq = 0; // Max frequency for this specific series
@@ -27,7 +28,7 @@ public:
 
     /**
      * @brief Set the main title of the histogram.
-     * @param title The title string.
+     * @param title The title string (copied).
      */
     void setTitle(const char* title);
     
@@ -50,12 +51,17 @@ public:
     void setBinCount(int bins);
 
     /**
-     * @brief Add a data series to be plotted.
-     * @param name The name of the series (for the legend).
-     * @param data A vector of floats for the data series.
-     * @param color The color to use for this series' bars.
+     * @brief Set the value range the series were binned over (see addBinnedSeries).
      */
-    void addSeries(const char* name, const std::vector<float>& data, uint16_t color, uint16_t background);
+    void setRange(float minVal, float maxVal);
+
+    /**
+     * @brief Add a series binned by a HistogramAccumulator over the range given to
+     * setRange().
+     * @param bins Counts per bin; their number becomes the bin count.
+     * @param count Number of values that were binned.
+     */
+    void addBinnedSeries(const char* name, const ArenaVector<int>& bins, uint32_t count, uint16_t color, uint16_t background);
 
     /**
      * @brief Enable or disable normalization.
@@ -65,6 +71,12 @@ public:
      */
     void setNormalization(bool enabled);
 
+    /**
+     * @brief Scale the bars and resolve colors. Done once; plot() can then be
+     * called for every page band.
+     */
+    void prepare();
+
     /**
      * @brief Draw the histogram on the display.
      */
@@ -89,18 +101,19 @@ private:
     // Plotting area (inside the widget area, with padding for labels/title)
     int16_t _plotX, _plotY, _plotW, _plotH;
 
-    const char* _title = nullptr;
+    char _title[64] = "";
     const char* _xAxisLabel = nullptr;
     const char* _yAxisLabel = nullptr;
 
     int _numBins = 20;
-    std::vector<HistogramSeries> _series; // Use a vector of series
+    ArenaVector<HistogramSeries> _series; // Use a vector of series
 
     float _minVal = 0.0f;
     float _maxVal = 0.0f;
     int _maxFreq = 0; // Single max frequency (global or 100% if normalized)
 
     bool _normalize = false; // Normalization flag
+    bool _prepared = false;
 
     // Constants for layout and styling
     const int PADDING_TOP = 20;
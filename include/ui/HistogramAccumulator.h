@@ -0,0 +1,55 @@
+#ifndef HISTOGRAM_ACCUMULATOR_H
+#define HISTOGRAM_ACCUMULATOR_H
+
+#include <Arduino.h>
+#include <vector>
+#include <math.h>
+#include "core/RenderArena.h"
+
+// Streaming histogram for one series, fed value by value in two passes: the first
+// finds the series' range, the second counts values into bins over the range shared
+// by all series of the chart. Only the bin counts are ever stored.
+class HistogramAccumulator
+{
+public:
+    // Pass 1
+    void include(float v)
+    {
+        if (v < _min)
+            _min = v;
+        if (v > _max)
+            _max = v;
+        _count++;
+    }
+
+    // Pass 2, same bin rule as Histogram: the maximum lands in the last bin
+    void beginBins(float minVal, float maxVal, int bins)
+    {
+        _binMin = minVal;
+        _numBins = bins > 0 ? bins : 1;
+        _binWidth = (maxVal - minVal) / _numBins;
+        _bins.assign(_numBins, 0);
+    }
+    void add(float v)
+    {
+        int i = static_cast<int>((v - _binMin) / _binWidth);
+        if (i >= _numBins)
+            i = _numBins - 1;
+        if (i >= 0)
+            _bins[i]++;
+    }
+
+    float minVal() const { return _min; }
+    float maxVal() const { return _max; }
+    uint32_t count() const { return _count; }
+    const ArenaVector<int> &bins() const { return _bins; }
+
+private:
+    float _min = HUGE_VALF, _max = -HUGE_VALF;
+    uint32_t _count = 0;
+    float _binMin = 0, _binWidth = 1;
+    int _numBins = 1;
+    ArenaVector<int> _bins;
+};
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef LAYOUT_COMPILER_H
+#define LAYOUT_COMPILER_H
+
+#include <Arduino.h>
+#include <vector>
+#include "ui/LayoutTypes.h"
+
+// /layout.bin: [CompiledLayoutHeader][CompiledWidget x count]
+namespace CompiledLayoutFormat {
+    constexpr uint32_t MAGIC = 0x54594C50; // "PLYT"
+    constexpr uint16_t VERSION = 2;
+}
+
+struct __attribute__((packed)) CompiledLayoutHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t widgetSize;
+    uint32_t sourceHash; // LayoutCompiler::hash of the layout.json bytes
+    uint32_t count;
+};
+
+// Turns parsed layout entries into CompiledWidget records, resolving the type and
+// dataSource strings once so drawing never compares strings.
+class LayoutCompiler {
+public:
+    static CompiledWidget compile(const WidgetConfig &w);
+    static void compile(const std::vector<WidgetConfig> &layout, std::vector<CompiledWidget> &out);
+
+    static WidgetKind kindFromName(const String &type);
+    static DataSourceId sourceFromName(const String &dataSource);
+    static DecimationMode decimationFromName(const String &decimation);
+
+    // FNV-1a, used to tell whether /layout.bin still matches /layout.json
+    static uint32_t hash(const uint8_t *data, size_t len, uint32_t seed = 2166136261u);
+};
+
+#endif // LAYOUT_COMPILER_H
@@ -13,9 +13,58 @@ struct WidgetConfig {
     int max = 100;
     String unit;
     uint16_t color;    
+    String decimation; // ScatterPlot: "minmax" (default), "lttb" or "none"
     WidgetConfig() : x(0), y(0), w(0), h(0), p1(0), p2(0), min(0), max(100) {}
     WidgetConfig(String t, int _x, int _y, int _w, int _h, int _p1, int _p2, String _title, String _ds, int _min, int _max, String _unit, uint16_t _color)
         : type(t), x(_x), y(_y), w(_w), h(_h), p1(_p1), p2(_p2), title(_title), dataSource(_ds), min(_min), max(_max), unit(_unit), color(_color) {}
 };
 
+// Widget kinds and data sources resolved from the layout strings at compile time
+enum WidgetKind : uint8_t {
+    WIDGET_UNKNOWN,
+    WIDGET_SCATTER_PLOT,
+    WIDGET_HISTOGRAM,
+    WIDGET_LINEAR_GAUGE,
+    WIDGET_RING_GAUGE,
+    WIDGET_TEXT_LABEL,
+    WIDGET_STATUS_BOX
+};
+
+enum DataSourceId : uint8_t {
+    SOURCE_NONE,
+    SOURCE_SCATTER,
+    SOURCE_TEMPERATURE_HISTORY,
+    SOURCE_HUMIDITY_HISTORY,
+    SOURCE_INTERVAL,
+    SOURCE_DURATION,
+    SOURCE_WEIGHT,
+    SOURCE_WEIGHT_CHANGE,
+    SOURCE_BATTERY,
+    SOURCE_LITTER,
+    SOURCE_WASTE,
+    SOURCE_DATETIME,
+    SOURCE_TEMPERATURE,
+    SOURCE_HUMIDITY,
+    SOURCE_PETKIT_STATUS
+};
+
+// How a ScatterPlot thins its series to the plot's pixel width before drawing
+enum DecimationMode : uint8_t {
+    DECIMATE_MINMAX, // lowest and highest point of every pixel column
+    DECIMATE_LTTB,   // Largest-Triangle-Three-Buckets, about two points per column
+    DECIMATE_NONE
+};
+
+// Fixed-size form of a WidgetConfig, as drawn by PlotManager and cached in /layout.bin
+struct __attribute__((packed)) CompiledWidget {
+    uint8_t kind;   // WidgetKind
+    uint8_t source; // DataSourceId
+    int16_t x, y, w, h, p1, p2;
+    int16_t min, max;
+    uint16_t color;
+    char title[48];
+    char unit[12];
+    uint8_t decimation; // DecimationMode
+};
+
 #endif // LAYOUT_TYPES_H
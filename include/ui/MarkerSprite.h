@@ -0,0 +1,50 @@
+#ifndef MARKER_SPRITE_H
+#define MARKER_SPRITE_H
+
+#include <Arduino.h>
+#include <Adafruit_GFX.h>
+
+class CaptureCanvas;
+
+// A scatter plot marker baked once from its drawing primitives into runs of one color
+// per row. Stamping clips the box once to the display and the PatternFill band, then
+// writes the runs straight into a PanelCanvas frame, or pixel by pixel inside one
+// startWrite/endWrite on any other target.
+class MarkerSprite
+{
+public:
+    static constexpr int SIZE = 9;   // sprite box, SIZE x SIZE pixels
+    static constexpr int ORIGIN = 4; // marker center inside the box
+    static constexpr int MAX_RUNS = SIZE * SIZE; // every pixel its own run
+
+    // Rasterize the marker style for a series color pair
+    void bake(uint16_t color, uint16_t background);
+
+    // Stamp the marker centered on (x, y)
+    void draw(Adafruit_GFX *gfx, int16_t x, int16_t y) const;
+
+    uint8_t runs() const { return _count; }
+
+    // The primitives a marker is baked from, drawn around (x, y)
+    static void drawShape(Adafruit_GFX *gfx, int16_t x, int16_t y, uint16_t color, uint16_t background);
+
+#ifdef RENDER_PROFILE
+    // Time a grid of markers drawn from primitives vs stamped. Returns true if they match.
+    static bool benchmark(CaptureCanvas &canvas);
+#endif
+
+private:
+    struct Run
+    {
+        int8_t dx;
+        int8_t dy;
+        uint8_t len;
+        uint16_t color;
+        uint8_t index; // color as a PanelCanvas palette index
+    };
+    Run _runs[MAX_RUNS];
+    uint8_t _count = 0;
+    static_assert(MAX_RUNS <= 255, "run count is a uint8_t");
+};
+
+#endif
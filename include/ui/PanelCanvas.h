@@ -0,0 +1,69 @@
+#ifndef PANEL_CANVAS_H
+#define PANEL_CANVAS_H
+
+#include <Arduino.h>
+#include <Adafruit_GFX.h>
+#include "core/Config.h"
+
+// Whole-frame Adafruit_GFX target in PSRAM, packed the way the panel driver takes it:
+// 2 bits per pixel on E1001 (4 grays, white = 3, leftmost pixel in the high bits) and
+// 4 bits per pixel on E1002 (GxEPD2_7C color codes, even column in the high nibble).
+// The frame is sent as is with drawNative / drawImage_4G, so rows and runs can be
+// written with memset instead of one virtual drawPixel per pixel. Rotation 0 only.
+class PanelCanvas : public Adafruit_GFX
+{
+public:
+    PanelCanvas(int16_t w = Config::EPD_WIDTH_PX, int16_t h = Config::EPD_HEIGHT_PX);
+    virtual ~PanelCanvas();
+
+    // Allocate the frame in PSRAM and register with PatternFill. Drawing is ignored until this succeeds.
+    bool begin();
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+    void fillScreen(uint16_t color) override;
+
+    // Direct write of one row of a PatternFill tile over columns [x0, x1), already clipped
+    void fillPatternRow(int16_t y, int16_t x0, int16_t x1, int16_t originX, uint8_t tileRow, uint16_t fg, uint16_t bg);
+    // Direct write of one color over columns [x0, x1) of row y, already clipped
+    void fillRun(int16_t y, int16_t x0, int16_t x1, uint16_t color);
+    // Same with a palette index from quantize(), for callers that resolve colors up front
+    void fillIndexRun(int16_t y, int16_t x0, int16_t x1, uint8_t index);
+
+    // Palette index the panel shows an RGB565 color as
+    static uint8_t quantize(uint16_t color);
+
+    // Palette index at (x, y): the panel's color code
+    uint8_t getPixel(int16_t x, int16_t y) const;
+    // RGB of a palette index, as the panel shows it
+    static const uint8_t *paletteColor(uint8_t index);
+    const uint8_t *buffer() const { return _frame; }
+    size_t bufferSize() const { return (size_t)HEIGHT * rowBytes(); }
+    uint32_t pixelWrites() const { return _pixelWrites; }
+    void resetPixelWrites() { _pixelWrites = 0; }
+
+#if (EPD_SELECT == 1001)
+    static constexpr int BITS_PER_PIXEL = 2;
+    static constexpr int PALETTE_SIZE = 4;
+#else
+    static constexpr int BITS_PER_PIXEL = 4;
+    static constexpr int PALETTE_SIZE = 7;
+#endif
+    static constexpr int PIXELS_PER_BYTE = 8 / BITS_PER_PIXEL;
+
+protected:
+    uint8_t *_frame = nullptr;
+    uint32_t _pixelWrites = 0;
+
+    size_t rowBytes() const { return (WIDTH + PIXELS_PER_BYTE - 1) / PIXELS_PER_BYTE; }
+    uint8_t paletteIndex(uint16_t color);
+
+private:
+    uint16_t _lastColor = 0; // cache starts valid: black is index 0 on both panels
+    uint8_t _lastIndex = 0;
+
+    void writeRun(uint8_t *row, int16_t x0, int16_t x1, uint8_t index);
+};
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef PATTERN_FILL_H
+#define PATTERN_FILL_H
+
+#include <Arduino.h>
+#include <Adafruit_GFX.h>
+
+class PanelCanvas;
+class CaptureCanvas;
+
+// Two-color fills used for bars, legend swatches and plot backgrounds. Each pattern is
+// an 8x8 tile (bit set = foreground) anchored at the rect's top-left corner.
+enum FillPattern : uint8_t
+{
+    FILL_SOLID,   // foreground only
+    FILL_CHECKER, // alternating pixels
+    FILL_HATCH,   // "/" diagonals every 4px
+    FILL_DOTS,    // one dot per 4x4 cell
+};
+
+// Rects are clipped to the display and to the current clip band before any pixel is
+// touched, so rows of a paged display that lie outside the page being rendered cost
+// nothing. A PanelCanvas target is filled directly in its packed frame; any other
+// target gets one writePixel per pixel inside a single startWrite/endWrite, since the
+// GxEPD2 displays only override drawPixel.
+namespace PatternFill
+{
+    void fillRect(Adafruit_GFX *gfx, int16_t x, int16_t y, int16_t w, int16_t h,
+                  FillPattern pattern, uint16_t fg, uint16_t bg);
+
+    // Limit fills to rows [top, bottom), e.g. the page band being drawn
+    void setClip(int16_t top, int16_t bottom);
+    void clearClip();
+    // Narrow rows [top, bottom) to the display and the clip band, for other rasterizers
+    void clipRows(const Adafruit_GFX *gfx, int16_t &top, int16_t &bottom);
+
+    // Canvas whose buffer fillRect() may write directly (set by PanelCanvas::begin)
+    void setCanvas(PanelCanvas *canvas);
+    PanelCanvas *canvas();
+
+#ifdef RENDER_PROFILE
+    // Time a set of bar-sized checker fills: legacy per-pixel loop vs paged path vs direct
+    // path. Returns true if all three drew the same frame.
+    bool benchmark(CaptureCanvas &canvas);
+#endif
+}
+
+#endif
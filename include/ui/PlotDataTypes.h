@@ -7,17 +7,18 @@
 
 struct ProcessedSeries {
     String name;
+    int petId = 0;
     uint16_t color;
     uint16_t bgColor;
-    std::vector<DataPoint> scatterPoints;       // For ScatterPlot
-    std::vector<float> intervalValues;          // For Interval Histogram
-    std::vector<float> durationValues;          // For Duration Histogram
-    std::vector<float> weightValues;            // For weight histogram
-    std::vector<float> deltaWeightValues;      // For change-in-weight histogram
+    ArenaVector<DataPoint> scatterPoints;       // For ScatterPlot
+    time_t lastSource = 0; // newest visit (or start of the newest rollup day) in scatterPoints
+    // Histogram values are streamed from the pet's records by DataProcessor::binHistogram
 };
 
 struct DashboardData {
-    std::vector<ProcessedSeries> series;
+    ArenaVector<ProcessedSeries> series;
+    time_t timeStart = 0; // start of the processed range
+    bool useRollups = false;
     // Add other aggregate stats here if needed later
 };
 
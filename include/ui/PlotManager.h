@@ -10,19 +10,74 @@
 #include "ui/TextLabel.h"
 #include "core/DataManager.h"
 #include "ui/PlotDataTypes.h"
+#include "ui/ProcessedCache.h"
+#ifdef RENDER_PROFILE
+#include "ui/CaptureCanvas.h"
+#endif
+
+// Vertical extent of a widget on screen, including text that overhangs its box
+struct WidgetSpan {
+    int16_t top;
+    int16_t bottom; // exclusive
+};
+
+// Everything a refresh needs, built once by PlotManager::prepare(). The draw phase
+// only reads it, once per page band.
+struct RenderModel {
+    DateRangeInfo range;
+    SL_Status status;
+    float vbat = 0;
+    float ringBatteryPercent = 0;   // sampled once so every band shows the same value
+    time_t now = 0;
+    DashboardData data;             // processed pet series
+    DashboardData envPlotData;      // processed env history
+    env_data latestEnv;
+    bool haveEnv = false;
+    const std::vector<CompiledWidget> *layout = nullptr;
+    ArenaVector<ScatterPlot> scatterPlots; // axis ranges already computed
+    ArenaVector<Histogram> histograms;     // already binned
+    ArenaVector<int16_t> slot;             // per layout widget: index into the vector for its kind, or -1
+    ArenaVector<WidgetSpan> spans;         // per layout widget, for page band culling
+};
 
 class PlotManager {
 public:
-    PlotManager(GxEPD2_DISPLAY_CLASS<GxEPD2_DRIVER_CLASS, MAX_HEIGHT(GxEPD2_DRIVER_CLASS)> *display, DataManager* datamanager);
+    PlotManager(Adafruit_GFX *display, DataManager* datamanager);
     
-    void renderDashboard(const std::vector<SL_Pet> &pets, 
-                         PetDataMap &allPetData, 
-                         const DateRangeInfo &range,
-                         const SL_Status &status,
-                         float vbat);
+    // Target for the widgets built by the next prepare(): the paged panel or a full-frame buffer
+    void setDisplay(Adafruit_GFX *display) { _display = display; }
+
+    // Prepare phase: process data, bin histograms, compute axis ranges. Call once per refresh.
+    void prepare(const std::vector<SL_Pet> &pets, 
+                 const PetDataStore &allPetData, 
+                 const DateRangeInfo &range,
+                 const SL_Status &status,
+                 float vbat);
+
+    // Draw phase: replay the prepared model. Call once per page with the page's band
+    // [bandTop, bandBottom) in screen rows; widgets outside the band are skipped.
+    // Returns the number of widgets drawn.
+    int draw(int16_t bandTop = INT16_MIN, int16_t bandBottom = INT16_MAX);
+
+    // Destroy the prepared model, so RenderArena can be reset after the render
+    void release();
+
+    // Scatter markers of the last draw, summed over all plots: points supplied and
+    // markers actually drawn
+    void markerStats(size_t &supplied, size_t &drawn) const;
+
+#ifdef RENDER_PROFILE
+    // Draw the prepared model widget by widget into a canvas, logging time and pixel writes
+    void profile(CaptureCanvas &canvas);
+#endif
 private:
-    GxEPD2_DISPLAY_CLASS<GxEPD2_DRIVER_CLASS, MAX_HEIGHT(GxEPD2_DRIVER_CLASS)> *_display;
+    static WidgetSpan spanOf(const CompiledWidget &w);
+    void drawWidget(size_t i);
+
+    Adafruit_GFX *_display;
     DataManager* _dataManager;
+    RenderModel _model;
+    ProcessedCache _processedCache{"/cache"};
     // Constants for colors, layout, etc.
     const std::vector<ColorPair> _petColors = {
         {EPD_RED, EPD_YELLOW}, {EPD_BLUE, EPD_BLACK}, 
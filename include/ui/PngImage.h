@@ -0,0 +1,74 @@
+#ifndef PNG_IMAGE_H
+#define PNG_IMAGE_H
+
+#include <Arduino.h>
+#include <FS.h>
+
+// Minimal PNG codec for the profile frames and the native test goldens.
+//
+// PngWriter streams an 8-bit palette image as one fixed-Huffman deflate block whose
+// matches repeat the pixel to the left or the row above, which covers most of a
+// dashboard. PngReader loads any non-interlaced 8-bit gray, RGB, palette or alpha
+// image (stored, fixed and dynamic blocks, all five row filters), so goldens that
+// were re-saved by another tool still compare.
+class PngWriter
+{
+public:
+    ~PngWriter();
+
+    // Write the header and palette (paletteSize RGB triples) and start the image data
+    bool begin(File &file, uint16_t width, uint16_t height, const uint8_t *palette, uint16_t paletteSize);
+    // Next row, one palette index per pixel
+    bool writeRow(const uint8_t *indices);
+    // Finish the image. False if any write failed or rows are missing.
+    bool end();
+
+private:
+    File *_file = nullptr;
+    uint16_t _width = 0;
+    uint16_t _height = 0;
+    uint16_t _row = 0;
+    uint8_t *_rows = nullptr; // previous and current row, each with its filter byte
+    uint8_t *_out = nullptr;  // pending IDAT data
+    size_t _outLen = 0;
+    uint32_t _bits = 0;
+    int _bitCount = 0;
+    uint32_t _adlerA = 1;
+    uint32_t _adlerB = 0;
+    bool _ok = false;
+
+    void putBits(uint32_t value, int count);
+    void putCode(uint16_t code, int length);
+    void putLiteral(uint16_t symbol);
+    void putMatch(uint16_t length, uint16_t distance);
+    void putByte(uint8_t b);
+    void flushData();
+    void writeChunk(const char *type, const uint8_t *data, size_t len);
+    void release();
+};
+
+class PngReader
+{
+public:
+    ~PngReader();
+
+    // Read and decode the whole image. False if the file is not a PNG this reader handles.
+    bool read(File &file);
+    uint16_t width() const { return _width; }
+    uint16_t height() const { return _height; }
+    // Row y as RGB triples (gray is expanded, alpha dropped)
+    void rgbRow(uint16_t y, uint8_t *out) const;
+
+private:
+    uint16_t _width = 0;
+    uint16_t _height = 0;
+    uint8_t _colorType = 0;
+    uint8_t _channels = 0;
+    uint8_t _palette[256][3] = {};
+    uint8_t *_pixels = nullptr; // unfiltered rows, filter bytes kept
+
+    size_t stride() const { return 1 + (size_t)_width * _channels; }
+    bool unfilter();
+};
+
+#endif
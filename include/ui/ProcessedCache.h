@@ -0,0 +1,77 @@
+#ifndef PROCESSED_CACHE_H
+#define PROCESSED_CACHE_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <SD.h>
+#include "core/SdCard.h"
+#include <vector>
+#include "core/SharedTypes.h"
+#include "ui/PlotDataTypes.h"
+
+// Processed pet views (DataProcessor::process results) kept on the card, one file per
+// date range (/cache/range0.bin):
+//   [ProcessedCacheHeader][ProcessedCacheSeries][DataPoint...][ProcessedCacheSeries]...
+// A file is keyed by the history generation it was processed at (SegmentStore), the
+// range, the pets (ids and names, in order) and the series colors. Series names are
+// not stored; they come from the pets the key matched.
+namespace ProcessedCacheFormat
+{
+    constexpr uint32_t MAGIC = 0x43505450; // "PTPC"
+    constexpr uint16_t VERSION = 1;
+    constexpr uint8_t MAX_SERIES = 8;
+}
+
+struct __attribute__((packed)) ProcessedCacheHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t pointSize;
+    uint32_t generation; // SegmentStore::generation() the view is up to date with
+    int32_t rangeSeconds;
+    uint8_t rangeType;
+    uint8_t useRollups;
+    uint8_t seriesCount;
+    uint8_t reserved;
+    uint32_t petsHash;
+    uint32_t colorsHash;
+    uint32_t timeStart;
+};
+
+struct __attribute__((packed)) ProcessedCacheSeries
+{
+    int32_t petId;
+    uint16_t color;
+    uint16_t bgColor;
+    uint32_t lastSource;
+    uint32_t pointCount;
+};
+
+class ProcessedCache
+{
+public:
+    ProcessedCache(const char *dir);
+
+    // The processed pet view for a range. The cached one is used as is when the history
+    // is unchanged, brought up to date by DataProcessor::extend when records were only
+    // appended since, and processed in full otherwise. The result is written back
+    // whenever it took in new data.
+    DashboardData process(const std::vector<SL_Pet> &pets,
+                          const PetDataStore &allPetData,
+                          const DateRangeInfo &range,
+                          const std::vector<ColorPair> &colors,
+                          uint32_t generation,
+                          uint32_t rewriteGeneration);
+
+private:
+    String _dir;
+
+    String path(const DateRangeInfo &range) const;
+    bool read(const String &path, const ProcessedCacheHeader &key, const std::vector<SL_Pet> &pets,
+              const PetDataStore &allPetData, DashboardData &data, uint32_t &generation);
+    bool write(const String &path, const ProcessedCacheHeader &key, const DashboardData &data);
+    static ProcessedCacheHeader keyOf(const std::vector<SL_Pet> &pets, const DateRangeInfo &range,
+                                      const std::vector<ColorPair> &colors, uint32_t generation);
+};
+
+#endif
@@ -6,6 +6,9 @@
 #include <Arduino.h>
 #include <vector>
 #include "core/Config.h"
+#include "core/RenderArena.h"
+#include "ui/LayoutTypes.h"
+#include "ui/MarkerSprite.h"
 #include <Fonts/FreeMonoBold9pt7b.h>
 #define PIXELS_PER_TICK     24
 
@@ -18,7 +21,7 @@ struct DataPoint {
 // A struct to hold all info for a single series
 struct PlotSeries {
     String name;
-    std::vector<DataPoint> data;
+    ArenaVector<DataPoint> data;
     uint16_t color;
     uint16_t background;
     float xMin, xMax;
@@ -28,7 +31,7 @@ struct PlotSeries {
 class ScatterPlot {
 public:
     // Constructor
-    ScatterPlot(GxEPD2_DISPLAY_CLASS<GxEPD2_DRIVER_CLASS, MAX_HEIGHT(GxEPD2_DRIVER_CLASS)>* disp, int x, int y, int width, int height, uint16_t color);
+    ScatterPlot(Adafruit_GFX* disp, int x, int y, int width, int height, uint16_t color);
 
     /**
      * @brief Add a data series to be plotted.
@@ -36,34 +39,63 @@ public:
      * @param data A vector of DataPoints for the series.
      * @param color The color to use for this series' markers.
      */
-    void addSeries(const String& name, const std::vector<DataPoint>& data, uint16_t color, uint16_t bgcolor, int xticks, int yticks);
+    void addSeries(const String& name, const ArenaVector<DataPoint>& data, uint16_t color, uint16_t bgcolor, int xticks, int yticks);
 
     // Set labels for the plot
     void setLabels(const String& title, const String& xLabel, const String& yLabel);
 
+    // How prepare() thins each series to the plot width (DECIMATE_MINMAX by default)
+    void setDecimation(DecimationMode mode) { _decimation = mode; }
+
+    // Compute colors and axis ranges once and decimate the series; draw() may then be
+    // called per page band
+    void prepare();
+
     // The main function to draw the plot
     void draw();
+
+    // Marker counts of the last draw(): points handed to addSeries(), and markers
+    // actually drawn after decimation and skipping repeats of an occupied pixel
+    size_t markersSupplied() const { return _rawPoints; }
+    size_t markersDrawn() const { return _markersDrawn; }
     
     // Helper to draw text easily
     void drawString(int x, int y, const String& text, const GFXfont* font, uint16_t color);
 
+    // The decimation steps of prepare(), reducing a series in place: the lowest and
+    // highest point of each of columns pixel columns over [xMin, xMax], or LTTB down
+    // to threshold points
+    static void decimateMinMax(ArenaVector<DataPoint> &data, int columns, float xMin, float xMax);
+    static void decimateLTTB(ArenaVector<DataPoint> &data, size_t threshold);
+
 private:
     // Framebuffer and plot dimensions
-    GxEPD2_DISPLAY_CLASS<GxEPD2_DRIVER_CLASS, MAX_HEIGHT(GxEPD2_DRIVER_CLASS)>* display;
+    Adafruit_GFX* display;
     int _x, _y, _width, _height;
     int _xticks, _yticks;
     // Plot data and labels
-    std::vector<PlotSeries> _series; // Use a vector of series
+    ArenaVector<PlotSeries> _series; // Use a vector of series
     String _title, _xLabel, _yLabel;
     uint16_t _color;
+    // Axis ranges from prepare()
+    bool _prepared = false;
+    float _xMin = 0, _xMax = 10, _yMin = 0, _yMax = 10;
+    DecimationMode _decimation = DECIMATE_MINMAX;
+    size_t _rawPoints = 0; // points across all series before decimation
+    size_t _markersDrawn = 0;
+    // One bit per (plot area pixel, series), set when a marker is drawn there
+    ArenaVector<uint32_t> _occupied;
     // Helper functions for drawing
     void drawAxes(float xMin, float xMax, float yMin, float yMax);
     void plotDataPoints(float xMin, float xMax, float yMin, float yMax);
+    int plotColumns() const;
+    int plotRows() const;
+    void decimate();
     void drawLegend();
     void drawDashedLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color, uint16_t dashLength, uint16_t spaceLength);
     void mapPoint(const DataPoint &p, int &screenX, int &screenY, float xMin, float xMax, float yMin, float yMax);
-    // Generic marker drawing function
-    void drawMarker(int x, int y, uint16_t color, uint16_t background);
+    // One baked marker per series, shared by the points and the legend
+    ArenaVector<MarkerSprite> _sprites;
 
     //add the present time to show when display last refreshed
     void add_refresh_timestamp();
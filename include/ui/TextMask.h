@@ -0,0 +1,18 @@
+#ifndef TEXT_MASK_H
+#define TEXT_MASK_H
+
+#include <Arduino.h>
+#include <Adafruit_GFX.h>
+#include "ui/TextMetrics.h"
+
+// Text drawn straight from a GFXfont's 1-bit glyph bitmaps, without an intermediate
+// canvas. Measuring and font fitting live in TextMetrics.
+namespace TextMask
+{
+    // Draw text with its baseline cursor at (x, y). Glyph pixels left of splitX get
+    // leftColor, the rest rightColor. Each glyph row is written as horizontal runs.
+    void draw(Adafruit_GFX *gfx, const GFXfont *font, const char *text, int16_t x, int16_t y,
+              int16_t splitX, uint16_t leftColor, uint16_t rightColor);
+}
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef TEXT_METRICS_H
+#define TEXT_METRICS_H
+
+#include <Arduino.h>
+#include <Adafruit_GFX.h>
+
+// Tight bounds of a string relative to its cursor, as Adafruit_GFX::getTextBounds
+// reports them for text size 1 at (0, 0).
+struct TextBounds
+{
+    int16_t x, y;
+    uint16_t w, h;
+};
+
+// Per-glyph metrics for the printable range of a font
+struct GlyphMetrics
+{
+    uint8_t xAdvance, width, height;
+    int8_t xOffset, yOffset;
+};
+
+struct FontMetrics
+{
+    static constexpr uint16_t MAX_GLYPHS = 96;
+    const GFXfont *font = nullptr;
+    uint16_t first = 0, count = 0;
+    GlyphMetrics glyphs[MAX_GLYPHS];
+};
+
+// Shared text measurement for all widgets. Glyph metrics of each font are copied into
+// a RAM table on first use, and string measurements are memoized until the next
+// beginFrame(), so the per-page draw passes of a paged refresh measure every tick
+// label and legend entry only once.
+// A null font means the built-in 6x8 font. Text size 1 only.
+namespace TextMetrics
+{
+    // Clear the memo and counters; call once per refresh
+    void beginFrame();
+    TextBounds measure(const GFXfont *font, const char *text);
+
+    // Drop-in for Adafruit_GFX::getTextBounds with the cursor at (x, y)
+    void bounds(const GFXfont *font, const char *text, int16_t x, int16_t y,
+                int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h);
+
+    // First font in fonts[] (largest first) whose bounds fit maxW x maxH, or the last
+    // one if none fit. The chosen font's bounds go to *bounds.
+    int fitFont(const GFXfont *const *fonts, int count, const char *text, uint16_t maxW, uint16_t maxH, TextBounds *bounds);
+
+    const FontMetrics &font(const GFXfont *font);
+
+    uint32_t hits();
+    uint32_t misses();
+}
+
+#endif
@@ -12,11 +12,11 @@ public:
 
 protected:
     //helper for centering text 
-    static void textCenteredCursor(Adafruit_GFX* disp, String text, int16_t x, int16_t y);   
+    static void textCenteredCursor(Adafruit_GFX* disp, const GFXfont* font, const char* text, int16_t x, int16_t y);
     Adafruit_GFX* _gfx;
     int16_t _x, _y, _w, _h;
     uint16_t _cFg, _cBg;
-    String _units;
+    const char* _units = ""; // not copied: must outlive draw()
 };
 
 // ---------------------------------------------------------
@@ -26,14 +26,14 @@ class LinearGauge : public Widget {
 public:
     LinearGauge(Adafruit_GFX* gfx, int16_t x, int16_t y, int16_t w, int16_t h, uint16_t colorFg, uint16_t colorBg);
     
-    void setRange(float minVal, float maxVal, String units);
-    void showLabel(bool show, String label);
+    void setRange(float minVal, float maxVal, const char* units);
+    void showLabel(bool show, const char* label);
     void draw(float value) override;
 
 private:
     float _min, _max;
     bool _showLabel;
-    String _label;
+    const char* _label = ""; // not copied: must outlive draw()
 };
 
 // ---------------------------------------------------------
@@ -43,17 +43,17 @@ class RingGauge : public Widget {
 public:
     RingGauge(Adafruit_GFX* gfx, int16_t x, int16_t y, int16_t radius, int16_t thickness, uint16_t colorFg, uint16_t colorBg);
     
-    void setRange(float minVal, float maxVal, String units);
+    void setRange(float minVal, float maxVal, const char* units);
     void setAngleRange(int16_t startAngle, int16_t endAngle); 
     void draw(float value) override;
-    void showLabel(bool show, String label);
+    void showLabel(bool show, const char* label);
 private:
     int16_t _radius, _thickness;
     float _min, _max;
     int16_t _startAngle, _endAngle;
     bool _showLabel;
-    String _label;
-    // Helper to draw filled arcs using triangles
+    const char* _label = ""; // not copied: must outlive draw()
+    // Scanline fill of an annular sector (angles in degrees, 0 = right, clockwise)
     void fillArc(int16_t x, int16_t y, int16_t start_angle, int16_t end_angle, int16_t r_outer, int16_t r_inner, uint16_t color);
 };
 
@@ -1,11 +1,14 @@
 #include "App.h"
+#include "ui/PatternFill.h"
+#include "ui/TextMetrics.h"
+#include "core/RenderArena.h"
 
 // Globals
 DateRangeInfo dateRangeInfo[] = {
-    {LAST_7_DAYS, "7 Days", 7 * 86400L},
-    {LAST_30_DAYS, "30 Days", 30 * 86400L},
-    {LAST_90_DAYS, "90 Days", 90 * 86400L},
-    {LAST_365_DAYS, "365 Days", 365 * 86400L},
+    {LAST_7_DAYS, "7 Days", 7 * 86400L, false},
+    {LAST_30_DAYS, "30 Days", 30 * 86400L, false},
+    {LAST_90_DAYS, "90 Days", 90 * 86400L, true},
+    {LAST_365_DAYS, "365 Days", 365 * 86400L, true},
 };
 
 App::App() : hspi(HSPI), sht4(), display(GxEPD2_DRIVER_CLASS(Config::Pins::EPD_CS, Config::Pins::EPD_DC, Config::Pins::EPD_RES, Config::Pins::EPD_BUSY))
@@ -64,6 +67,17 @@ void App::initHardware()
     display.setRotation(0);
     //display.firstPage();
   
+  // With PSRAM, a whole frame in the panel's native format lets a refresh render in
+  // one pass and go to the panel in one transfer
+  if (psramFound())
+  {
+    if (frame.begin())
+      Serial.printf("Full-frame buffer allocated in PSRAM (%u bytes)\r\n", (unsigned)frame.bufferSize());
+    else
+      Serial.println("Full-frame buffer allocation failed, using paged rendering");
+    RenderArena::begin(Config::RENDER_ARENA_BYTES);
+  }
+
 
   // Configure ADC
   analogReadResolution(12); // 12-bit resolution
@@ -124,12 +138,13 @@ void App::initStorage()
 {
   dataManager.begin(hspi);
   checkFactoryReset(); // Check reset usage after storage init
+  dataManager.migrateHistory(allPetData); // before updateData asks for the latest timestamp
 
   // Initialize managers with raw pointers
   networkManager = new NetworkManager(&dataManager);
   plotManager = new PlotManager(&display, &dataManager);
-
-  dataManager.loadData(allPetData);
+  // History is loaded on demand: mergeData pulls in the months an API batch touches,
+  // and setup() loads the displayed range just before rendering.
 }
 
 /**
@@ -209,21 +224,158 @@ void App::updateData(bool isViewUpdate)
 /**
  * @brief Renders the dashboard view to the E-Paper display.
  *
+ * Two phases: the render model is prepared once, then drawn. With a full-frame
+ * buffer in PSRAM the model is drawn exactly once and sent to the panel in one
+ * transfer; otherwise the paged display replays the drawing calls per page band.
+ * Both modes log the same timing breakdown.
+ *
  * @param rangeIndex The index of the date range to display.
  * @param status The current status of the litterbox.
- * @param wifiSuccess Whether the last WiFi connection was successful.
+ * @param vbat The measured battery voltage.
  */
 void App::renderView(int rangeIndex, const SL_Status &status, float vbat)
 {
+  RenderArena::logHeap("before render");
+  bool validRange = rangeIndex >= 0 && rangeIndex < Date_Range_Max;
+  plotManager->setDisplay(frame.buffer() ? (Adafruit_GFX *)&frame : (Adafruit_GFX *)&display);
+
+  uint32_t prepareStart = micros();
+  if (validRange)
+    plotManager->prepare(allPets, allPetData, dateRangeInfo[rangeIndex], status, vbat);
+  uint32_t prepareUs = micros() - prepareStart;
+
+  if (frame.buffer())
+    renderFullFrame(validRange, prepareUs);
+  else
+    renderPaged(validRange, prepareUs);
+
+#ifdef RENDER_PROFILE
+  if (validRange)
+    profileView(rangeIndex, status, vbat);
+#endif
+
+  // Everything the render built lives in the arena; drop it in one step
+  plotManager->release();
+  Serial.printf("[RenderArena] peak %u of %u bytes, %lu allocations fell back to the heap\r\n",
+                (unsigned)RenderArena::peak(), (unsigned)RenderArena::capacity(), (unsigned long)RenderArena::overflows());
+  RenderArena::reset();
+  RenderArena::logHeap("after render");
+}
+
+#ifdef RENDER_PROFILE
+/**
+ * @brief Re-renders the view into an off-screen canvas for profiling.
+ *
+ * Logs per-widget draw time and pixel writes, saves the frame to /render/frame.png
+ * and compares it with /render/golden.png if present. To accept a frame as the new
+ * reference, copy frame.png to golden.png on the card.
+ */
+void App::profileView(int rangeIndex, const SL_Status &status, float vbat)
+{
+  CaptureCanvas canvas;
+  if (!canvas.begin())
+    return;
+  // The capture canvas takes over PatternFill's direct path until the end
+  plotManager->setDisplay(&canvas);
+  plotManager->prepare(allPets, allPetData, dateRangeInfo[rangeIndex], status, vbat);
+  plotManager->profile(canvas);
+
+  if (!SD.exists("/render"))
+    SD.mkdir("/render");
+  canvas.writeImage("/render/frame");
+  int32_t diff = canvas.compareImage("/render/golden");
+  if (diff < 0)
+    Serial.println("[Profile] No golden image to compare against");
+  else
+    Serial.printf("[Profile] %ld pixels differ from the golden image%s\r\n", (long)diff, diff ? " (REGRESSION?)" : "");
+
+  // Micro-benchmarks draw over the frame, so they run after it has been saved
+  PatternFill::benchmark(canvas);
+  MarkerSprite::benchmark(canvas);
+  plotManager->setDisplay(frame.buffer() ? (Adafruit_GFX *)&frame : (Adafruit_GFX *)&display);
+  if (frame.buffer())
+    PatternFill::setCanvas(&frame);
+}
+#endif
+
+/**
+ * @brief Logs the per-refresh work counters shared by both render modes.
+ */
+void App::logRenderStats()
+{
+  Serial.printf("[Render] text measurements: %lu computed, %lu memoized\r\n",
+                (unsigned long)TextMetrics::misses(), (unsigned long)TextMetrics::hits());
+  size_t supplied, drawn;
+  plotManager->markerStats(supplied, drawn);
+  Serial.printf("[Render] scatter markers: %u drawn of %u points supplied\r\n", (unsigned)drawn, (unsigned)supplied);
+}
+
+/**
+ * @brief Draws the prepared model once into the PSRAM frame and sends it in one transfer.
+ *
+ * The frame is already in the controller's format, so it goes out through the paged
+ * display's driver without a copy into the display buffer.
+ */
+void App::renderFullFrame(bool validRange, uint32_t prepareUs)
+{
+  uint32_t drawStart = micros();
+  frame.fillScreen(EPD_WHITE);
+  int drawn = validRange ? plotManager->draw() : 0;
+  uint32_t drawUs = micros() - drawStart;
+
+  uint32_t refreshStart = micros();
+#if (EPD_SELECT == 1001)
+  display.epd2.drawImage_4G(frame.buffer(), PanelCanvas::BITS_PER_PIXEL, 0, 0, frame.width(), frame.height(), false, false, false);
+#else
+  display.epd2.drawNative(frame.buffer(), nullptr, 0, 0, frame.width(), frame.height(), false, false, false);
+#endif
+  uint32_t refreshUs = micros() - refreshStart;
+  Serial.printf("[Render] full-frame: prepare %lu us, draw %lu us (1 pass, %d widgets), transfer+refresh %lu us, total %lu us\r\n",
+                (unsigned long)prepareUs, (unsigned long)drawUs, drawn, (unsigned long)refreshUs,
+                (unsigned long)(prepareUs + drawUs + refreshUs));
+  logRenderStats();
+  display.hibernate();
+}
+
+/**
+ * @brief Replays the prepared model for each page band of the 64 KB paged buffer.
+ *
+ * Widgets outside the current band are skipped; each page logs how many it drew.
+ */
+void App::renderPaged(bool validRange, uint32_t prepareUs)
+{
+  // Pages are horizontal bands of pageHeight() rows. With rotation 0 they map
+  // straight onto layout coordinates, so widgets outside the band can be skipped.
+  bool cull = display.getRotation() == 0;
+  int16_t pageHeight = display.pageHeight();
+  uint32_t drawUs = 0;
+  int pages = 0;
+  uint32_t renderStart = micros();
   display.firstPage();
   do
  {
-    if (rangeIndex >= 0 && rangeIndex < Date_Range_Max)
+    uint32_t drawStart = micros();
+    int16_t bandTop = pages * pageHeight;
+    int drawn = 0;
+    if (validRange)
     {
-      plotManager->renderDashboard(allPets, allPetData, dateRangeInfo[rangeIndex], status, vbat);
+      if (cull)
+        drawn = plotManager->draw(bandTop, bandTop + pageHeight);
+      else
+        drawn = plotManager->draw();
     }
+    uint32_t pageUs = micros() - drawStart;
+    drawUs += pageUs;
+    Serial.printf("[Render] page %d rows %d-%d: %d widgets drawn in %lu us\r\n",
+                  pages, bandTop, bandTop + pageHeight - 1, drawn, (unsigned long)pageUs);
+    pages++;
     //display.display();
   } while (display.nextPage());
+  uint32_t totalUs = micros() - renderStart;
+  Serial.printf("[Render] paged: prepare %lu us, draw %lu us (%d passes), transfer+refresh %lu us, total %lu us\r\n",
+                (unsigned long)prepareUs, (unsigned long)drawUs, pages, (unsigned long)(totalUs - drawUs),
+                (unsigned long)(prepareUs + totalUs));
+  logRenderStats();
   display.hibernate();
 }
 
@@ -236,6 +388,9 @@ void App::enterSleep()
 {
   Serial.println("Sleeping...");
 
+  // Write back any settings changed during this wake
+  dataManager.flush();
+
   // Load Runtime Config
   SystemConfig sysConfig = dataManager.getSystemConfig();
 
@@ -311,8 +466,18 @@ void App::setup()
   // Update Logic
   updateData(isViewUpdate);
 
+  // Load only the history segments the selected range needs (or just their daily rollups)
+  if (rangeIndex >= 0 && rangeIndex < Date_Range_Max)
+  {
+    const DateRangeInfo &range = dateRangeInfo[rangeIndex];
+    if (range.useRollups)
+      dataManager.loadRollups(allPetData, time(NULL) - range.seconds);
+    else
+      dataManager.loadData(allPetData, time(NULL) - range.seconds);
+  }
+
   // Get current status for rendering
-  SL_Status status = dataManager.getStatus(); // Reload status in case it was updated
+  SL_Status status = dataManager.getStatus(); // Cached, includes any update from this wake
 
   // Render Logic
   renderView(rangeIndex, status, vbattery);
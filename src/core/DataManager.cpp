@@ -33,6 +33,24 @@ bool DataManager::begin(SPIClass &spi)
     }
 
     Serial.println("[DataManager] SD Card Mounted.");
+    _segments.begin();
+    if (!_envStore.begin())
+        migrateEnvData();
+
+    loadSettings();
+    return true;
+}
+
+/**
+ * @brief Reads every settings file once into the cache.
+ *
+ * Each file costs a single open (a missing file simply fails to open). Files that do
+ * not exist yet are created from defaults by the next flush().
+ */
+void DataManager::loadSettings()
+{
+    uint32_t t0 = micros();
+    uint32_t opens = SdCard::openCount();
 
     if (!loadSecrets())
     {
@@ -48,17 +66,150 @@ bool DataManager::begin(SPIClass &spi)
     }
     else
         Serial.println("[DataManager] timezone.json loaded!.");
+
+    loadStatus();
+    loadPets();
+    loadPlotRange();
+    loadSystemConfig();
+    loadLayout(); // after status, the default layout depends on the API type
+
+    Serial.printf("[DataManager] Settings cached with %u SD opens in %lu us.\r\n", SdCard::openCount() - opens, micros() - t0);
+}
+
+bool DataManager::readJson(const char *path, JsonDocument &doc, const char *what, bool *missing)
+{
+    File file = SdCard::open(path, FILE_READ);
+    if (missing)
+        *missing = !file;
+    if (!file)
+        return false;
+    DeserializationError error = deserializeJson(doc, file);
+    file.close();
+    if (error)
+    {
+        Serial.printf("[DataManager] %s JSON Parse Error: %s\r\n", what, error.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool DataManager::writeJson(const char *path, const JsonDocument &doc, const char *what)
+{
+    File file = SdCard::open(path, FILE_WRITE);
+    if (!file)
+    {
+        Serial.printf("[DataManager] Error saving %s to SD.\r\n", what);
+        return false;
+    }
+    serializeJsonPretty(doc, file);
+    file.flush();
+    file.close();
+    Serial.printf("[DataManager] %s saved to SD.\r\n", what);
     return true;
 }
 
 /**
- * @brief Loads pet data from SD card into memory.
+ * @brief Writes the settings changed since begin() back to the card.
+ *
+ * Called once before deep sleep, so several saves of the same setting in one wake
+ * cost a single write.
+ */
+void DataManager::flush()
+{
+    if (_dirty & DIRTY_STATUS)
+        writeStatus();
+    if (_dirty & DIRTY_PETS)
+        writePets();
+    if (_dirty & DIRTY_PLOT_RANGE)
+        writePlotRange();
+    if (_dirty & DIRTY_SYSTEM_CONFIG)
+        writeSystemConfig();
+    if (_dirty & DIRTY_LAYOUT)
+        writeLayout(); // also rewrites the compiled cache
+    else if (_dirty & DIRTY_COMPILED_LAYOUT)
+        writeCompiledLayout();
+    if (_dirty & DIRTY_TIMEZONE)
+        writeTimezone();
+    _dirty = 0;
+    Serial.printf("[DataManager] %u SD opens this wake.\r\n", SdCard::openCount());
+}
+
+/**
+ * @brief Converts history left by older firmware into monthly segments.
+ *
+ * The single-file binary log or the legacy JSON file is read once, split into
+ * segments and renamed to .migrated. This has to happen before anything asks for
+ * the latest timestamp or merges API records: against empty segments the app would
+ * only fetch the last 30 days and the old history would never be imported.
+ *
+ * Segments that already exist next to an unmigrated file (firmware that wrote new
+ * batches before migrating) are merged in, newer over older, and rewritten with it.
+ *
+ * @param petData Store to populate with the migrated history.
+ */
+void DataManager::migrateHistory(PetDataStore &petData)
+{
+    String source;
+    RecordLog oldLog(_log_filename);
+    if (oldLog.exists() && oldLog.load(petData))
+        source = _log_filename;
+    else if (loadLegacyData(petData))
+        source = _filename;
+    else
+        return;
+
+    if (!_segments.empty())
+    {
+        Serial.printf("[DataManager] Merging existing segments into the %s migration.\r\n", source.c_str());
+        _segments.load(petData, 0);
+    }
+    if (_segments.import(petData))
+    {
+        SD.rename(source, source + ".migrated");
+        Serial.printf("[DataManager] Migrated %s to monthly segments.\r\n", source.c_str());
+    }
+}
+
+/**
+ * @brief Loads pet data from SD card into the columnar store.
+ *
+ * Only the monthly segments overlapping [from, now] are read, so short ranges do not
+ * pay for the length of the history.
+ *
+ * @param petData Store to populate with loaded data.
+ * @param from Start of the range that will be displayed (0 loads everything).
+ */
+void DataManager::loadData(PetDataStore &petData, time_t from)
+{
+    uint32_t t0 = micros();
+    _segments.load(petData, from);
+    Serial.printf("[DataManager] Historical data loaded: %u records in %lu us.\r\n", (unsigned)petData.totalRecords(), micros() - t0);
+}
+
+/**
+ * @brief Loads the daily rollups covering [from, now] without the raw visits.
+ *
+ * @param petData Store to populate.
+ * @param from Start of the range that will be displayed.
+ */
+void DataManager::loadRollups(PetDataStore &petData, time_t from)
+{
+    _segments.loadRollups(petData, from);
+}
+
+/**
+ * @brief Reads the legacy pet_data.json format.
+ *
+ * Streams the file one record at a time straight into the store, so peak heap is a
+ * single small record document rather than a DOM of the whole history. Both the
+ * current w_lb and the older w_g weight fields are accepted.
  *
  * Handles crash recovery by checking for .tmp files from failed previous saves.
  *
- * @param petData Map to populate with loaded data.
+ * @param petData Store to populate with loaded data.
+ * @return true if legacy data was found and parsed.
  */
-void DataManager::loadData(PetDataMap &petData)
+bool DataManager::loadLegacyData(PetDataStore &petData)
 {
     const char *tempFilename = "/pet_data.tmp";
 
@@ -73,9 +224,7 @@ void DataManager::loadData(PetDataMap &petData)
         }
         else
         {
-            Serial.println("[DataManager] Recovery rename failed. Attempting to load temp file directly.");
-            // If rename fails, we can try to read the temp file directly below
-            // by temporarily swapping the pointer, but usually rename works.
+            Serial.println("[DataManager] Recovery rename failed.");
         }
     }
 
@@ -83,33 +232,62 @@ void DataManager::loadData(PetDataMap &petData)
     if (!SD.exists(_filename))
     {
         Serial.println("[DataManager] No data file found. Creating new.");
-        return;
+        return false;
     }
 
-    File file = SD.open(_filename, FILE_READ);
+    File file = SdCard::open(_filename, FILE_READ);
     if (!file)
-        return;
-
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, file);
-    file.close();
-
-    if (error)
-    {
-        Serial.print("[DataManager] JSON Parse Error: ");
-        Serial.println(error.c_str());
-        // leave corrupted file, might be manually recoverable.
-        return;
-    }
+        return false;
 
-    JsonObject root = doc.as<JsonObject>();
-    for (JsonPair petPair : root)
-    {
-        int petId = atoi(petPair.key().c_str());
-        JsonArray records = petPair.value().as<JsonArray>();
+    // The file is {"<petId>": [ {record}, {record}, ... ], ...}. Rather than building a DOM
+    // for the whole history, walk the outer structure by hand and let ArduinoJson parse one
+    // record object at a time into a small reused document.
+    JsonDocument filter;
+    filter["ts"] = true;
+    filter["w_lb"] = true;
+    filter["w_g"] = true;
+    filter["dur_s"] = true;
+
+    JsonDocument recordJson;
+    uint32_t heapBefore = ESP.getFreeHeap();
+    uint32_t heapMin = heapBefore;
+    uint32_t loaded = 0;
+    bool ok = true;
+
+    if (!file.find("{"))
+        ok = false;
+
+    while (ok)
+    {
+        // Pet ID key
+        if (!file.find("\""))
+            break; // no more pets
+        char key[16];
+        size_t keyLen = file.readBytesUntil('"', key, sizeof(key) - 1);
+        key[keyLen] = 0;
+        int petId = atoi(key);
+        if (!file.find("["))
+        {
+            ok = false;
+            break;
+        }
+        PetSeries &petRecords = petData.pet(petId);
 
-        for (JsonObject recordJson : records)
+        skipJsonWhitespace(file);
+        bool more = file.peek() != ']';
+        if (!more)
+            file.read();
+        while (more)
         {
+            DeserializationError error = deserializeJson(recordJson, file, DeserializationOption::Filter(filter));
+            if (error)
+            {
+                Serial.print("[DataManager] JSON Parse Error: ");
+                Serial.println(error.c_str());
+                ok = false;
+                break;
+            }
+
             SL_Record rec;
             rec.timestamp = recordJson["ts"];
             if(recordJson["w_lb"]) rec.weight_lbs = recordJson["w_lb"];
@@ -117,172 +295,155 @@ void DataManager::loadData(PetDataMap &petData)
             else rec.weight_lbs = 0;
             rec.duration_seconds = recordJson["dur_s"];
             rec.PetId = petId;
-            petData[petId][rec.timestamp] = rec;
+            petRecords.insert(rec);
+            loaded++;
+
+            uint32_t heapNow = ESP.getFreeHeap();
+            if (heapNow < heapMin)
+                heapMin = heapNow;
+
+            // true on ',' (another record), false on ']' (end of this pet)
+            more = file.findUntil(",", "]");
         }
+        if (!ok)
+            break;
+        // Either ',' before the next pet or the closing '}'
+        if (!file.findUntil(",", "}"))
+            break;
+    }
+    file.close();
+
+    Serial.printf("[DataManager] Streamed %u legacy records, peak heap use %u bytes.\r\n", loaded, heapBefore - heapMin);
+    if (!ok)
+    {
+        // leave corrupted file, might be manually recoverable.
+        return false;
+    }
+    Serial.println("[DataManager] Legacy JSON data loaded.");
+    return true;
+}
+
+void DataManager::skipJsonWhitespace(File &file)
+{
+    while (file.available())
+    {
+        int c = file.peek();
+        if (c != ' ' && c != '\n' && c != '\r' && c != '\t')
+            return;
+        file.read();
     }
-    Serial.println("[DataManager] Historical data loaded.");
 }
 
 /**
- * @brief Saves pet data to SD card atomically.
+ * @brief Persists records queued by mergeData.
  *
- * Writes data to a temporary file first, then renames it to the target filename
- * to prevent data corruption if power is lost during write.
- * Prunes data older than 365 days.
+ * New records are appended to the segment of their month, so the cost tracks the
+ * size of the API batch rather than the history. The daily rollups of each touched
+ * month are rebuilt alongside. Retention is applied by deleting whole segments
+ * (and their rollups) that have expired.
  *
- * @param petData The data to save.
+ * @param petData The in-memory data store.
  */
-void DataManager::saveData(const PetDataMap &petData)
+void DataManager::saveData(PetDataStore &petData)
 {
-    // ATOMIC SAVE
-    const char *tempFilename = "/pet_data.tmp";
+    _segments.save(petData, _pendingRecords);
+    _pendingRecords.clear();
 
-    // Delete temp file if it exists (cleanup from previous crash)
-    if (SD.exists(tempFilename))
-    {
-        SD.remove(tempFilename);
-    }
+    time_t pruneTimestamp = time(NULL) - (Config::DATA_RETENTION_DAYS * 86400L);
+    _segments.prune(petData, pruneTimestamp);
+}
 
-    // Write all present data to a .tmp file
-    File file = SD.open(tempFilename, FILE_WRITE);
-    if (!file)
-    {
-        Serial.println("[DataManager] Failed to open temp file for writing!");
-        return;
-    }
+void DataManager::saveStatus(const SL_Status &status)
+{
+    _status = status;
+    _dirty |= DIRTY_STATUS;
+}
 
+void DataManager::writeStatus()
+{
     JsonDocument doc;
     JsonObject root = doc.to<JsonObject>();
+    root["api_type"] = (int)_status.api_type;
+    root["is_drawer_full"] = _status.is_drawer_full;
+    root["device_name"] = _status.device_name;
+    root["device_type"] = _status.device_type;
+    root["litter_level_percent"] = _status.litter_level_percent;
+    root["waste_level_percent"] = _status.waste_level_percent;
+    root["is_error_state"] = _status.is_error_state;
+    root["status_text"] = _status.status_text;
+    root["timestamp"] = _status.timestamp;
+    writeJson(_status_filename.c_str(), doc, "Status");
+}
 
-    time_t now = time(NULL);
-    time_t pruneTimestamp = now - (365 * 86400L); // Keep 365 days
-
-    for (auto const &petPair : petData)
-    {
-        int petId = petPair.first;
-        JsonArray petArray = root[String(petId)].to<JsonArray>();
-
-        for (auto const &recordPair : petPair.second)
-        {
-            const SL_Record &record = recordPair.second;
-            if (record.timestamp < pruneTimestamp)
-                continue;
-
-            JsonObject recJson = petArray.add<JsonObject>();
-            recJson["ts"] = record.timestamp;
-            recJson["w_lb"] = record.weight_lbs;
-            recJson["dur_s"] = record.duration_seconds;
-        }
-    }
-
-    if (serializeJsonPretty(doc, file) == 0)
-    {
-        Serial.println("[DataManager] Failed to write JSON content!");
-        file.close();
-        return;
-    }
-
-    // Ensure data is physically on the card before close
-    file.flush();
-    file.close();
+void DataManager::loadStatus()
+{
+    SL_Status &s = _status;
+    s.api_type = ApiType::PETKIT;
+    s.waste_level_percent = 0;
+    s.litter_level_percent = 0;
+    s.timestamp = 0;
+    s.device_name = "";
+    s.device_type = "";
+    s.is_drawer_full = 0;
+    s.is_error_state = false;
 
-    // Verify the Temp File
-    File checkFile = SD.open(tempFilename);
-    if (!checkFile || checkFile.size() == 0)
+    JsonDocument doc;
+    if (!readJson(_status_filename.c_str(), doc, "Status"))
     {
-        Serial.println("[DataManager] Temp file is invalid. Aborting save.");
-        if (checkFile)
-            checkFile.close();
+        Serial.println("[DataManager] No Status file found.");
         return;
     }
-    checkFile.close();
-
-    // If crash here (after remove, before rename), the 'Recovery Logic' in loadData() handles it.
-    if (SD.exists(_filename))
-    {
-        SD.remove(_filename);
-    }
+    Serial.println("[DataManager] Status file loaded");
 
-    if (SD.rename(tempFilename, _filename))
-    {
-        Serial.println("[DataManager] Atomic Save Complete.");
-    }
-    else
-    {
-        Serial.println("[DataManager] Rename failed!");
-        // Note: program leaves the .tmp file there so we can try to recover it next boot
-    }
+    JsonObject root = doc.as<JsonObject>();
+    s.api_type = root["api_type"];
+    s.device_name = root["device_name"].as<String>();
+    s.device_type = root["device_name"].as<String>();
+    s.is_drawer_full = root["is_drawer_full"];
+    s.litter_level_percent = root["litter_level_percent"];
+    s.waste_level_percent = root["waste_level_percent"];
+    s.timestamp = root["timestamp"];
+    s.status_text = root["status_text"].as<String>();
+    s.is_error_state = root["is_error_state"];
 }
 
-void DataManager::saveStatus(const SL_Status &status)
+void DataManager::savePlotRange(int range)
 {
-    JsonDocument doc;
-    JsonObject root = doc.to<JsonObject>();
-    root["api_type"] = (int)status.api_type;
-    root["is_drawer_full"] = status.is_drawer_full;
-    root["device_name"] = status.device_name;
-    root["device_type"] = status.device_type;
-    root["litter_level_percent"] = status.litter_level_percent;
-    root["waste_level_percent"] = status.waste_level_percent;
-    root["is_error_state"] = status.is_error_state;
-    root["status_text"] = status.status_text;
-    root["timestamp"] = status.timestamp;
-
-    File file = SD.open(_status_filename, FILE_WRITE);
-    if (file)
-    {
-        serializeJsonPretty(doc, file);
-        file.flush();
-        file.close();
-        Serial.println("[DataManager] Status saved to SD.");
-    }
+    if (range == _plotRange)
+        return;
+    _plotRange = range;
+    _dirty |= DIRTY_PLOT_RANGE;
 }
 
-void DataManager::savePlotRange(int range)
+void DataManager::writePlotRange()
 {
     JsonDocument doc;
     JsonObject root = doc.to<JsonObject>();
-    root["plot_range_index"] = range;
-
-    File file = SD.open(_config_filename, FILE_WRITE);
-    if (file)
-    {
-        serializeJsonPretty(doc, file);
-        file.flush();
-        file.close();
-        Serial.println("[DataManager] Config.json saved to SD.");
-    }
+    root["plot_range_index"] = _plotRange;
+    writeJson(_config_filename, doc, "Config.json");
 }
 
-int DataManager::getPlotRange()
+void DataManager::loadPlotRange()
 {
-    if (!SD.exists(_config_filename))
-    {
-        Serial.println("[DataManager] No Plot Range File found. creating....");
-        savePlotRange(0);
-        return 0;
-    }
-    File file = SD.open(_config_filename, FILE_READ);
-    if (!file)
-        return false;
+    _plotRange = 0;
     JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, file);
-    file.close();
-    if (error)
+    bool missing;
+    if (!readJson(_config_filename, doc, "config", &missing))
     {
-        Serial.print("[DataManager] config JSON Parse Error: ");
-        Serial.println(error.c_str());
-        return false;
+        if (missing)
+        {
+            Serial.println("[DataManager] No Plot Range File found. creating....");
+            _dirty |= DIRTY_PLOT_RANGE;
+        }
+        return;
     }
     JsonObject root = doc.as<JsonObject>();
-    int range = root["plot_range_index"].as<int>();
-    return range;
+    _plotRange = root["plot_range_index"].as<int>();
 }
 
 void DataManager::savePets(std::vector<SL_Pet> pets)
 {
-
-    std::vector<SL_Pet> storedPets = getPets();
+    const std::vector<SL_Pet> &storedPets = _pets;
     if (!storedPets.empty())
     {
         bool allmatch = true;
@@ -314,30 +475,56 @@ void DataManager::savePets(std::vector<SL_Pet> pets)
             {
                 SD.rename(_filename, _filename + ".bak");
             }
+            if (!_segments.backup("/data.bak"))
+                Serial.println("[DataManager] History could not be moved aside, new records go into the existing segments.");
         }
     }
+    _pets = pets;
+    _dirty |= DIRTY_PETS;
+}
+
+void DataManager::writePets()
+{
     JsonDocument doc;
     JsonObject root = doc.to<JsonObject>();
 
-    for (const auto &pet : pets)
+    for (const auto &pet : _pets)
     {
         JsonObject thispet = root[pet.id].to<JsonObject>();
         thispet["name"] = pet.name;
         thispet["weight_lbs"] = pet.weight_lbs;
     }
+    writeJson(_pets_filename.c_str(), doc, "Pets");
+}
 
-    File file = SD.open(_pets_filename, FILE_WRITE);
-    if (file)
+void DataManager::loadPets()
+{
+    _pets.clear();
+    JsonDocument doc;
+    if (!readJson(_pets_filename.c_str(), doc, "pets"))
     {
-        serializeJsonPretty(doc, file);
-        file.flush();
-        file.close();
-        Serial.println("[DataManager] Pets saved to SD.");
+        Serial.println("[DataManager] No Pets file found.");
+        return;
     }
-    else
-        Serial.println("[DataManager] Error saving Pets to SD.");
+    JsonObject root = doc.as<JsonObject>();
+    for (JsonPair rec : root)
+    {
+        SL_Pet thispet;
+        thispet.id = rec.key().c_str();
+        JsonObject details = rec.value().as<JsonObject>();
+        thispet.name = details["name"].as<String>();
+        thispet.weight_lbs = details["weight_lbs"];
+        _pets.push_back(thispet);
+    }
+    Serial.println("[DataManager] Pets recalled from SD.");
 }
 
+/**
+ * @brief Saves WiFi and account credentials.
+ *
+ * Unlike the other settings this is written immediately: provisioning and factory
+ * reset restart the device right after, without going through flush().
+ */
 void DataManager::saveSecrets(String ssid, String wifi_pass, String SL_Account, String SL_pass)
 {
     _ssid = ssid;
@@ -351,14 +538,7 @@ void DataManager::saveSecrets(String ssid, String wifi_pass, String SL_Account,
     root["wifi_pass"] = wifi_pass;
     root["SL_Account"] = SL_Account;
     root["SL_pass"] = SL_pass;
-    File file = SD.open(_secrets_filename, FILE_WRITE);
-    if (file)
-    {
-        serializeJsonPretty(doc, file);
-        file.flush();
-        file.close();
-        Serial.println("[DataManager] Secrets saved to SD.");
-    }
+    writeJson(_secrets_filename, doc, "Secrets");
 }
 
 bool DataManager::loadSecrets()
@@ -367,18 +547,9 @@ bool DataManager::loadSecrets()
     _wifi_pass = "";
     _SL_Account = "";
     _SL_pass = "";
-    File file = SD.open(_secrets_filename, FILE_READ);
-    if (!file)
-        return false;
     JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, file);
-    file.close();
-    if (error)
-    {
-        Serial.print("[DataManager] pets JSON Parse Error: ");
-        Serial.println(error.c_str());
+    if (!readJson(_secrets_filename, doc, "secrets"))
         return false;
-    }
     JsonObject root = doc.as<JsonObject>();
     _ssid = root["ssid"].as<String>();
     _wifi_pass = root["wifi_pass"].as<String>();
@@ -389,156 +560,64 @@ bool DataManager::loadSecrets()
     return false;
 }
 
-std::vector<SL_Pet> DataManager::getPets()
-{
-    std::vector<SL_Pet> pets;
-    if (!SD.exists(_pets_filename))
-    {
-        Serial.println("[DataManager] No Pets file found.");
-        return pets;
-    }
-    File file = SD.open(_pets_filename, FILE_READ);
-    if (!file)
-        return pets;
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, file);
-    file.close();
-    if (error)
-    {
-        Serial.print("[DataManager] pets JSON Parse Error: ");
-        Serial.println(error.c_str());
-        return pets;
-    }
-    JsonObject root = doc.as<JsonObject>();
-    for (JsonPair rec : root)
-    {
-        SL_Pet thispet;
-        thispet.id = rec.key().c_str();
-        JsonObject details = rec.value().as<JsonObject>();
-        thispet.name = details["name"].as<String>();
-        thispet.weight_lbs = details["weight_lbs"];
-        pets.push_back(thispet);
-    }
-    Serial.println("[DataManager] Pets recalled from SD.");
-    return pets;
-}
-
-SL_Status DataManager::getStatus()
-{
-    SL_Status s;
-    s.api_type = ApiType::PETKIT;
-    s.waste_level_percent = 0;
-    s.litter_level_percent = 0;
-    s.timestamp = 0;
-    s.device_name = "";
-    s.device_type = "";
-    s.is_drawer_full = 0;
-    s.is_error_state = false;
-
-    if (!SD.exists(_status_filename))
-    {
-        Serial.println("[DataManager] No Status file found.");
-        return s;
-    }
-    else
-        Serial.println("[DataManager] Status file loaded");
-
-    File file = SD.open(_status_filename, FILE_READ);
-    if (!file)
-        return s;
-
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, file);
-    file.close();
-    if (error)
-    {
-        Serial.print("[DataManager] Status JSON Parse Error: ");
-        Serial.println(error.c_str());
-        return s;
-    }
-
-    JsonObject root = doc.as<JsonObject>();
-    s.api_type = root["api_type"];
-    s.device_name = root["device_name"].as<String>();
-    s.device_type = root["device_name"].as<String>();
-    s.is_drawer_full = root["is_drawer_full"];
-    s.litter_level_percent = root["litter_level_percent"];
-    s.waste_level_percent = root["waste_level_percent"];
-    s.timestamp = root["timestamp"];
-    s.status_text = root["status_text"].as<String>();
-    s.is_error_state = root["is_error_state"];
-    return s;
-}
-
 /**
  * @brief Merges new API records into the existing dataset.
  *
- * @param mainData Reference to the main data map.
+ * Sorted merge into the pet's columns; records that are new or changed are queued
+ * for the next saveData append.
+ *
+ * @param mainData Reference to the main data store.
  * @param petId The ID of the pet the records belong to.
  * @param newRecords Vector of new records from the API.
  */
-void DataManager::mergeData(PetDataMap &mainData, int petId, const std::vector<SL_Record> &newRecords)
+void DataManager::mergeData(PetDataStore &mainData, int petId, const std::vector<SL_Record> &newRecords)
 {
+    if (newRecords.empty())
+        return;
+
+    // The batch may reach back further than the loaded range; its segments must be in
+    // memory so existing records are recognised as duplicates.
+    time_t oldest = newRecords.front().timestamp;
     for (const auto &record : newRecords)
-    {
-        mainData[petId][record.timestamp] = record;
-    }
+        oldest = std::min(oldest, record.timestamp);
+    _segments.load(mainData, oldest);
+
+    uint32_t t0 = micros();
+    size_t queued = _pendingRecords.size();
+    mainData.pet(petId).merge(newRecords, petId, &_pendingRecords);
+    Serial.printf("[DataManager] Merged %u records for pet %d (%u new/changed) in %lu us.\r\n",
+                  (unsigned)newRecords.size(), petId, (unsigned)(_pendingRecords.size() - queued), micros() - t0);
 }
 
-time_t DataManager::getLatestTimestamp(const PetDataMap &petData)
+time_t DataManager::getLatestTimestamp(const PetDataStore &petData)
 {
-    time_t latest = 0;
-    for (auto const &petPair : petData)
-    {
-        const std::map<time_t, SL_Record> &recordsMap = petPair.second;
-        if (!recordsMap.empty())
-        {
-            time_t petLatest = recordsMap.rbegin()->first;
-            if (petLatest > latest)
-            {
-                latest = petLatest;
-            }
-        }
-    }
-    return latest;
+    return std::max(petData.latestTimestamp(), _segments.latestTimestamp());
 }
 
 void DataManager::saveTimezone(String tz, String region)
 {
     _tz = tz;
     _region = region;
+    _dirty |= DIRTY_TIMEZONE;
+}
 
+void DataManager::writeTimezone()
+{
     JsonDocument doc;
     JsonObject root = doc.to<JsonObject>();
 
-    root["tz"] = tz;
-    root["region"] = region;
-    File file = SD.open(_tz_filename, FILE_WRITE);
-    if (file)
-    {
-        serializeJsonPretty(doc, file);
-        file.flush();
-        file.close();
-        Serial.println("[DataManager] Timezone saved to SD.");
-    }
+    root["tz"] = _tz;
+    root["region"] = _region;
+    writeJson(_tz_filename, doc, "Timezone");
 }
 
 bool DataManager::loadTimezone()
 {
     _tz = "";
     _region = "";
-    File file = SD.open(_tz_filename, FILE_READ);
-    if (!file)
-        return false;
     JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, file);
-    file.close();
-    if (error)
-    {
-        Serial.print("[DataManager] timezone JSON Parse Error: ");
-        Serial.println(error.c_str());
+    if (!readJson(_tz_filename, doc, "timezone"))
         return false;
-    }
     JsonObject root = doc.as<JsonObject>();
     _tz = root["tz"].as<String>();
     _region = root["region"].as<String>();
@@ -550,109 +629,105 @@ bool DataManager::loadTimezone()
 void DataManager::addEnvData(env_data newvalue)
 {
     Serial.printf("{DataManager] Temperature: %.2f°C, Humidity %.2f%\r\n", newvalue.temperature, newvalue.humidity);
-    std::vector<env_data> env = getEnvData();
-    env.push_back(newvalue);
-    saveEnvData(env);
+    if (!_envStore.append(newvalue))
+        Serial.println("[DataManager] Failed to log ENV data.");
 }
 
-void DataManager::saveEnvData(std::vector<env_data> &env)
+std::vector<EnvAggregate> DataManager::getEnvHistory(EnvTier tier, time_t from)
 {
-    JsonDocument doc;
-    JsonObject root = doc.to<JsonObject>();
-    JsonArray data = root["data"].to<JsonArray>();
-    for (env_data dat : env)
-    {
-        JsonObject recJson = data.add<JsonObject>();
-        recJson["temperature"] = dat.temperature;
-        recJson["humidity"] = dat.humidity;
-        recJson["timestamp"] = dat.timestamp;
-    }
-    File file = SD.open(_env_data_filename, FILE_WRITE);
-    if (file)
-    {
-        serializeJsonPretty(doc, file);
-        file.flush();
-        file.close();
-        Serial.println("[DataManager] ENV data saved to SD.");
-    }
+    std::vector<EnvAggregate> env;
+    uint32_t t0 = micros();
+    _envStore.read(tier, from, env);
+    Serial.printf("[DataManager] %u environmental points (tier %d) read in %lu us.\r\n", (unsigned)env.size(), (int)tier, micros() - t0);
+    return env;
 }
 
-std::vector<env_data> DataManager::getEnvData()
+bool DataManager::getLatestEnvData(env_data &sample)
+{
+    return _envStore.latest(sample);
+}
+
+/**
+ * @brief Moves the old env_data.json into the binary rings.
+ *
+ * The JSON array is streamed one sample at a time (same approach as the legacy pet
+ * history), then written to every tier in one pass and renamed to .migrated.
+ */
+void DataManager::migrateEnvData()
 {
-    std::vector<env_data> env;
     if (!SD.exists(_env_data_filename))
-    {
-        Serial.println("[DataManager] No environmental data found.");
-        return env;
-    }
-    File file = SD.open(_env_data_filename, FILE_READ);
+        return;
+    File file = SdCard::open(_env_data_filename, FILE_READ);
     if (!file)
-        return env;
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, file);
-    file.close();
-    if (error)
+        return;
+
+    std::vector<env_data> env;
+    JsonDocument sample;
+    bool ok = file.find("[");
+    if (ok)
     {
-        Serial.print("[DataManager] env JSON Parse Error: ");
-        Serial.println(error.c_str());
-        return env;
+        skipJsonWhitespace(file);
+        bool more = file.peek() != ']';
+        while (more)
+        {
+            DeserializationError error = deserializeJson(sample, file);
+            if (error)
+            {
+                Serial.print("[DataManager] env JSON Parse Error: ");
+                Serial.println(error.c_str());
+                ok = false;
+                break;
+            }
+            env_data dat;
+            dat.humidity = sample["humidity"];
+            dat.temperature = sample["temperature"];
+            dat.timestamp = sample["timestamp"];
+            env.push_back(dat);
+            more = file.findUntil(",", "]");
+        }
     }
-    JsonObject root = doc.as<JsonObject>();
-    JsonArray records = root["data"].as<JsonArray>();
-    for (JsonObject rec : records)
+    file.close();
+
+    // Keep a partly corrupted file around, it might be manually recoverable
+    if (_envStore.import(env) && ok)
     {
-        env_data dat;
-        dat.humidity = rec["humidity"];
-        dat.temperature = rec["temperature"];
-        dat.timestamp = rec["timestamp"];
-        env.push_back(dat);
+        String migrated = String(_env_data_filename) + ".migrated";
+        SD.rename(_env_data_filename, migrated);
+        Serial.printf("[DataManager] Migrated %u environmental samples.\r\n", (unsigned)env.size());
     }
-    Serial.println("[DataManager] environmental data loaded from SD.");
-    return env;
 }
 
 void DataManager::saveSystemConfig(const SystemConfig &config)
+{
+    _systemConfig = config;
+    _dirty |= DIRTY_SYSTEM_CONFIG;
+}
+
+void DataManager::writeSystemConfig()
 {
     JsonDocument doc;
     JsonObject root = doc.to<JsonObject>();
-    root["sleep_interval_min"] = config.sleep_interval_min;
-    root["sleep_interval_low_batt_min"] = config.sleep_interval_low_batt_min;
-    root["battery_low_threshold_v"] = config.battery_low_threshold_v;
-
-    File file = SD.open(_system_config_filename, FILE_WRITE);
-    if (file)
-    {
-        serializeJsonPretty(doc, file);
-        file.flush();
-        file.close();
-        Serial.println("[DataManager] System Config saved to SD.");
-    }
+    root["sleep_interval_min"] = _systemConfig.sleep_interval_min;
+    root["sleep_interval_low_batt_min"] = _systemConfig.sleep_interval_low_batt_min;
+    root["battery_low_threshold_v"] = _systemConfig.battery_low_threshold_v;
+    writeJson(_system_config_filename, doc, "System Config");
 }
 
-SystemConfig DataManager::getSystemConfig()
+void DataManager::loadSystemConfig()
 {
-    SystemConfig config; // Defaults instantiated
-
-    if (!SD.exists(_system_config_filename))
-    {
-        Serial.println("[DataManager] No System Config found. Creating default.");
-        saveSystemConfig(config);
-        return config;
-    }
-
-    File file = SD.open(_system_config_filename, FILE_READ);
-    if (!file)
-        return config;
+    SystemConfig &config = _systemConfig;
+    config = SystemConfig(); // Defaults instantiated
 
     JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, file);
-    file.close();
-
-    if (error)
+    bool missing;
+    if (!readJson(_system_config_filename, doc, "System Config", &missing))
     {
-        Serial.print("[DataManager] System Config JSON Parse Error: ");
-        Serial.println(error.c_str());
-        return config;
+        if (missing)
+        {
+            Serial.println("[DataManager] No System Config found. Creating default.");
+            _dirty |= DIRTY_SYSTEM_CONFIG;
+        }
+        return;
     }
 
     JsonObject root = doc.as<JsonObject>();
@@ -662,17 +737,22 @@ SystemConfig DataManager::getSystemConfig()
         config.sleep_interval_low_batt_min = root["sleep_interval_low_batt_min"];
     if (root["battery_low_threshold_v"])
         config.battery_low_threshold_v = root["battery_low_threshold_v"];
-
-    return config;
 }
 
 void DataManager::saveLayout(const std::vector<WidgetConfig> &layout)
+{
+    _layoutSource = layout;
+    LayoutCompiler::compile(layout, _layout);
+    _dirty |= DIRTY_LAYOUT;
+}
+
+void DataManager::writeLayout()
 {
     JsonDocument doc;
     JsonObject root = doc.to<JsonObject>();
     JsonArray widgets = root["widgets"].to<JsonArray>();
 
-    for (const auto &w : layout)
+    for (const auto &w : _layoutSource)
     {
         JsonObject obj = widgets.add<JsonObject>();
         obj["type"] = w.type;
@@ -687,86 +767,151 @@ void DataManager::saveLayout(const std::vector<WidgetConfig> &layout)
             obj["title"] = w.title;
         if (w.dataSource.length() > 0)
             obj["dataSource"] = w.dataSource;
+        if (w.decimation.length() > 0)
+            obj["decimation"] = w.decimation;
         obj["min"] = w.min;
         obj["max"] = w.max;
         obj["color"] = w.color;
     
     }
 
-    File file = SD.open(_layout_filename, FILE_WRITE);
-    if (file)
+    // Serialize to RAM first so the compiled cache can be keyed by the exact bytes
+    String json;
+    serializeJsonPretty(doc, json);
+    File file = SdCard::open(_layout_filename, FILE_WRITE);
+    if (!file)
     {
-        serializeJsonPretty(doc, file);
-        file.flush();
-        file.close();
-        Serial.println("[DataManager] Layout saved to SD.");
+        Serial.println("[DataManager] Error saving Layout to SD.");
+        return;
     }
+    file.print(json);
+    file.flush();
+    file.close();
+    Serial.println("[DataManager] Layout saved to SD.");
+
+    _layoutHash = LayoutCompiler::hash((const uint8_t *)json.c_str(), json.length());
+    writeCompiledLayout();
 }
 
-std::vector<WidgetConfig> DataManager::loadLayout()
+bool DataManager::readCompiledLayout(uint32_t hash)
+{
+    File file = SdCard::open(_compiled_layout_filename, FILE_READ);
+    if (!file)
+        return false;
+    CompiledLayoutHeader h;
+    bool ok = file.read((uint8_t *)&h, sizeof(h)) == sizeof(h) &&
+              h.magic == CompiledLayoutFormat::MAGIC && h.version == CompiledLayoutFormat::VERSION &&
+              h.widgetSize == sizeof(CompiledWidget) && h.sourceHash == hash && h.count <= 64;
+    if (ok)
+    {
+        _layout.resize(h.count);
+        ok = file.read((uint8_t *)_layout.data(), h.count * sizeof(CompiledWidget)) == h.count * sizeof(CompiledWidget);
+    }
+    file.close();
+    if (!ok)
+        _layout.clear();
+    return ok;
+}
+
+void DataManager::writeCompiledLayout()
+{
+    CompiledLayoutHeader h = {CompiledLayoutFormat::MAGIC, CompiledLayoutFormat::VERSION, sizeof(CompiledWidget),
+                              _layoutHash, (uint32_t)_layout.size()};
+    File file = SdCard::open(_compiled_layout_filename, FILE_WRITE);
+    if (!file)
+        return;
+    file.write((const uint8_t *)&h, sizeof(h));
+    if (!_layout.empty())
+        file.write((const uint8_t *)_layout.data(), _layout.size() * sizeof(CompiledWidget));
+    file.flush();
+    file.close();
+    Serial.println("[DataManager] Compiled layout cached.");
+}
+
+void DataManager::defaultLayout()
 {
     std::vector<WidgetConfig> layout;
+    if (_status.api_type == PETKIT)
+    {
+        Serial.println("[DataManager] No Layout file. Creating Petkit default.");
+        // Create Default Layout (Based on previous hardcoded values for 800x480)
+        // 1. Scatter Plot
+        layout.push_back(WidgetConfig{"ScatterPlot", 0, 10, 800, 350, 0, 0, "Weight (lb) - %s", "scatter", 0, 0, "", 0xffff});
+
+        // 2. Histograms
+        layout.push_back(WidgetConfig{"Histogram", 0, 360, 300, 120, 0, 0, "Interval (Hours)", "interval", 0, 0, "", 0xffff});
+        layout.push_back(WidgetConfig{"Histogram", 300, 360, 300, 120, 0, 0, "Duration (Minutes)", "duration", 0, 0, "", 0xffff});
 
-    if (!SD.exists(_layout_filename))
+        // 3. Status Widgets
+        layout.push_back(WidgetConfig{"LinearGauge", 725, 2, 59, 22, 0, 0, "", "battery", 0, 100, "%", 0xffff});
+        layout.push_back(WidgetConfig{"TextLabel", 29, 8, 200, 20, 0, 0, "%b %d, %I:%M %p", "datetime", 0, 0, "", 0xffff});
+
+        // Litter Gauge 
+        layout.push_back(WidgetConfig{"LinearGauge", 610, 380, 175, 38, 0, 0, "Litter:", "litter", 0, 100, "%", 0xffff});
+        // status box 
+        layout.push_back(WidgetConfig{"StatusBox", 610, 427, 175, 38, 0, 0, "", "petkit_status", 0, 0, "", 0xffff});
+    }
+    else // whisker
     {
-        if (getStatus().api_type == PETKIT)
-        {
-            Serial.println("[DataManager] No Layout file. Creating Petkit default.");
-            // Create Default Layout (Based on previous hardcoded values for 800x480)
-            // 1. Scatter Plot
-            layout.push_back(WidgetConfig{"ScatterPlot", 0, 10, 800, 350, 0, 0, "Weight (lb) - %s", "scatter", 0, 0, "", 0xffff});
-
-            // 2. Histograms
-            layout.push_back(WidgetConfig{"Histogram", 0, 360, 300, 120, 0, 0, "Interval (Hours)", "interval", 0, 0, "", 0xffff});
-            layout.push_back(WidgetConfig{"Histogram", 300, 360, 300, 120, 0, 0, "Duration (Minutes)", "duration", 0, 0, "", 0xffff});
-
-            // 3. Status Widgets
-            layout.push_back(WidgetConfig{"LinearGauge", 725, 2, 59, 22, 0, 0, "", "battery", 0, 100, "%", 0xffff});
-            layout.push_back(WidgetConfig{"TextLabel", 29, 8, 200, 20, 0, 0, "%b %d, %I:%M %p", "datetime", 0, 0, "", 0xffff});
-
-            // Litter Gauge 
-            layout.push_back(WidgetConfig{"LinearGauge", 610, 380, 175, 38, 0, 0, "Litter:", "litter", 0, 100, "%", 0xffff});
-            // status box 
-            layout.push_back(WidgetConfig{"StatusBox", 610, 427, 175, 38, 0, 0, "", "petkit_status", 0, 0, "", 0xffff});
-        }
-        else // whisker
-        {
-            Serial.println("[DataManager] No Layout file. Creating Whisker default.");
-            // 1. Scatter Plot
-            layout.push_back(WidgetConfig{"ScatterPlot", 0, 10, 800, 200, 0, 0, "Weight (lb) - %s", "scatter", 0, 0, "", 0xffff});
-            layout.push_back(WidgetConfig{"ScatterPlot", 0, 210, 400, 150, 0, 0, "Temperature (C)", "temperature_history", 0, 0, "", 0xffff});
-            layout.push_back(WidgetConfig{"ScatterPlot", 400, 210, 400, 150, 0, 0, "Humidity (%RH)", "humidity_history", 0, 0, "", 0xffff});
+        Serial.println("[DataManager] No Layout file. Creating Whisker default.");
+        // 1. Scatter Plot
+        layout.push_back(WidgetConfig{"ScatterPlot", 0, 10, 800, 200, 0, 0, "Weight (lb) - %s", "scatter", 0, 0, "", 0xffff});
+        layout.push_back(WidgetConfig{"ScatterPlot", 0, 210, 400, 150, 0, 0, "Temperature (C)", "temperature_history", 0, 0, "", 0xffff});
+        layout.push_back(WidgetConfig{"ScatterPlot", 400, 210, 400, 150, 0, 0, "Humidity (%RH)", "humidity_history", 0, 0, "", 0xffff});
 
-            // 2. Histograms
-            layout.push_back(WidgetConfig{"Histogram", 0, 360, 300, 120, 28, 0, "Interval (Hours)", "interval", 0, 0, "", 0xffff});
-            layout.push_back(WidgetConfig{"Histogram", 300, 360, 300, 120, 28, 0, "Weight Change (lb/Month)", "weight_change", 0, 0, "", 0xffff});
+        // 2. Histograms
+        layout.push_back(WidgetConfig{"Histogram", 0, 360, 300, 120, 28, 0, "Interval (Hours)", "interval", 0, 0, "", 0xffff});
+        layout.push_back(WidgetConfig{"Histogram", 300, 360, 300, 120, 28, 0, "Weight Change (lb/Month)", "weight_change", 0, 0, "", 0xffff});
 
-            // 3. Status Widgets
-            layout.push_back(WidgetConfig{"LinearGauge", 725, 2, 59, 22, 0, 0, "", "battery", 0, 100, "%", 0xffff});
-            layout.push_back(WidgetConfig{"TextLabel", 29, 8, 200, 20, 0, 0, "%b %d, %I:%M %p", "datetime", 0, 0, "", 0xffff});
+        // 3. Status Widgets
+        layout.push_back(WidgetConfig{"LinearGauge", 725, 2, 59, 22, 0, 0, "", "battery", 0, 100, "%", 0xffff});
+        layout.push_back(WidgetConfig{"TextLabel", 29, 8, 200, 20, 0, 0, "%b %d, %I:%M %p", "datetime", 0, 0, "", 0xffff});
 
-            // Litter Gauge (Approximate placement for PetKit style)
-            layout.push_back(WidgetConfig{"LinearGauge", 605, 380, 180, 35,0, 0, "Litter: ", "litter", 0, 100, "%", 0xffff});
-            layout.push_back(WidgetConfig{"LinearGauge", 605, 430, 180, 35, 0, 0, "Waste: ", "waste", 0, 100, "%", 0xffff});
+        // Litter Gauge (Approximate placement for PetKit style)
+        layout.push_back(WidgetConfig{"LinearGauge", 605, 380, 180, 35,0, 0, "Litter: ", "litter", 0, 100, "%", 0xffff});
+        layout.push_back(WidgetConfig{"LinearGauge", 605, 430, 180, 35, 0, 0, "Waste: ", "waste", 0, 100, "%", 0xffff});
 
-        }
-        saveLayout(layout);
-        return layout;
     }
+    saveLayout(layout);
+}
 
-    File file = SD.open(_layout_filename, FILE_READ);
-    if (!file)
-        return layout;
+/**
+ * @brief Loads the layout in its compiled form.
+ *
+ * layout.json is read as raw bytes and hashed. If /layout.bin was compiled from the
+ * same bytes it is used directly and the JSON is never parsed; otherwise the JSON is
+ * parsed, compiled, and the cache is rewritten at the next flush().
+ */
+void DataManager::loadLayout()
+{
+    _layout.clear();
 
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, file);
+    File file = SdCard::open(_layout_filename, FILE_READ);
+    if (!file)
+    {
+        defaultLayout();
+        return;
+    }
+    std::vector<char> json(file.size());
+    size_t got = json.empty() ? 0 : file.read((uint8_t *)json.data(), json.size());
     file.close();
+    json.resize(got);
+
+    _layoutHash = LayoutCompiler::hash((const uint8_t *)json.data(), json.size());
+    if (readCompiledLayout(_layoutHash))
+    {
+        Serial.printf("[DataManager] Compiled layout loaded (%u widgets).\r\n", (unsigned)_layout.size());
+        return;
+    }
 
+    JsonDocument doc;
+    DeserializationError error = deserializeJson(doc, (const char *)json.data(), json.size());
     if (error)
     {
+        // A layout with a typo is left alone (and nothing drawn) rather than replaced
         Serial.print("[DataManager] Layout JSON Error: ");
         Serial.println(error.c_str());
-        return layout;
+        return;
     }
 
     JsonArray widgets = doc["widgets"].as<JsonArray>();
@@ -787,12 +932,14 @@ std::vector<WidgetConfig> DataManager::loadLayout()
             w.title = obj["title"].as<String>();
         if (obj["dataSource"])
             w.dataSource = obj["dataSource"].as<String>();
+        if (obj["decimation"])
+            w.decimation = obj["decimation"].as<String>();
         if (obj["min"])
             w.min = obj["min"];
         if (obj["max"])
             w.max = obj["max"];
-        layout.push_back(w);
+        _layout.push_back(LayoutCompiler::compile(w));
     }
-
-    return layout;
+    Serial.printf("[DataManager] Layout compiled (%u widgets).\r\n", (unsigned)_layout.size());
+    _dirty |= DIRTY_COMPILED_LAYOUT;
 }
@@ -0,0 +1,253 @@
+#include "core/EnvRing.h"
+
+// Same batching as RecordLog: a few hundred bytes of stack per transfer
+static constexpr size_t ENV_IO_BATCH = 32;
+
+template <class Record>
+EnvRing<Record>::EnvRing(const char *path, uint32_t capacity) : _path(path), _capacity(capacity)
+{
+    resetHeader();
+}
+
+template <class Record>
+void EnvRing<Record>::resetHeader()
+{
+    memset(&_header, 0, sizeof(_header));
+    _header.magic = EnvRingFormat::MAGIC;
+    _header.version = EnvRingFormat::VERSION;
+    _header.recordSize = sizeof(Record);
+    _header.capacity = _capacity;
+    _headerValid = false;
+}
+
+// Physical slot of the i-th oldest record
+template <class Record>
+uint32_t EnvRing<Record>::slot(uint32_t i) const
+{
+    return (_header.head + _header.capacity - _header.count + i) % _header.capacity;
+}
+
+template <class Record>
+bool EnvRing<Record>::begin()
+{
+    resetHeader();
+    File file = SdCard::open(_path, FILE_READ);
+    if (!file)
+        return false;
+    EnvHeader h;
+    bool ok = file.read((uint8_t *)&h, sizeof(h)) == sizeof(h) &&
+              h.magic == EnvRingFormat::MAGIC && h.version == EnvRingFormat::VERSION &&
+              h.recordSize == sizeof(Record) && h.capacity > 0 &&
+              h.head < h.capacity && h.count <= h.capacity;
+    file.close();
+    if (!ok)
+    {
+        Serial.printf("[EnvRing] Header mismatch, ignoring %s\r\n", _path.c_str());
+        return false;
+    }
+    // A ring created with a different capacity keeps it; the slots are already laid out
+    _header = h;
+    _headerValid = true;
+    return true;
+}
+
+/**
+ * @brief Writes one record into the head slot and advances the header.
+ *
+ * The slot is written before the header, so a power loss in between leaves the
+ * previous state intact. While the ring is filling, the head slot is always at the
+ * end of the file, so the file grows by one record per append.
+ *
+ * @param rec The new record.
+ * @return true on success.
+ */
+template <class Record>
+bool EnvRing<Record>::append(const Record &rec)
+{
+    if (!_headerValid)
+    {
+        resetHeader();
+        File created = SdCard::open(_path, FILE_WRITE);
+        if (!created)
+        {
+            Serial.println("[EnvRing] Failed to create ring file!");
+            return false;
+        }
+        created.write((const uint8_t *)&_header, sizeof(_header));
+        created.close();
+        _headerValid = true;
+    }
+
+    File file = SdCard::open(_path, "r+");
+    if (!file)
+    {
+        Serial.println("[EnvRing] Failed to open ring for append!");
+        return false;
+    }
+    if (!file.seek(sizeof(EnvHeader) + (size_t)_header.head * sizeof(Record)) ||
+        file.write((const uint8_t *)&rec, sizeof(rec)) != sizeof(rec))
+    {
+        Serial.println("[EnvRing] Slot write failed, header left unchanged.");
+        file.close();
+        return false;
+    }
+    file.flush();
+
+    _header.head = (_header.head + 1) % _header.capacity;
+    if (_header.count < _header.capacity)
+        _header.count++;
+    file.seek(0);
+    file.write((const uint8_t *)&_header, sizeof(_header));
+    file.flush();
+    file.close();
+    return true;
+}
+
+template <class Record>
+bool EnvRing<Record>::last(Record &rec)
+{
+    if (!_headerValid || _header.count == 0)
+        return false;
+    File file = SdCard::open(_path, FILE_READ);
+    if (!file)
+        return false;
+    bool ok = file.seek(sizeof(EnvHeader) + (size_t)slot(_header.count - 1) * sizeof(Record)) &&
+              file.read((uint8_t *)&rec, sizeof(rec)) == sizeof(rec);
+    file.close();
+    return ok;
+}
+
+template <class Record>
+bool EnvRing<Record>::replaceLast(const Record &rec)
+{
+    if (!_headerValid || _header.count == 0)
+        return false;
+    File file = SdCard::open(_path, "r+");
+    if (!file)
+        return false;
+    bool ok = file.seek(sizeof(EnvHeader) + (size_t)slot(_header.count - 1) * sizeof(Record)) &&
+              file.write((const uint8_t *)&rec, sizeof(rec)) == sizeof(rec);
+    file.flush();
+    file.close();
+    return ok;
+}
+
+/**
+ * @brief Rewrites the ring from a list of records.
+ *
+ * Used for migrations. Only the newest capacity records are kept; they are laid out
+ * from slot 0 so head ends up right after the newest one.
+ *
+ * @param records Records in chronological order.
+ * @return true on success.
+ */
+template <class Record>
+bool EnvRing<Record>::import(const std::vector<Record> &records)
+{
+    resetHeader();
+    size_t first = records.size() > _capacity ? records.size() - _capacity : 0;
+    _header.count = records.size() - first;
+    _header.head = _header.count % _header.capacity;
+
+    File file = SdCard::open(_path, FILE_WRITE);
+    if (!file)
+    {
+        Serial.println("[EnvRing] Failed to create ring file!");
+        return false;
+    }
+    file.write((const uint8_t *)&_header, sizeof(_header));
+    size_t bytes = _header.count * sizeof(Record);
+    size_t written = bytes > 0 ? file.write((const uint8_t *)(records.data() + first), bytes) : 0;
+    file.flush();
+    file.close();
+
+    if (written != bytes)
+    {
+        Serial.println("[EnvRing] Import write incomplete!");
+        SD.remove(_path);
+        resetHeader();
+        return false;
+    }
+    _headerValid = true;
+    Serial.printf("[EnvRing] Imported %u records into %s\r\n", _header.count, _path.c_str());
+    return true;
+}
+
+template <class Record>
+bool EnvRing<Record>::readTimestamp(File &file, uint32_t i, uint32_t &ts)
+{
+    return file.seek(sizeof(EnvHeader) + (size_t)slot(i) * sizeof(Record)) &&
+           file.read((uint8_t *)&ts, sizeof(ts)) == sizeof(ts);
+}
+
+/**
+ * @brief Reads the records inside a time window.
+ *
+ * Records are in chronological order around the ring, so the start of the window is
+ * found by binary search over the timestamps (a handful of 4-byte reads) and only
+ * the window itself is streamed, in at most two contiguous runs.
+ *
+ * @param from Start of the window (inclusive).
+ * @param to End of the window (exclusive).
+ * @param out Receives the records, oldest first.
+ */
+template <class Record>
+void EnvRing<Record>::read(time_t from, time_t to, std::vector<Record> &out)
+{
+    out.clear();
+    if (!_headerValid || _header.count == 0)
+        return;
+    File file = SdCard::open(_path, FILE_READ);
+    if (!file)
+        return;
+
+    uint32_t lo = 0, hi = _header.count;
+    while (lo < hi)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+        uint32_t ts;
+        if (!readTimestamp(file, mid, ts))
+        {
+            file.close();
+            return;
+        }
+        if ((time_t)ts < from)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    out.reserve(_header.count - lo);
+    Record batch[ENV_IO_BATCH];
+    uint32_t i = lo;
+    while (i < _header.count)
+    {
+        uint32_t s = slot(i);
+        uint32_t n = _header.count - i;
+        if (n > ENV_IO_BATCH)
+            n = ENV_IO_BATCH;
+        if (n > _header.capacity - s)
+            n = _header.capacity - s; // stop at the physical end, continue from slot 0
+        if (!file.seek(sizeof(EnvHeader) + (size_t)s * sizeof(Record)) ||
+            file.read((uint8_t *)batch, n * sizeof(Record)) != n * sizeof(Record))
+        {
+            Serial.println("[EnvRing] Ring shorter than header count.");
+            break;
+        }
+        for (uint32_t k = 0; k < n; k++)
+        {
+            if ((time_t)batch[k].timestamp >= to)
+            {
+                i = _header.count;
+                break;
+            }
+            out.push_back(batch[k]);
+        }
+        if (i < _header.count)
+            i += n;
+    }
+    file.close();
+}
+
+template class EnvRing<EnvRecord>;
+template class EnvRing<EnvAggregate>;
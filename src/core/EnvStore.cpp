@@ -0,0 +1,207 @@
+#include "core/EnvStore.h"
+#include "core/RecordLog.h"
+
+struct EnvTierInfo
+{
+    uint32_t bucketSeconds; // 0 for raw samples
+    long retentionSeconds;
+    uint32_t capacity;
+};
+
+// Raw capacity allows a sample every 5 minutes for a week; the aggregate rings hold
+// exactly one bucket per hour/day of their retention.
+static constexpr EnvTierInfo ENV_TIERS[ENV_TIER_COUNT] = {
+    {0, 7 * 86400L, 2016},
+    {3600, 90 * 86400L, 90 * 24},
+    {86400, 366 * 86400L, 366},
+};
+
+EnvStore::EnvStore()
+    : _raw("/env_data.bin", ENV_TIERS[ENV_TIER_RAW].capacity),
+      _hourly("/env_hourly.bin", ENV_TIERS[ENV_TIER_HOURLY].capacity),
+      _daily("/env_daily.bin", ENV_TIERS[ENV_TIER_DAILY].capacity)
+{
+}
+
+bool EnvStore::begin()
+{
+    bool haveRaw = _raw.begin();
+    bool haveHourly = _hourly.begin();
+    bool haveDaily = _daily.begin();
+    if (!haveRaw)
+        return false;
+
+    if (!haveHourly || !haveDaily)
+    {
+        // Rings written before the tiers existed: seed them from what the raw ring holds
+        Serial.println("[EnvStore] Rebuilding aggregate tiers from raw samples.");
+        std::vector<EnvRecord> raw;
+        _raw.read(0, RecordLogFormat::END_OF_TIME, raw);
+        std::vector<env_data> samples;
+        samples.reserve(raw.size());
+        for (const auto &r : raw)
+            samples.push_back({r.temperature, r.humidity, (time_t)r.timestamp});
+        rebuildTiers(samples);
+    }
+    return true;
+}
+
+void EnvStore::startBucket(EnvAggregate &agg, uint32_t bucket, const env_data &sample)
+{
+    agg.timestamp = bucket;
+    agg.count = 1;
+    agg.reserved = 0;
+    agg.tempMin = agg.tempMean = agg.tempMax = sample.temperature;
+    agg.humidMin = agg.humidMean = agg.humidMax = sample.humidity;
+}
+
+void EnvStore::accumulate(EnvAggregate &agg, const env_data &sample)
+{
+    agg.count++;
+    agg.tempMean += (sample.temperature - agg.tempMean) / agg.count;
+    agg.humidMean += (sample.humidity - agg.humidMean) / agg.count;
+    if (sample.temperature < agg.tempMin)
+        agg.tempMin = sample.temperature;
+    if (sample.temperature > agg.tempMax)
+        agg.tempMax = sample.temperature;
+    if (sample.humidity < agg.humidMin)
+        agg.humidMin = sample.humidity;
+    if (sample.humidity > agg.humidMax)
+        agg.humidMax = sample.humidity;
+}
+
+/**
+ * @brief Folds a sample into the newest bucket of an aggregate ring.
+ *
+ * If the sample falls into the bucket already at the head it is updated in place,
+ * otherwise a new bucket is appended. Either way a single slot is written.
+ */
+bool EnvStore::addToTier(EnvRing<EnvAggregate> &ring, uint32_t bucketSeconds, const env_data &sample)
+{
+    uint32_t ts = (uint32_t)sample.timestamp;
+    uint32_t bucket = ts - ts % bucketSeconds;
+
+    EnvAggregate agg;
+    if (ring.last(agg))
+    {
+        if (agg.timestamp == bucket)
+        {
+            accumulate(agg, sample);
+            return ring.replaceLast(agg);
+        }
+        if (agg.timestamp > bucket)
+        {
+            // The clock went backwards; keep the ring in time order
+            Serial.println("[EnvStore] Sample older than newest bucket, skipped.");
+            return false;
+        }
+    }
+    startBucket(agg, bucket, sample);
+    return ring.append(agg);
+}
+
+/**
+ * @brief Records a sample in the raw ring and folds it into the aggregate tiers.
+ *
+ * EnvRing::read() binary-searches timestamps, so a sample older than the newest raw
+ * record (the clock went backwards) is skipped entirely rather than stored out of
+ * order.
+ */
+bool EnvStore::append(const env_data &sample)
+{
+    EnvRecord rec = {(uint32_t)sample.timestamp, sample.temperature, sample.humidity};
+    EnvRecord newest;
+    if (_raw.last(newest) && newest.timestamp > rec.timestamp)
+    {
+        Serial.println("[EnvStore] Sample older than newest bucket, skipped.");
+        return false;
+    }
+    bool ok = _raw.append(rec);
+    ok &= addToTier(_hourly, ENV_TIERS[ENV_TIER_HOURLY].bucketSeconds, sample);
+    ok &= addToTier(_daily, ENV_TIERS[ENV_TIER_DAILY].bucketSeconds, sample);
+    return ok;
+}
+
+bool EnvStore::rebuildTiers(const std::vector<env_data> &samples)
+{
+    bool ok = true;
+    for (int t = ENV_TIER_HOURLY; t < ENV_TIER_COUNT; t++)
+    {
+        uint32_t bucketSeconds = ENV_TIERS[t].bucketSeconds;
+        std::vector<EnvAggregate> buckets;
+        for (const auto &s : samples)
+        {
+            uint32_t ts = (uint32_t)s.timestamp;
+            uint32_t bucket = ts - ts % bucketSeconds;
+            if (!buckets.empty() && buckets.back().timestamp == bucket)
+            {
+                accumulate(buckets.back(), s);
+            }
+            else if (buckets.empty() || buckets.back().timestamp < bucket)
+            {
+                buckets.emplace_back();
+                startBucket(buckets.back(), bucket, s);
+            }
+        }
+        ok &= (t == ENV_TIER_HOURLY ? _hourly : _daily).import(buckets);
+    }
+    return ok;
+}
+
+bool EnvStore::import(const std::vector<env_data> &samples)
+{
+    std::vector<EnvRecord> raw;
+    raw.reserve(samples.size());
+    for (const auto &s : samples)
+        raw.push_back({(uint32_t)s.timestamp, s.temperature, s.humidity});
+    bool ok = _raw.import(raw);
+    ok &= rebuildTiers(samples);
+    return ok;
+}
+
+bool EnvStore::latest(env_data &sample)
+{
+    EnvRecord rec;
+    if (!_raw.last(rec))
+        return false;
+    sample.temperature = rec.temperature;
+    sample.humidity = rec.humidity;
+    sample.timestamp = rec.timestamp;
+    return true;
+}
+
+void EnvStore::read(EnvTier tier, time_t from, std::vector<EnvAggregate> &out)
+{
+    if (tier == ENV_TIER_HOURLY || tier == ENV_TIER_DAILY)
+    {
+        (tier == ENV_TIER_HOURLY ? _hourly : _daily).read(from, RecordLogFormat::END_OF_TIME, out);
+        return;
+    }
+
+    std::vector<EnvRecord> raw;
+    _raw.read(from, RecordLogFormat::END_OF_TIME, raw);
+    out.clear();
+    out.reserve(raw.size());
+    for (const auto &r : raw)
+    {
+        EnvAggregate agg;
+        startBucket(agg, r.timestamp, {r.temperature, r.humidity, (time_t)r.timestamp});
+        out.push_back(agg);
+    }
+}
+
+EnvTier EnvStore::selectTier(long rangeSeconds, int pixels)
+{
+    // Walk from coarse to fine; a finer tier is only worth it if the coarser one
+    // would leave pixels empty, and only possible if it reaches back far enough.
+    EnvTier best = ENV_TIER_DAILY;
+    for (int t = ENV_TIER_DAILY; t >= ENV_TIER_RAW; t--)
+    {
+        if (ENV_TIERS[t].retentionSeconds < rangeSeconds && t != ENV_TIER_DAILY)
+            break;
+        best = (EnvTier)t;
+        if (ENV_TIERS[t].bucketSeconds > 0 && rangeSeconds / (long)ENV_TIERS[t].bucketSeconds >= pixels)
+            break;
+    }
+    return best;
+}
@@ -0,0 +1,256 @@
+#include "core/PetDataStore.h"
+#include <algorithm>
+
+static bool recordTimeLess(const SL_Record &a, const SL_Record &b)
+{
+    return a.timestamp < b.timestamp;
+}
+
+SL_Record PetSeries::record(size_t i, int petId) const
+{
+    SL_Record rec;
+    rec.timestamp = (time_t)_ts[i];
+    rec.weight_lbs = _weight[i];
+    rec.duration_seconds = _duration[i];
+    rec.PetId = petId;
+    return rec;
+}
+
+size_t PetSeries::lowerBound(time_t ts) const
+{
+    if (ts <= 0)
+        return 0;
+    return std::lower_bound(_ts.begin(), _ts.end(), (uint32_t)ts) - _ts.begin();
+}
+
+size_t PetSeries::upperBound(time_t ts) const
+{
+    if (ts < 0)
+        return 0;
+    return std::upper_bound(_ts.begin(), _ts.end(), (uint32_t)ts) - _ts.begin();
+}
+
+void PetSeries::reserve(size_t n)
+{
+    _ts.reserve(n);
+    _weight.reserve(n);
+    _duration.reserve(n);
+}
+
+bool PetSeries::sameValues(size_t i, const SL_Record &rec) const
+{
+    return _weight[i] == (float)rec.weight_lbs && _duration[i] == (float)rec.duration_seconds;
+}
+
+bool PetSeries::insert(const SL_Record &rec)
+{
+    uint32_t t = (uint32_t)rec.timestamp;
+    if (_ts.empty() || t > _ts.back())
+    {
+        _ts.push_back(t);
+        _weight.push_back((float)rec.weight_lbs);
+        _duration.push_back((float)rec.duration_seconds);
+        return true;
+    }
+
+    size_t i = lowerBound(rec.timestamp);
+    if (i < _ts.size() && _ts[i] == t)
+    {
+        if (sameValues(i, rec))
+            return false;
+        _weight[i] = (float)rec.weight_lbs;
+        _duration[i] = (float)rec.duration_seconds;
+        return true;
+    }
+    _ts.insert(_ts.begin() + i, t);
+    _weight.insert(_weight.begin() + i, (float)rec.weight_lbs);
+    _duration.insert(_duration.begin() + i, (float)rec.duration_seconds);
+    return true;
+}
+
+/**
+ * @brief Merges a batch of records into the sorted columns.
+ *
+ * Equal timestamps are updated in place in a first pass, which also counts how many
+ * slots the new records need. The columns are then grown once and the remaining
+ * records are merged in from the back, so no element moves more than once.
+ *
+ * @param batch Records from the API, in any order. For duplicate timestamps within
+ *              the batch the last one wins.
+ * @param petId Stamped onto the records reported in changed.
+ * @param changed Optional output of the records that were new or changed.
+ */
+void PetSeries::merge(const std::vector<SL_Record> &batch, int petId, std::vector<SL_Record> *changed)
+{
+    if (batch.empty())
+        return;
+
+    // API batches are usually already in order; only sort a copy when they are not
+    std::vector<SL_Record> sortedCopy;
+    const std::vector<SL_Record> *in = &batch;
+    if (!std::is_sorted(batch.begin(), batch.end(), recordTimeLess))
+    {
+        sortedCopy = batch;
+        std::stable_sort(sortedCopy.begin(), sortedCopy.end(), recordTimeLess);
+        in = &sortedCopy;
+    }
+    const std::vector<SL_Record> &b = *in;
+
+    // Pass 1: update existing timestamps, count new ones
+    const size_t n = _ts.size();
+    size_t added = 0;
+    size_t i = 0;
+    for (size_t j = 0; j < b.size(); j++)
+    {
+        uint32_t t = (uint32_t)b[j].timestamp;
+        if (j + 1 < b.size() && (uint32_t)b[j + 1].timestamp == t)
+            continue; // a later duplicate in the batch wins
+        i = std::lower_bound(_ts.begin() + i, _ts.begin() + n, t) - _ts.begin();
+        if (i < n && _ts[i] == t)
+        {
+            if (!sameValues(i, b[j]))
+            {
+                _weight[i] = (float)b[j].weight_lbs;
+                _duration[i] = (float)b[j].duration_seconds;
+                if (changed)
+                {
+                    changed->push_back(b[j]);
+                    changed->back().PetId = petId;
+                }
+            }
+        }
+        else
+        {
+            added++;
+        }
+    }
+    if (added == 0)
+        return;
+
+    // Pass 2: grow once and merge new records in from the back
+    _ts.resize(n + added);
+    _weight.resize(n + added);
+    _duration.resize(n + added);
+
+    size_t w = n + added; // write position (exclusive)
+    size_t a = n;         // unread existing elements
+    bool havePrev = false;
+    uint32_t prevT = 0;
+    for (size_t j = b.size(); j > 0; j--)
+    {
+        const SL_Record &r = b[j - 1];
+        uint32_t t = (uint32_t)r.timestamp;
+        if (havePrev && t == prevT)
+            continue; // earlier duplicate of a record already handled
+        havePrev = true;
+        prevT = t;
+
+        while (a > 0 && _ts[a - 1] > t)
+        {
+            a--;
+            w--;
+            _ts[w] = _ts[a];
+            _weight[w] = _weight[a];
+            _duration[w] = _duration[a];
+        }
+        if (a > 0 && _ts[a - 1] == t)
+            continue; // existing record, updated in pass 1
+
+        w--;
+        _ts[w] = t;
+        _weight[w] = (float)r.weight_lbs;
+        _duration[w] = (float)r.duration_seconds;
+        if (changed)
+        {
+            changed->push_back(r);
+            changed->back().PetId = petId;
+        }
+    }
+}
+
+size_t PetSeries::dayLowerBound(int32_t d) const
+{
+    return std::lower_bound(_days.begin(), _days.end(), d,
+                            [](const DailyRollup &r, int32_t k) { return r.day < k; }) -
+           _days.begin();
+}
+
+/**
+ * @brief Aggregates raw visits into daily rollups in a single pass.
+ *
+ * A visit's interval is counted on the day of the later visit. The first visit in
+ * the range has no interval, so rebuilding a month never depends on whether the
+ * previous month happens to be in memory.
+ *
+ * @param from Start of the range (inclusive).
+ * @param to End of the range (exclusive).
+ * @param out Receives one rollup per day that has at least one visit.
+ */
+void PetSeries::buildRollups(time_t from, time_t to, std::vector<DailyRollup> &out) const
+{
+    out.clear();
+    size_t first = lowerBound(from);
+    size_t last = lowerBound(to);
+    for (size_t i = first; i < last; i++)
+    {
+        int32_t d = dayOf(_ts[i]);
+        if (out.empty() || out.back().day != d)
+        {
+            DailyRollup r = {};
+            r.day = d;
+            r.minWeight = _weight[i];
+            r.maxWeight = _weight[i];
+            out.push_back(r);
+        }
+        DailyRollup &r = out.back();
+        r.count++;
+        r.sumWeight += _weight[i];
+        if (_weight[i] < r.minWeight)
+            r.minWeight = _weight[i];
+        if (_weight[i] > r.maxWeight)
+            r.maxWeight = _weight[i];
+        if (_duration[i] > 0.0f)
+        {
+            r.durationCount++;
+            r.totalDuration += _duration[i];
+        }
+        if (i > first)
+        {
+            r.intervalCount++;
+            r.intervalSum += (float)(_ts[i] - _ts[i - 1]);
+        }
+    }
+}
+
+void PetSeries::replaceRollups(int32_t fromDay, int32_t toDay, const std::vector<DailyRollup> &days)
+{
+    size_t lo = dayLowerBound(fromDay);
+    size_t hi = dayLowerBound(toDay);
+    _days.erase(_days.begin() + lo, _days.begin() + hi);
+    _days.insert(_days.begin() + lo, days.begin(), days.end());
+}
+
+const PetSeries *PetDataStore::find(int petId) const
+{
+    auto it = _pets.find(petId);
+    return it == _pets.end() ? nullptr : &it->second;
+}
+
+size_t PetDataStore::totalRecords() const
+{
+    size_t total = 0;
+    for (auto const &petPair : _pets)
+        total += petPair.second.size();
+    return total;
+}
+
+time_t PetDataStore::latestTimestamp() const
+{
+    time_t latest = 0;
+    for (auto const &petPair : _pets)
+    {
+        if (petPair.second.latest() > latest)
+            latest = petPair.second.latest();
+    }
+    return latest;
+}
@@ -0,0 +1,348 @@
+#include "core/RecordLog.h"
+
+// Records are read and written in small batches to keep SPI transfers efficient
+// without holding more than a few hundred bytes of scratch on the stack.
+static constexpr size_t LOG_IO_BATCH = 32;
+
+RecordLog::RecordLog(const char *path) : _path(path), _tmpPath(String(path) + ".tmp")
+{
+    resetHeader();
+}
+
+void RecordLog::resetHeader()
+{
+    memset(&_header, 0, sizeof(_header));
+    _header.magic = RecordLogFormat::MAGIC;
+    _header.version = RecordLogFormat::VERSION;
+    _header.recordSize = sizeof(LogRecord);
+    _header.recordCount = 0;
+    _headerValid = false;
+}
+
+bool RecordLog::exists()
+{
+    // Scenario: power failed after deleting the log but before renaming the compacted .tmp
+    if (!SD.exists(_path) && SD.exists(_tmpPath))
+    {
+        Serial.println("[RecordLog] Detected failed compaction. Recovering from temp file...");
+        if (SD.rename(_tmpPath, _path))
+            Serial.println("[RecordLog] Recovery successful!");
+        else
+            Serial.println("[RecordLog] Recovery rename failed.");
+    }
+    return SD.exists(_path);
+}
+
+bool RecordLog::readHeader(File &file)
+{
+    LogHeader h;
+    if (file.read((uint8_t *)&h, sizeof(h)) != sizeof(h))
+        return false;
+    if (h.magic != RecordLogFormat::MAGIC || h.version != RecordLogFormat::VERSION || h.recordSize != sizeof(LogRecord))
+    {
+        Serial.println("[RecordLog] Header mismatch, ignoring log.");
+        return false;
+    }
+    _header = h;
+    _headerValid = true;
+    return true;
+}
+
+void RecordLog::notePet(int32_t petId, uint32_t ts)
+{
+    int freeSlot = -1;
+    for (int i = 0; i < RecordLogFormat::MAX_PETS; i++)
+    {
+        LogPetEntry &e = _header.pets[i];
+        if (e.petId == petId && e.latestTs != 0)
+        {
+            if (ts > e.latestTs)
+                e.latestTs = ts;
+            return;
+        }
+        if (freeSlot < 0 && e.latestTs == 0)
+            freeSlot = i;
+    }
+    if (freeSlot >= 0)
+    {
+        _header.pets[freeSlot].petId = petId;
+        _header.pets[freeSlot].latestTs = ts;
+    }
+}
+
+time_t RecordLog::latestTimestamp(int petId) const
+{
+    for (int i = 0; i < RecordLogFormat::MAX_PETS; i++)
+    {
+        if (_header.pets[i].petId == petId && _header.pets[i].latestTs != 0)
+            return (time_t)_header.pets[i].latestTs;
+    }
+    return 0;
+}
+
+void RecordLog::toLogRecord(const SL_Record &rec, int petId, LogRecord &out)
+{
+    out.petId = petId;
+    out.timestamp = (uint32_t)rec.timestamp;
+    out.weight_lbs = (float)rec.weight_lbs;
+    out.duration_s = (float)rec.duration_seconds;
+}
+
+/**
+ * @brief Loads all records from the binary log into the store.
+ *
+ * Only header.recordCount records are read; any trailing bytes left behind by an
+ * interrupted append are ignored.
+ *
+ * @param petData Store to populate.
+ * @return true if a valid log was read.
+ */
+bool RecordLog::load(PetDataStore &petData)
+{
+    File file = SdCard::open(_path, FILE_READ);
+    if (!file)
+        return false;
+    if (!readHeader(file))
+    {
+        file.close();
+        resetHeader();
+        return false;
+    }
+
+    // Collect per pet and merge once, so loading an older log into a store that
+    // already holds newer data does not shift the columns for every record.
+    std::map<int, std::vector<SL_Record>> perPet;
+    LogRecord batch[LOG_IO_BATCH];
+    uint32_t remaining = _header.recordCount;
+    while (remaining > 0)
+    {
+        size_t n = remaining < LOG_IO_BATCH ? remaining : LOG_IO_BATCH;
+        size_t got = file.read((uint8_t *)batch, n * sizeof(LogRecord)) / sizeof(LogRecord);
+        for (size_t i = 0; i < got; i++)
+        {
+            SL_Record rec;
+            rec.timestamp = batch[i].timestamp;
+            rec.weight_lbs = batch[i].weight_lbs;
+            rec.duration_seconds = batch[i].duration_s;
+            rec.PetId = batch[i].petId;
+            perPet[batch[i].petId].push_back(rec);
+        }
+        if (got < n)
+        {
+            Serial.println("[RecordLog] Log shorter than header count, truncating.");
+            _header.recordCount -= (remaining - got);
+            break;
+        }
+        remaining -= n;
+    }
+    file.close();
+    for (auto const &petPair : perPet)
+        petData.pet(petPair.first).merge(petPair.second, petPair.first, nullptr);
+    Serial.printf("[RecordLog] Loaded %u records from %s\r\n", _header.recordCount, _path.c_str());
+    return true;
+}
+
+bool RecordLog::loadHeader()
+{
+    File file = SdCard::open(_path, FILE_READ);
+    if (!file)
+        return false;
+    bool ok = readHeader(file);
+    file.close();
+    if (!ok)
+        resetHeader();
+    return ok;
+}
+
+time_t RecordLog::latestTimestamp() const
+{
+    uint32_t latest = 0;
+    for (int i = 0; i < RecordLogFormat::MAX_PETS; i++)
+    {
+        if (_header.pets[i].latestTs > latest)
+            latest = _header.pets[i].latestTs;
+    }
+    return (time_t)latest;
+}
+
+/**
+ * @brief Appends records to the end of the log.
+ *
+ * Records are written first and the header (count, per-pet latest timestamp) last,
+ * so a power loss mid-append never exposes a partially written record.
+ *
+ * @param records The new records (PetId must be set).
+ * @return true on success.
+ */
+bool RecordLog::append(const std::vector<SL_Record> &records)
+{
+    if (records.empty())
+        return true;
+
+    if (!_headerValid)
+    {
+        if (!loadHeader())
+        {
+            // Start a fresh log
+            resetHeader();
+            File created = SdCard::open(_path, FILE_WRITE);
+            if (!created)
+            {
+                Serial.println("[RecordLog] Failed to create log file!");
+                return false;
+            }
+            created.write((const uint8_t *)&_header, sizeof(_header));
+            created.close();
+            _headerValid = true;
+        }
+    }
+
+    File file = SdCard::open(_path, "r+");
+    if (!file)
+    {
+        Serial.println("[RecordLog] Failed to open log for append!");
+        return false;
+    }
+    if (!file.seek(sizeof(LogHeader) + (size_t)_header.recordCount * sizeof(LogRecord)))
+    {
+        Serial.println("[RecordLog] Seek failed!");
+        file.close();
+        return false;
+    }
+
+    LogRecord batch[LOG_IO_BATCH];
+    size_t n = 0;
+    uint32_t written = 0;
+    for (const auto &rec : records)
+    {
+        toLogRecord(rec, rec.PetId, batch[n++]);
+        if (n == LOG_IO_BATCH)
+        {
+            if (file.write((const uint8_t *)batch, n * sizeof(LogRecord)) != n * sizeof(LogRecord))
+                break;
+            written += n;
+            n = 0;
+        }
+    }
+    if (n > 0 && file.write((const uint8_t *)batch, n * sizeof(LogRecord)) == n * sizeof(LogRecord))
+        written += n;
+    file.flush();
+
+    if (written != records.size())
+    {
+        Serial.println("[RecordLog] Short write, header left unchanged.");
+        file.close();
+        return false;
+    }
+
+    for (const auto &rec : records)
+        notePet(rec.PetId, (uint32_t)rec.timestamp);
+    _header.recordCount += written;
+
+    file.seek(0);
+    file.write((const uint8_t *)&_header, sizeof(_header));
+    file.flush();
+    file.close();
+    Serial.printf("[RecordLog] Appended %u records (%u total).\r\n", written, _header.recordCount);
+    return true;
+}
+
+/**
+ * @brief Rewrites the log from the store records in [from, to).
+ *
+ * Uses the same temp-file-then-rename scheme as the legacy JSON save; exists()
+ * recovers the temp file if power is lost between remove and rename.
+ *
+ * @param petData The data set (must hold everything this log covers).
+ * @param from Records older than this are dropped.
+ * @param to Records at or after this belong elsewhere and are skipped.
+ * @return true on success.
+ */
+bool RecordLog::compact(const PetDataStore &petData, time_t from, time_t to)
+{
+    if (SD.exists(_tmpPath))
+        SD.remove(_tmpPath);
+
+    LogHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = RecordLogFormat::MAGIC;
+    header.version = RecordLogFormat::VERSION;
+    header.recordSize = sizeof(LogRecord);
+
+    // Build header first so it can be written up front
+    _header = header;
+    for (auto const &petPair : petData)
+    {
+        const PetSeries &series = petPair.second;
+        size_t first = series.lowerBound(from);
+        size_t last = series.lowerBound(to);
+        if (first == last)
+            continue;
+        _header.recordCount += last - first;
+        notePet(petPair.first, (uint32_t)series.timestamp(last - 1));
+    }
+    header = _header;
+
+    File file = SdCard::open(_tmpPath, FILE_WRITE);
+    if (!file)
+    {
+        Serial.println("[RecordLog] Failed to open temp file for compaction!");
+        _headerValid = false;
+        return false;
+    }
+    file.write((const uint8_t *)&header, sizeof(header));
+
+    LogRecord batch[LOG_IO_BATCH];
+    size_t n = 0;
+    uint32_t written = 0;
+    for (auto const &petPair : petData)
+    {
+        const PetSeries &series = petPair.second;
+        size_t last = series.lowerBound(to);
+        for (size_t i = series.lowerBound(from); i < last; i++)
+        {
+            toLogRecord(series.record(i, petPair.first), petPair.first, batch[n++]);
+            if (n == LOG_IO_BATCH)
+            {
+                written += file.write((const uint8_t *)batch, n * sizeof(LogRecord)) / sizeof(LogRecord);
+                n = 0;
+            }
+        }
+    }
+    if (n > 0)
+        written += file.write((const uint8_t *)batch, n * sizeof(LogRecord)) / sizeof(LogRecord);
+    file.flush();
+    file.close();
+
+    if (written != header.recordCount)
+    {
+        Serial.println("[RecordLog] Compaction write incomplete. Aborting.");
+        SD.remove(_tmpPath);
+        _headerValid = false;
+        return false;
+    }
+
+    // If crash here (after remove, before rename), exists() recovers the temp file.
+    if (SD.exists(_path))
+        SD.remove(_path);
+    if (!SD.rename(_tmpPath, _path))
+    {
+        Serial.println("[RecordLog] Rename failed!");
+        _headerValid = false;
+        return false;
+    }
+    _headerValid = true;
+    Serial.printf("[RecordLog] Compacted log to %u records.\r\n", header.recordCount);
+    return true;
+}
+
+bool RecordLog::rename(const String &newPath)
+{
+    if (!SD.exists(_path))
+        return false;
+    if (SD.exists(newPath))
+        SD.remove(newPath);
+    bool ok = SD.rename(_path, newPath);
+    resetHeader();
+    return ok;
+}
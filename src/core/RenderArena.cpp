@@ -0,0 +1,101 @@
+#include "core/RenderArena.h"
+
+// Every block starts on this boundary, enough for any type the render stores
+static constexpr size_t ARENA_ALIGN = 8;
+
+static uint8_t *s_base = nullptr;
+static size_t s_capacity = 0;
+static size_t s_used = 0;
+static size_t s_peak = 0;
+static uint32_t s_live = 0;
+static uint32_t s_overflows = 0;
+
+bool RenderArena::begin(size_t capacity)
+{
+    if (s_base)
+        return true;
+    s_base = (uint8_t *)heap_caps_malloc(capacity, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!s_base)
+    {
+        Serial.printf("[RenderArena] Could not reserve %u bytes of PSRAM, using the heap.\r\n", (unsigned)capacity);
+        return false;
+    }
+    s_capacity = capacity;
+    reset();
+    Serial.printf("[RenderArena] Reserved %u bytes of PSRAM.\r\n", (unsigned)capacity);
+    return true;
+}
+
+/**
+ * @brief Hands out the next aligned slice of the block.
+ *
+ * When the block is full (or was never reserved) the request goes to PSRAM through
+ * heap_caps_malloc, then to the regular heap, like PsramAllocator does.
+ */
+void *RenderArena::allocate(size_t bytes)
+{
+    size_t size = (bytes + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+    if (s_base && size <= s_capacity - s_used)
+    {
+        void *p = s_base + s_used;
+        s_used += size;
+        if (s_used > s_peak)
+            s_peak = s_used;
+        s_live++;
+        return p;
+    }
+    s_overflows++;
+    void *p = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!p)
+        p = malloc(bytes);
+    return p;
+}
+
+void RenderArena::deallocate(void *p)
+{
+    if (!p)
+        return;
+    if (owns(p))
+    {
+        // Freed with the whole block in reset()
+        if (s_live > 0)
+            s_live--;
+        return;
+    }
+    free(p);
+}
+
+void RenderArena::reset()
+{
+    if (s_live > 0)
+        Serial.printf("[RenderArena] Reset with %u allocations still live!\r\n", (unsigned)s_live);
+    s_used = 0;
+    s_peak = 0;
+    s_live = 0;
+    s_overflows = 0;
+}
+
+bool RenderArena::owns(const void *p)
+{
+    return s_base && (const uint8_t *)p >= s_base && (const uint8_t *)p < s_base + s_capacity;
+}
+
+size_t RenderArena::used() { return s_used; }
+size_t RenderArena::peak() { return s_peak; }
+size_t RenderArena::capacity() { return s_capacity; }
+uint32_t RenderArena::overflows() { return s_overflows; }
+
+static void logRegion(const char *when, const char *name, uint32_t caps)
+{
+    size_t freeBytes = heap_caps_get_free_size(caps);
+    size_t largest = heap_caps_get_largest_free_block(caps);
+    unsigned fragmentation = freeBytes ? (unsigned)(100 - (uint64_t)largest * 100 / freeBytes) : 0;
+    Serial.printf("[RenderArena] %s: %s free %u, largest block %u (%u%% fragmented)\r\n",
+                  when, name, (unsigned)freeBytes, (unsigned)largest, fragmentation);
+}
+
+void RenderArena::logHeap(const char *when)
+{
+    logRegion(when, "internal", MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    logRegion(when, "PSRAM", MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+}
@@ -0,0 +1,14 @@
+#include "core/SdCard.h"
+
+static uint32_t s_openCount = 0;
+
+File SdCard::open(const char *path, const char *mode)
+{
+    s_openCount++;
+    return SD.open(path, mode);
+}
+
+uint32_t SdCard::openCount()
+{
+    return s_openCount;
+}
@@ -0,0 +1,543 @@
+#include "core/SegmentStore.h"
+#include <algorithm>
+#include <map>
+
+// A segment is compacted instead of appended to once this many of its entries are
+// duplicates of newer ones (or a quarter of its live records, whichever is smaller).
+static constexpr uint32_t SEGMENT_STALE_LIMIT = 64;
+
+SegmentStore::SegmentStore(const char *dir) : _dir(dir), _manifestPath(String(dir) + "/manifest.bin") {}
+
+int SegmentStore::monthKey(time_t ts)
+{
+    struct tm t;
+    gmtime_r(&ts, &t);
+    return (t.tm_year + 1900) * 12 + t.tm_mon;
+}
+
+time_t SegmentStore::monthStart(int key)
+{
+    // Days since epoch of the first of the month (proleptic Gregorian, H. Hinnant's algorithm)
+    int y = key / 12;
+    unsigned m = key % 12 + 1;
+    y -= m <= 2;
+    const long era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = (unsigned)(y - era * 400);
+    const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    const long days = era * 146097 + (long)doe - 719468;
+    return (time_t)days * 86400L;
+}
+
+String SegmentStore::segmentPath(int key) const
+{
+    char name[20];
+    snprintf(name, sizeof(name), "/%04d-%02d.bin", key / 12, key % 12 + 1);
+    return _dir + name;
+}
+
+String SegmentStore::rollupPath(int key) const
+{
+    char name[20];
+    snprintf(name, sizeof(name), "/%04d-%02d.day", key / 12, key % 12 + 1);
+    return _dir + name;
+}
+
+bool SegmentStore::isLoaded(int key) const
+{
+    return std::find(_loaded.begin(), _loaded.end(), key) != _loaded.end();
+}
+
+SegmentInfo *SegmentStore::info(int key, bool create)
+{
+    auto it = std::lower_bound(_segments.begin(), _segments.end(), key,
+                               [](const SegmentInfo &s, int k) { return s.monthKey < k; });
+    if (it != _segments.end() && it->monthKey == key)
+        return &*it;
+    if (!create)
+        return nullptr;
+
+    SegmentInfo seg = {key, 0, 0};
+    RecordLog log(segmentPath(key).c_str());
+    if (log.loadHeader())
+    {
+        // File exists but the manifest missed it (e.g. power loss before the manifest write)
+        seg.recordCount = log.recordCount();
+        seg.latestTs = (uint32_t)log.latestTimestamp();
+    }
+    else
+    {
+        // Nothing on disk yet, so the (empty) segment is fully represented in memory
+        _loaded.push_back(key);
+    }
+    it = _segments.insert(it, seg);
+    return &*it;
+}
+
+/**
+ * @brief Prepares the segment directory and reads the manifest.
+ *
+ * If the manifest is missing or unreadable it is rebuilt from the headers of the
+ * segment files present in the directory.
+ *
+ * @return true if the directory is usable.
+ */
+bool SegmentStore::begin()
+{
+    _segments.clear();
+    _loaded.clear();
+    _rollupsLoaded.clear();
+    if (!SD.exists(_dir) && !SD.mkdir(_dir))
+    {
+        Serial.println("[SegmentStore] Failed to create data directory!");
+        return false;
+    }
+
+    File file = SdCard::open(_manifestPath, FILE_READ);
+    if (file)
+    {
+        ManifestHeader h;
+        bool ok = file.read((uint8_t *)&h, sizeof(h)) == sizeof(h) &&
+                  h.magic == SegmentFormat::MANIFEST_MAGIC && h.version == SegmentFormat::MANIFEST_VERSION &&
+                  h.count <= SegmentFormat::MAX_SEGMENTS;
+        if (ok)
+        {
+            _segments.resize(h.count);
+            ok = file.read((uint8_t *)_segments.data(), h.count * sizeof(SegmentInfo)) == h.count * sizeof(SegmentInfo);
+        }
+        file.close();
+        if (ok)
+        {
+            _generation = h.generation;
+            _rewriteGeneration = h.rewriteGeneration;
+            Serial.printf("[SegmentStore] Manifest lists %u segments (generation %u).\r\n", (unsigned)_segments.size(), _generation);
+            return true;
+        }
+        _segments.clear();
+        Serial.println("[SegmentStore] Manifest unreadable, rebuilding.");
+    }
+    return rebuildManifest();
+}
+
+bool SegmentStore::rebuildManifest()
+{
+    File dir = SdCard::open(_dir);
+    if (!dir || !dir.isDirectory())
+        return false;
+
+    for (File f = dir.openNextFile(); f; f = dir.openNextFile())
+    {
+        // Some SD implementations return the full path, some just the name
+        const char *name = f.name();
+        const char *slash = strrchr(name, '/');
+        if (slash)
+            name = slash + 1;
+        int year = 0, month = 0;
+        // sscanf ignores the literal suffix, so check it separately (skips .day and .tmp files)
+        size_t len = strlen(name);
+        bool isSegment = !f.isDirectory() && len > 4 && strcmp(name + len - 4, ".bin") == 0 &&
+                         sscanf(name, "%4d-%2d.bin", &year, &month) == 2 && month >= 1 && month <= 12;
+        f.close();
+        if (!isSegment)
+            continue;
+
+        int key = year * 12 + month - 1;
+        RecordLog log(segmentPath(key).c_str());
+        if (!log.loadHeader())
+            continue;
+        _segments.push_back({key, log.recordCount(), (uint32_t)log.latestTimestamp()});
+    }
+    dir.close();
+
+    std::sort(_segments.begin(), _segments.end(),
+              [](const SegmentInfo &a, const SegmentInfo &b) { return a.monthKey < b.monthKey; });
+    // Nothing is known about what changed before the rebuild
+    _generation = esp_random();
+    _rewriteGeneration = _generation;
+    Serial.printf("[SegmentStore] Rebuilt manifest from %u segments.\r\n", (unsigned)_segments.size());
+    return saveManifest();
+}
+
+bool SegmentStore::saveManifest()
+{
+    ManifestHeader h = {SegmentFormat::MANIFEST_MAGIC, SegmentFormat::MANIFEST_VERSION, (uint16_t)_segments.size(),
+                        _generation, _rewriteGeneration};
+    File file = SdCard::open(_manifestPath, FILE_WRITE);
+    if (!file)
+    {
+        Serial.println("[SegmentStore] Failed to write manifest!");
+        return false;
+    }
+    file.write((const uint8_t *)&h, sizeof(h));
+    if (!_segments.empty())
+        file.write((const uint8_t *)_segments.data(), _segments.size() * sizeof(SegmentInfo));
+    file.flush();
+    file.close();
+    return true;
+}
+
+void SegmentStore::bumpGeneration(bool rewrite)
+{
+    _generation++;
+    if (rewrite)
+        _rewriteGeneration = _generation;
+}
+
+/**
+ * @brief Loads the segments overlapping [from, now] that are not in memory yet.
+ *
+ * Segments are visited oldest first and each is merged into the store as a batch.
+ * Calling this again with an earlier start only reads the additional months.
+ *
+ * @param petData Store to populate.
+ * @param from Start of the range of interest.
+ */
+void SegmentStore::load(PetDataStore &petData, time_t from)
+{
+    uint32_t t0 = micros();
+    int count = 0;
+    for (const auto &seg : _segments)
+    {
+        if (isLoaded(seg.monthKey) || monthStart(seg.monthKey + 1) <= from)
+            continue;
+        RecordLog log(segmentPath(seg.monthKey).c_str());
+        if (log.load(petData))
+            count++;
+        _loaded.push_back(seg.monthKey);
+
+        // Segments written before rollups existed get theirs while the raw data is at hand
+        if (!SD.exists(rollupPath(seg.monthKey)))
+            refreshRollups(petData, seg);
+    }
+    if (count > 0)
+        Serial.printf("[SegmentStore] Loaded %d segments in %lu us.\r\n", count, micros() - t0);
+}
+
+/**
+ * @brief Loads the daily rollups of the segments overlapping [from, now].
+ *
+ * Rollup files are a few KB per month, so a year of history costs twelve small reads
+ * instead of every raw visit. A rollup file that is missing, unreadable or was built
+ * from a different record count than the manifest lists (e.g. power loss between the
+ * segment append and the rollup write) is rebuilt from its raw segment.
+ *
+ * @param petData Store to populate.
+ * @param from Start of the range of interest.
+ */
+void SegmentStore::loadRollups(PetDataStore &petData, time_t from)
+{
+    uint32_t t0 = micros();
+    int count = 0, rebuilt = 0;
+    for (const auto &seg : _segments)
+    {
+        if (std::find(_rollupsLoaded.begin(), _rollupsLoaded.end(), seg.monthKey) != _rollupsLoaded.end() ||
+            monthStart(seg.monthKey + 1) <= from)
+            continue;
+        count++;
+        if (readRollups(petData, seg))
+            continue;
+
+        if (!isLoaded(seg.monthKey))
+        {
+            RecordLog log(segmentPath(seg.monthKey).c_str());
+            log.load(petData);
+            _loaded.push_back(seg.monthKey);
+        }
+        refreshRollups(petData, seg);
+        rebuilt++;
+    }
+    if (count > 0)
+        Serial.printf("[SegmentStore] Loaded rollups of %d segments (%d rebuilt) in %lu us.\r\n", count, rebuilt, micros() - t0);
+}
+
+bool SegmentStore::readRollups(PetDataStore &petData, const SegmentInfo &seg)
+{
+    File file = SdCard::open(rollupPath(seg.monthKey), FILE_READ);
+    if (!file)
+        return false;
+
+    RollupHeader h;
+    bool ok = file.read((uint8_t *)&h, sizeof(h)) == sizeof(h) &&
+              h.magic == SegmentFormat::ROLLUP_MAGIC && h.version == SegmentFormat::VERSION &&
+              h.entrySize == sizeof(RollupEntry) && h.sourceRecords == seg.recordCount;
+    std::vector<RollupEntry> entries;
+    if (ok)
+    {
+        entries.resize(h.count);
+        ok = file.read((uint8_t *)entries.data(), h.count * sizeof(RollupEntry)) == h.count * sizeof(RollupEntry);
+    }
+    file.close();
+    if (!ok)
+        return false;
+
+    // Entries are written grouped by pet and sorted by day
+    std::map<int, std::vector<DailyRollup>> perPet;
+    for (auto &petPair : petData)
+        perPet[petPair.first];
+    for (const auto &e : entries)
+        perPet[e.petId].push_back(e.day);
+
+    int32_t fromDay = PetSeries::dayOf(monthStart(seg.monthKey));
+    int32_t toDay = PetSeries::dayOf(monthStart(seg.monthKey + 1));
+    for (auto const &petPair : perPet)
+        petData.pet(petPair.first).replaceRollups(fromDay, toDay, petPair.second);
+    _rollupsLoaded.push_back(seg.monthKey);
+    return true;
+}
+
+/**
+ * @brief Recomputes a month's rollups from the raw records in the store and writes them.
+ *
+ * The month must be loaded. Rebuilding the whole month rather than patching single
+ * days keeps the rollups an exact function of the raw segment, whatever mix of
+ * appends, replacements and compactions produced it.
+ */
+void SegmentStore::refreshRollups(PetDataStore &petData, const SegmentInfo &seg)
+{
+    time_t start = monthStart(seg.monthKey);
+    time_t end = monthStart(seg.monthKey + 1);
+    int32_t fromDay = PetSeries::dayOf(start);
+    int32_t toDay = PetSeries::dayOf(end);
+
+    std::vector<RollupEntry> entries;
+    std::vector<DailyRollup> days;
+    for (auto &petPair : petData)
+    {
+        petPair.second.buildRollups(start, end, days);
+        petPair.second.replaceRollups(fromDay, toDay, days);
+        for (const auto &d : days)
+            entries.push_back({petPair.first, d});
+    }
+    if (std::find(_rollupsLoaded.begin(), _rollupsLoaded.end(), seg.monthKey) == _rollupsLoaded.end())
+        _rollupsLoaded.push_back(seg.monthKey);
+
+    RollupHeader h = {SegmentFormat::ROLLUP_MAGIC, SegmentFormat::VERSION, sizeof(RollupEntry),
+                      (uint32_t)entries.size(), seg.recordCount};
+    File file = SdCard::open(rollupPath(seg.monthKey), FILE_WRITE);
+    if (!file)
+    {
+        Serial.println("[SegmentStore] Failed to write rollups!");
+        return;
+    }
+    file.write((const uint8_t *)&h, sizeof(h));
+    if (!entries.empty())
+        file.write((const uint8_t *)entries.data(), entries.size() * sizeof(RollupEntry));
+    file.flush();
+    file.close();
+}
+
+void SegmentStore::compactSegment(const PetDataStore &petData, SegmentInfo &seg)
+{
+    RecordLog log(segmentPath(seg.monthKey).c_str());
+    if (log.compact(petData, monthStart(seg.monthKey), monthStart(seg.monthKey + 1)))
+    {
+        seg.recordCount = log.recordCount();
+        seg.latestTs = (uint32_t)log.latestTimestamp();
+    }
+}
+
+/**
+ * @brief Persists records queued by DataManager::mergeData.
+ *
+ * Records are grouped by month. Each group is normally appended to its segment, so
+ * the cost tracks the size of the API batch. A loaded segment that has accumulated
+ * enough superseded entries is rewritten from the store instead.
+ *
+ * Rollups of each touched month are then rebuilt from the store, so a re-merged or
+ * replaced visit is reflected exactly once.
+ *
+ * The generation advances; the save only counts as an append if every record is
+ * newer than anything stored before.
+ *
+ * @param petData The in-memory store (holds at least every segment touched).
+ * @param pending The new or changed records.
+ */
+void SegmentStore::save(PetDataStore &petData, const std::vector<SL_Record> &pending)
+{
+    if (pending.empty())
+        return;
+
+    time_t previousLatest = latestTimestamp();
+    bool appendOnly = true;
+    std::map<int, std::vector<SL_Record>> byMonth;
+    for (const auto &rec : pending)
+    {
+        byMonth[monthKey(rec.timestamp)].push_back(rec);
+        if (rec.timestamp <= previousLatest)
+            appendOnly = false;
+    }
+
+    for (auto const &group : byMonth)
+    {
+        SegmentInfo *seg = info(group.first, true);
+        if (isLoaded(group.first))
+        {
+            time_t start = monthStart(group.first);
+            time_t end = monthStart(group.first + 1);
+            uint32_t live = 0;
+            for (auto const &petPair : petData)
+                live += petPair.second.lowerBound(end) - petPair.second.lowerBound(start);
+
+            uint32_t logged = seg->recordCount + group.second.size();
+            uint32_t stale = logged > live ? logged - live : 0;
+            if (stale > SEGMENT_STALE_LIMIT || stale > live / 4)
+            {
+                Serial.printf("[SegmentStore] Compacting %s (%u stale of %u).\r\n", segmentPath(group.first).c_str(), stale, logged);
+                compactSegment(petData, *seg);
+                refreshRollups(petData, *seg);
+                continue;
+            }
+        }
+
+        RecordLog log(segmentPath(group.first).c_str());
+        if (log.append(group.second))
+        {
+            seg->recordCount = log.recordCount();
+            if ((uint32_t)log.latestTimestamp() > seg->latestTs)
+                seg->latestTs = (uint32_t)log.latestTimestamp();
+        }
+        refreshRollups(petData, *seg);
+    }
+    bumpGeneration(!appendOnly);
+    saveManifest();
+}
+
+/**
+ * @brief Writes the entire store out as monthly segments.
+ *
+ * Used once when migrating from the single-file log or legacy JSON. Rollups are
+ * built for every month along the way.
+ *
+ * @param petData The complete history.
+ * @return true if every month was written.
+ */
+bool SegmentStore::import(PetDataStore &petData)
+{
+    time_t oldest = 0, newest = 0;
+    for (auto const &petPair : petData)
+    {
+        const PetSeries &series = petPair.second;
+        if (series.empty())
+            continue;
+        if (oldest == 0 || series.timestamp(0) < oldest)
+            oldest = series.timestamp(0);
+        if (series.latest() > newest)
+            newest = series.latest();
+    }
+    if (newest == 0)
+        return true;
+
+    bool ok = true;
+    for (int key = monthKey(oldest); key <= monthKey(newest); key++)
+    {
+        time_t start = monthStart(key);
+        time_t end = monthStart(key + 1);
+        uint32_t live = 0;
+        for (auto const &petPair : petData)
+            live += petPair.second.lowerBound(end) - petPair.second.lowerBound(start);
+        if (live == 0)
+            continue;
+
+        SegmentInfo *seg = info(key, true);
+        compactSegment(petData, *seg);
+        ok &= seg->recordCount == live;
+        if (!isLoaded(key))
+            _loaded.push_back(key);
+        refreshRollups(petData, *seg);
+    }
+    bumpGeneration(true);
+    saveManifest();
+    return ok;
+}
+
+/**
+ * @brief Applies retention by deleting whole expired segments.
+ *
+ * A segment's rollup file goes with it, and its days are dropped from the store, so
+ * the long-range views never show days whose raw visits are gone.
+ *
+ * @param before Segments whose month ended before this time are removed.
+ */
+void SegmentStore::prune(PetDataStore &petData, time_t before)
+{
+    bool changed = false;
+    for (auto it = _segments.begin(); it != _segments.end();)
+    {
+        if (monthStart(it->monthKey + 1) > before)
+        {
+            ++it;
+            continue;
+        }
+        String path = segmentPath(it->monthKey);
+        Serial.printf("[SegmentStore] Removing expired segment %s\r\n", path.c_str());
+        SD.remove(path);
+        SD.remove(rollupPath(it->monthKey));
+        _loaded.erase(std::remove(_loaded.begin(), _loaded.end(), it->monthKey), _loaded.end());
+        _rollupsLoaded.erase(std::remove(_rollupsLoaded.begin(), _rollupsLoaded.end(), it->monthKey), _rollupsLoaded.end());
+
+        int32_t fromDay = PetSeries::dayOf(monthStart(it->monthKey));
+        int32_t toDay = PetSeries::dayOf(monthStart(it->monthKey + 1));
+        for (auto &petPair : petData)
+            petPair.second.replaceRollups(fromDay, toDay, {});
+        it = _segments.erase(it);
+        changed = true;
+    }
+    if (changed)
+    {
+        bumpGeneration(true);
+        saveManifest();
+    }
+}
+
+/**
+ * @brief Moves the segment directory aside and starts an empty one.
+ *
+ * A backup left from an earlier pet-set change is renamed to the first free
+ * <newDir>.<n> first. The in-memory segment list is only dropped once the move
+ * succeeded; otherwise the next manifest would list just the months saved after it
+ * and every older month would drop out of the views.
+ *
+ * @return false if the segments are still in place.
+ */
+bool SegmentStore::backup(const String &newDir)
+{
+    if (SD.exists(newDir))
+    {
+        String older;
+        for (int n = 1; n < 100; n++)
+        {
+            older = newDir + "." + String(n);
+            if (!SD.exists(older))
+                break;
+        }
+        if (SD.exists(older) || !SD.rename(newDir, older))
+        {
+            Serial.printf("[SegmentStore] Cannot move old backup %s aside, keeping segments in place\r\n", newDir.c_str());
+            return false;
+        }
+        Serial.printf("[SegmentStore] Moved old backup %s to %s\r\n", newDir.c_str(), older.c_str());
+    }
+    if (!SD.rename(_dir, newDir))
+    {
+        Serial.printf("[SegmentStore] Failed to move %s to %s, keeping segments in place\r\n", _dir.c_str(), newDir.c_str());
+        return false;
+    }
+
+    _segments.clear();
+    _loaded.clear();
+    _rollupsLoaded.clear();
+    bumpGeneration(true);
+    SD.mkdir(_dir);
+    return true;
+}
+
+time_t SegmentStore::latestTimestamp() const
+{
+    uint32_t latest = 0;
+    for (const auto &seg : _segments)
+    {
+        if (seg.latestTs > latest)
+            latest = seg.latestTs;
+    }
+    return (time_t)latest;
+}
@@ -0,0 +1,98 @@
+#include "ui/CaptureCanvas.h"
+#include "core/SdCard.h"
+#include "ui/PngImage.h"
+
+uint32_t CaptureCanvas::checksum() const
+{
+    uint32_t h = 2166136261u; // FNV-1a, same as the layout cache key
+    if (!_frame)
+        return h;
+    for (size_t i = 0; i < bufferSize(); i++)
+    {
+        h ^= _frame[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+void CaptureCanvas::indexRow(int16_t y, uint8_t *out) const
+{
+    for (int16_t x = 0; x < WIDTH; x++)
+        out[x] = getPixel(x, y);
+}
+
+bool CaptureCanvas::writeImage(const char *basePath) const
+{
+    if (!_frame)
+        return false;
+    String path = String(basePath) + IMAGE_EXT;
+    File file = SdCard::open(path, FILE_WRITE);
+    if (!file)
+    {
+        Serial.printf("[CaptureCanvas] Failed to open %s\r\n", path.c_str());
+        return false;
+    }
+    uint8_t palette[PALETTE_SIZE * 3];
+    for (int i = 0; i < PALETTE_SIZE; i++)
+        memcpy(palette + i * 3, paletteColor(i), 3);
+
+    PngWriter png;
+    uint8_t *row = (uint8_t *)malloc(WIDTH);
+    bool ok = row && png.begin(file, WIDTH, HEIGHT, palette, PALETTE_SIZE);
+    for (int16_t y = 0; ok && y < HEIGHT; y++)
+    {
+        indexRow(y, row);
+        ok = png.writeRow(row);
+    }
+    ok = png.end() && ok;
+    free(row);
+    file.close();
+    Serial.printf("[CaptureCanvas] %s %s\r\n", ok ? "Wrote" : "Failed to write", path.c_str());
+    return ok;
+}
+
+/**
+ * @brief Compares the frame with a golden image, pixel by pixel as the panel shows them.
+ *
+ * The golden may be any 8-bit PNG of the same size; colors are compared as RGB.
+ *
+ * @return Number of pixels that differ, or -1 if there is no comparable golden image.
+ */
+int32_t CaptureCanvas::compareImage(const char *basePath) const
+{
+    if (!_frame)
+        return -1;
+    String path = String(basePath) + IMAGE_EXT;
+    if (!SD.exists(path))
+        return -1;
+    File file = SdCard::open(path, FILE_READ);
+    if (!file)
+        return -1;
+    PngReader png;
+    bool ok = png.read(file);
+    file.close();
+    if (!ok || png.width() != WIDTH || png.height() != HEIGHT)
+    {
+        Serial.printf("[CaptureCanvas] %s is not a readable %dx%d PNG\r\n", path.c_str(), WIDTH, HEIGHT);
+        return -1;
+    }
+
+    uint8_t *mine = (uint8_t *)malloc(WIDTH);
+    uint8_t *theirs = (uint8_t *)malloc((size_t)WIDTH * 3);
+    int32_t diff = 0;
+    for (int16_t y = 0; mine && theirs && y < HEIGHT; y++)
+    {
+        indexRow(y, mine);
+        png.rgbRow(y, theirs);
+        for (int16_t x = 0; x < WIDTH; x++)
+        {
+            if (memcmp(paletteColor(mine[x]), theirs + x * 3, 3) != 0)
+                diff++;
+        }
+    }
+    if (!mine || !theirs)
+        diff = -1;
+    free(mine);
+    free(theirs);
+    return diff;
+}
@@ -5,7 +5,7 @@
 #include <cmath>
 
 DashboardData DataProcessor::process(const std::vector<SL_Pet> &pets, 
-                                     const PetDataMap &allPetData, 
+                                     const PetDataStore &allPetData, 
                                      const DateRangeInfo &range,
                                      const std::vector<ColorPair>& colors)
 {
@@ -13,13 +13,15 @@ DashboardData DataProcessor::process(const std::vector<SL_Pet> &pets,
     
     time_t now = time(NULL);
     time_t timeStart = now - range.seconds;
+    data.timeStart = timeStart;
+    data.useRollups = range.useRollups;
 
     int idx = 0;
     for (const auto &pet : pets)
     {
         // Guard: check if we even have data for this pet
-        auto it = allPetData.find(pet.id.toInt());
-        if (it == allPetData.end())
+        const PetSeries *petRecords = allPetData.find(pet.id.toInt());
+        if (petRecords == nullptr)
         {
             idx++;
             continue;
@@ -27,49 +29,287 @@ DashboardData DataProcessor::process(const std::vector<SL_Pet> &pets,
 
         ProcessedSeries series;
         series.name = pet.name;
+        series.petId = pet.id.toInt();
         series.color = colors[idx % colors.size()].color;
         series.bgColor = colors[idx % colors.size()].background;
 
-        time_t lastTimestamp = -1;
-        const auto& petRecords = it->second;
+        if (range.useRollups)
+            addRollups(*petRecords, PetSeries::dayOf(timeStart), series);
+        else
+            addVisits(*petRecords, petRecords->lowerBound(timeStart), series);
+        data.series.push_back(series);
+        idx++;
+    }
+
+    return data;
+}
+
+/**
+ * @brief Appends a pet's visits from index first on to a series.
+ *
+ * Records are sorted, so the caller finds the first one of the range with a binary
+ * search. x stays in UTC seconds; only ScatterPlot's tick labels need local time.
+ */
+void DataProcessor::addVisits(const PetSeries &petRecords, size_t first, ProcessedSeries &series)
+{
+    if (first >= petRecords.size())
+        return;
+    series.scatterPoints.reserve(series.scatterPoints.size() + petRecords.size() - first);
+
+    for (size_t i = first; i < petRecords.size(); i++)
+        series.scatterPoints.push_back({(float)petRecords.timestamp(i), petRecords.weight(i)});
+    series.lastSource = petRecords.latest();
+}
+
+/**
+ * @brief Fills a series from daily rollups instead of individual visits.
+ *
+ * Each day contributes its lightest and heaviest visit to the scatter plot, so
+ * outliers stay visible with at most two markers per day.
+ */
+void DataProcessor::addRollups(const PetSeries &petRecords, int32_t fromDay, ProcessedSeries &series)
+{
+    size_t first = petRecords.dayLowerBound(fromDay);
+    if (first >= petRecords.dayCount())
+        return;
+    series.scatterPoints.reserve(series.scatterPoints.size() + (petRecords.dayCount() - first) * 2);
+
+    for (size_t i = first; i < petRecords.dayCount(); i++)
+    {
+        const DailyRollup &day = petRecords.day(i);
+        float x = dayMidpoint(day);
+        series.scatterPoints.push_back({x, day.minWeight});
+        if (day.maxWeight != day.minWeight)
+            series.scatterPoints.push_back({x, day.maxWeight});
+    }
+    series.lastSource = (time_t)petRecords.day(petRecords.dayCount() - 1).day * 86400L;
+}
+
+float DataProcessor::dayMidpoint(const DailyRollup &day)
+{
+    return dayX(day.day);
+}
+
+float DataProcessor::dayX(int32_t day)
+{
+    return (float)((time_t)day * 86400L + 43200L); // midday
+}
+
+// Index of the first point with x >= x (points sorted by x)
+static size_t firstAtOrAfter(const ArenaVector<DataPoint> &points, float x)
+{
+    return std::lower_bound(points.begin(), points.end(), x,
+                            [](const DataPoint &p, float v) { return p.x < v; }) - points.begin();
+}
+
+/**
+ * @brief Updates a processed pet view for a later range start and newer records.
+ *
+ * Visits: the cached points are the series' records from the old range start up to
+ * lastSource, so the ones still in range are the last (upperBound(lastSource) -
+ * lowerBound(timeStart)) of them; records after lastSource are appended. Counting on
+ * the store keeps this exact where float x (128 s resolution) would not be.
+ *
+ * Rollups: days before the range are dropped by x, which is a day apart, and the
+ * newest cached day is redone along with any later ones, since it may have gained
+ * visits.
+ *
+ * @param data View returned by process() (or restored by ProcessedCache).
+ * @param allPetData The store, grown only by appends since the view was processed.
+ * @param timeStart New range start; not before data.timeStart.
+ * @return false if a cached series has more in-range points than the store has records.
+ */
+bool DataProcessor::extend(DashboardData &data, const PetDataStore &allPetData, time_t timeStart)
+{
+    if (timeStart < data.timeStart)
+        return false;
 
-        // Iterate through records for this pet
-        for (auto const &recordPair : petRecords)
+    for (auto &series : data.series)
+    {
+        const PetSeries *petRecords = allPetData.find(series.petId);
+        if (petRecords == nullptr)
+            return false;
+        ArenaVector<DataPoint> &points = series.scatterPoints;
+
+        if (data.useRollups)
         {
-            const SL_Record &record = recordPair.second;
-            
-            // Filter by date range
-            if (record.timestamp < timeStart)
+            int32_t firstDay = PetSeries::dayOf(timeStart);
+            int32_t fromDay = firstDay;
+            if (series.lastSource != 0 && PetSeries::dayOf(series.lastSource) >= firstDay)
             {
-                continue;
+                fromDay = PetSeries::dayOf(series.lastSource);
+                points.erase(points.begin() + firstAtOrAfter(points, dayX(fromDay)), points.end());
+                points.erase(points.begin(), points.begin() + firstAtOrAfter(points, dayX(firstDay)));
             }
+            else
+                points.clear();
+            addRollups(*petRecords, fromDay, series);
+        }
+        else
+        {
+            size_t first = petRecords->lowerBound(timeStart);
+            size_t next = series.lastSource != 0 ? petRecords->upperBound(series.lastSource) : first;
+            if (next < first)
+                next = first; // every cached point is out of range
+            size_t keep = next - first;
+            if (keep > points.size())
+                return false;
+            points.erase(points.begin(), points.end() - keep);
+            addVisits(*petRecords, next, series);
+        }
+    }
+    data.timeStart = timeStart;
+    return true;
+}
 
-            // 1. Scatter Plot Data (Weight vs Time)
-            float weight_lbs = (float)record.weight_lbs;
-            struct tm *thistimestamp = localtime(&record.timestamp);
-            time_t ts = mktime(thistimestamp);
-            series.scatterPoints.push_back({(float)ts, weight_lbs});
-            //if(series.weightValues.size() > 0) series.deltaWeightValues.push_back(weight_lbs - series.weightValues.back());
-            series.weightValues.push_back(weight_lbs);
-            // 2. Duration Histogram Data (Duration in Minutes)
-            if (record.duration_seconds > 0.0)
-                series.durationValues.push_back((float)record.duration_seconds / 60.0);
-
-            // 3. Interval Histogram Data (Hours since last visit)
-            if (lastTimestamp > 0)
-                series.intervalValues.push_back(((float)(record.timestamp - lastTimestamp)) / 3600.0);
-
-            lastTimestamp = record.timestamp;
+/**
+ * @brief Runs the weight-trend kernel for a pet's "weight_change" histogram.
+ *
+ * Over the visits of the series, or over the daily mean weights for rollup ranges.
+ */
+static void weightChangeRates(const PetSeries &petRecords, const ProcessedSeries &series, time_t timeStart,
+                              bool useRollups, ArenaVector<DataPoint> &pointScratch, ArenaVector<float> &rates)
+{
+    const ArenaVector<DataPoint> *points = &series.scatterPoints;
+    if (useRollups)
+    {
+        pointScratch.clear();
+        size_t first = petRecords.dayLowerBound(PetSeries::dayOf(timeStart));
+        for (size_t i = first; i < petRecords.dayCount(); i++)
+        {
+            const DailyRollup &day = petRecords.day(i);
+            pointScratch.push_back({DataProcessor::dayMidpoint(day), day.sumWeight / day.count});
         }
-        series.deltaWeightValues = getWeightChangeRates(series.scatterPoints, 30, 7);
-        data.series.push_back(series);
-        idx++;
+        points = &pointScratch;
     }
+    const TrendOutput trend = {TrendPresets::MONTHLY_CHANGE, &rates};
+    DataProcessor::weightTrends(*points, &trend, 1);
+}
 
-    return data;
+/**
+ * @brief Calls f(value) for every value one record-based histogram source takes from a pet.
+ *
+ * Raw visits give one value per visit (intervals from the second visit on, durations
+ * only when recorded). Daily rollups give the day's means instead, as the long
+ * ranges always did.
+ */
+template <typename F>
+static void forEachHistogramValue(const PetSeries &petRecords, time_t timeStart, bool useRollups, DataSourceId source, F f)
+{
+    if (useRollups)
+    {
+        size_t first = petRecords.dayLowerBound(PetSeries::dayOf(timeStart));
+        for (size_t i = first; i < petRecords.dayCount(); i++)
+        {
+            const DailyRollup &day = petRecords.day(i);
+            if (source == SOURCE_WEIGHT)
+                f(day.sumWeight / day.count);
+            else if (source == SOURCE_DURATION && day.durationCount > 0)
+                f(day.totalDuration / day.durationCount / 60.0);
+            else if (source == SOURCE_INTERVAL && day.intervalCount > 0)
+                f(day.intervalSum / day.intervalCount / 3600.0);
+        }
+        return;
+    }
+
+    size_t first = petRecords.lowerBound(timeStart);
+    for (size_t i = first; i < petRecords.size(); i++)
+    {
+        if (source == SOURCE_WEIGHT)
+            f(petRecords.weight(i));
+        else if (source == SOURCE_DURATION && petRecords.duration(i) > 0.0)
+            f(petRecords.duration(i) / 60.0); // minutes
+        else if (source == SOURCE_INTERVAL && i > first)
+            f(((float)(petRecords.timestamp(i) - petRecords.timestamp(i - 1))) / 3600.0); // hours since last visit
+    }
+}
+
+/**
+ * @brief Bins one histogram data source for every series of a processed view.
+ *
+ * Two passes over each pet's records and no per-value vectors: the first pass
+ * finds every series' range, the second bins each value against the range shared
+ * by all series, so the bars of different pets line up. Weight change rates are
+ * the exception: the trend kernel runs once per series in pass 1 and its rates are
+ * kept (in the render arena) for pass 2.
+ *
+ * @param data Processed view (series order, range start, rollups or visits).
+ * @param allPetData The records the view was processed from.
+ * @param source SOURCE_INTERVAL, SOURCE_DURATION, SOURCE_WEIGHT or SOURCE_WEIGHT_CHANGE.
+ * @param bins Number of bins.
+ * @param out One accumulator per series of data, empty for other sources.
+ * @param minVal Shared range start.
+ * @param maxVal Shared range end.
+ * @return Number of values binned.
+ */
+uint32_t DataProcessor::binHistogram(const DashboardData &data, const PetDataStore &allPetData, DataSourceId source,
+                                     int bins, ArenaVector<HistogramAccumulator> &out, float &minVal, float &maxVal)
+{
+    out.clear();
+    minVal = HUGE_VALF;
+    maxVal = -HUGE_VALF;
+    if (source != SOURCE_INTERVAL && source != SOURCE_DURATION && source != SOURCE_WEIGHT && source != SOURCE_WEIGHT_CHANGE)
+        return 0;
+
+    out.resize(data.series.size());
+    const bool trend = source == SOURCE_WEIGHT_CHANGE;
+    ArenaVector<DataPoint> pointScratch;
+    ArenaVector<ArenaVector<float>> rates(trend ? data.series.size() : 0);
+    uint32_t total = 0;
+
+    // Pass 1: ranges
+    for (size_t i = 0; i < data.series.size(); i++)
+    {
+        const PetSeries *petRecords = allPetData.find(data.series[i].petId);
+        if (!petRecords)
+            continue;
+        HistogramAccumulator &acc = out[i];
+        if (trend)
+        {
+            weightChangeRates(*petRecords, data.series[i], data.timeStart, data.useRollups, pointScratch, rates[i]);
+            for (float rate : rates[i])
+                acc.include(rate);
+        }
+        else
+            forEachHistogramValue(*petRecords, data.timeStart, data.useRollups, source,
+                                  [&acc](float v) { acc.include(v); });
+        if (acc.count() == 0)
+            continue;
+        if (acc.minVal() < minVal)
+            minVal = acc.minVal();
+        if (acc.maxVal() > maxVal)
+            maxVal = acc.maxVal();
+        total += acc.count();
+    }
+
+    // Handle case where all values are the same
+    if (minVal == maxVal)
+    {
+        minVal -= 1.0f;
+        maxVal += 1.0f;
+    }
+
+    // Pass 2: bins
+    for (size_t i = 0; i < data.series.size(); i++)
+    {
+        HistogramAccumulator &acc = out[i];
+        acc.beginBins(minVal, maxVal, bins);
+        const PetSeries *petRecords = allPetData.find(data.series[i].petId);
+        if (!petRecords || acc.count() == 0)
+            continue;
+        if (trend)
+        {
+            for (float rate : rates[i])
+                acc.add(rate);
+        }
+        else
+            forEachHistogramValue(*petRecords, data.timeStart, data.useRollups, source,
+                                  [&acc](float v) { acc.add(v); });
+    }
+    return total;
 }
 
-DashboardData DataProcessor::processEnvData(const std::vector<env_data>& envData,
+DashboardData DataProcessor::processEnvData(const std::vector<EnvAggregate>& envData,
                                             const DateRangeInfo& range,
                                             const std::vector<ColorPair>& colors)
 {
@@ -92,15 +332,16 @@ DashboardData DataProcessor::processEnvData(const std::vector<env_data>& envData
     humidSeries.color = colors.size() > 1 ? colors[1].color : 0;
     humidSeries.bgColor = colors.size() > 1 ? colors[1].background : 0;
 
+    // One point per bucket; the tier was chosen so there are about as many buckets as pixels
+    tempSeries.scatterPoints.reserve(envData.size());
+    humidSeries.scatterPoints.reserve(envData.size());
     for (const auto& rec : envData)
     {
-        if (rec.timestamp < timeStart) continue;
+        time_t bucketStart = rec.timestamp;
+        if (bucketStart < timeStart) continue;
 
-        struct tm *thistimestamp = localtime(&rec.timestamp);
-        time_t ts = mktime(thistimestamp);
-
-        tempSeries.scatterPoints.push_back({(float)ts, rec.temperature});
-        humidSeries.scatterPoints.push_back({(float)ts, rec.humidity});
+        tempSeries.scatterPoints.push_back({(float)bucketStart, rec.tempMean});
+        humidSeries.scatterPoints.push_back({(float)bucketStart, rec.humidMean});
     }
 
     data.series.push_back(tempSeries);
@@ -109,50 +350,82 @@ DashboardData DataProcessor::processEnvData(const std::vector<env_data>& envData
     return data;
 }
 
-std::vector<float> DataProcessor::getWeightChangeRates(std::vector<DataPoint> scatterPoints, int intervalDays, int smoothingWindow) {
-    if (scatterPoints.size() < 2) return {};
-
-    // 1. Ensure chronological order
-    std::sort(scatterPoints.begin(), scatterPoints.end(), [](const DataPoint& a, const DataPoint& b) {
-        return a.x < b.x;
-    });
-
-    // 2. Simple Centered Smoothing
-    // Even with cleaned data, various sources of noise cause "jitter". Smoothing 3-5 points 
-    // helps find the "true" weight 
-    std::vector<float> smoothedWeights;
-    int n = scatterPoints.size();
-    int radius = smoothingWindow / 2;
-
-    for (int i = 0; i < n; ++i) {
-        float sum = 0.0f;
-        int count = 0;
-        for (int j = i - radius; j <= i + radius; ++j) {
-            if (j >= 0 && j < n) {
-                sum += scatterPoints[j].y;
-                count++;
-            }
-        }
-        smoothedWeights.push_back(sum / count);
+/**
+ * @brief Streaming weight-trend kernel.
+ *
+ * Each output keeps a running sum over its centered window (a point is added as it
+ * enters the window and subtracted as it leaves), so smoothing is O(n) per preset
+ * regardless of window size. The rate of change only needs the previous smoothed
+ * value, so nothing but the outputs is allocated.
+ *
+ * Even with cleaned data, various sources of noise cause "jitter"; smoothing 3-7
+ * points helps find the "true" weight. If the box records multiple times in one
+ * hour the rate is extremely volatile, so only gaps over an hour produce a rate.
+ *
+ * @param points Series points (x in seconds, y in lbs).
+ * @param outputs Presets and the buffers their rates go to.
+ * @param count Number of outputs.
+ */
+void DataProcessor::weightTrends(const ArenaVector<DataPoint> &points, const TrendOutput *outputs, size_t count)
+{
+    for (size_t k = 0; k < count; k++)
+        outputs[k].rates->clear();
+    const int n = points.size();
+    if (n < 2 || count == 0)
+        return;
+
+    // Chronological order is required; series normally arrive that way
+    auto byX = [](const DataPoint &a, const DataPoint &b) { return a.x < b.x; };
+    ArenaVector<DataPoint> sortedCopy;
+    const DataPoint *p = points.data();
+    if (!std::is_sorted(points.begin(), points.end(), byX))
+    {
+        sortedCopy = points;
+        std::sort(sortedCopy.begin(), sortedCopy.end(), byX);
+        p = sortedCopy.data();
+    }
+
+    struct Window {
+        int radius;
+        int lo, hi;  // points [lo, hi) are in the running sum
+        double sum;
+        float prevSmoothed;
+    };
+    constexpr size_t MAX_OUTPUTS = 8;
+    Window windows[MAX_OUTPUTS];
+    if (count > MAX_OUTPUTS)
+        count = MAX_OUTPUTS;
+    for (size_t k = 0; k < count; k++)
+    {
+        windows[k] = {outputs[k].preset.smoothingWindow / 2, 0, 0, 0.0, 0.0f};
+        outputs[k].rates->reserve(n - 1);
     }
 
-    // 3. Calculate Rate of Change Normalized to intervalDays
-    std::vector<float> dailyRates;
     const double SECONDS_IN_DAY = 86400.0;
+    for (int i = 0; i < n; i++)
+    {
+        for (size_t k = 0; k < count; k++)
+        {
+            Window &w = windows[k];
+            int lo = i - w.radius > 0 ? i - w.radius : 0;
+            int hi = i + w.radius + 1 < n ? i + w.radius + 1 : n;
+            while (w.hi < hi)
+                w.sum += p[w.hi++].y;
+            while (w.lo < lo)
+                w.sum -= p[w.lo++].y;
+            float smoothed = (float)(w.sum / (hi - lo));
 
-    for (size_t i = 1; i < smoothedWeights.size(); ++i) {
-        float weightDiff = smoothedWeights[i] - smoothedWeights[i - 1];
-        double timeDiff = scatterPoints[i].x - scatterPoints[i - 1].x;
-
-        // If the box records multiple times in one hour, the "rate" can be 
-        // extremely volatile. We look for meaningful time gaps (e.g., > 1 hour).
-        if (timeDiff > 3600.0) { 
-            // Result is: (Change in Weight / Seconds) * Seconds in a Day
-            float ratePerDay = (float)((weightDiff / timeDiff) * SECONDS_IN_DAY);
-            float ratePerInterval = intervalDays * ratePerDay;
-            dailyRates.push_back(ratePerInterval);
+            if (i > 0)
+            {
+                double timeDiff = p[i].x - p[i - 1].x;
+                if (timeDiff > 3600.0)
+                {
+                    // (Change in Weight / Seconds) * Seconds in a Day, then per interval
+                    float ratePerDay = (float)(((smoothed - w.prevSmoothed) / timeDiff) * SECONDS_IN_DAY);
+                    outputs[k].rates->push_back(outputs[k].preset.intervalDays * ratePerDay);
+                }
+            }
+            w.prevSmoothed = smoothed;
         }
     }
-
-    return dailyRates;
-}
\ No newline at end of file
+}
@@ -1,29 +1,42 @@
 #include "ui/Histogram.h"
+#include "ui/TextMetrics.h"
+#include "ui/PatternFill.h"
 #include <numeric>
 #include <algorithm>
 #include <cmath>
 #include <Fonts/FreeSansBold12pt7b.h>
 #include <Fonts/FreeSansBold9pt7b.h>
+#include <Fonts/FreeSans9pt7b.h>
 
 Histogram::Histogram(Adafruit_GFX *gfx, int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
     : _gfx(gfx), _x(x), _y(y), _w(w), _h(h), _color(color) {}
 
-void Histogram::setTitle(const char *title) { _title = title; }
+void Histogram::setTitle(const char *title)
+{
+    strncpy(_title, title ? title : "", sizeof(_title) - 1);
+    _title[sizeof(_title) - 1] = '\0';
+}
 void Histogram::setXAxisLabel(const char *label) { _xAxisLabel = label; }
 void Histogram::setYAxisLabel(const char *label) { _yAxisLabel = label; }
 void Histogram::setBinCount(int bins) { _numBins = bins > 0 ? bins : 1; }
 
-void Histogram::addSeries(const char *name, const std::vector<float> &data, uint16_t color, uint16_t background)
+void Histogram::setRange(float minVal, float maxVal)
+{
+    _minVal = minVal;
+    _maxVal = maxVal;
+}
+
+void Histogram::addBinnedSeries(const char *name, const ArenaVector<int> &bins, uint32_t count, uint16_t color, uint16_t background)
 {
-    // Add a new series to our vector, initializing seriesMaxFreq to 0
     HistogramSeries newSeries;
     newSeries.name = name;
-    newSeries.data = data;
-    newSeries.bins = std::vector<int>(); // Explicitly create empty vector
+    newSeries.bins = bins;
+    newSeries.count = count;
     newSeries.color = color;
     newSeries.seriesMaxFreq = 0;
     newSeries.backcolor = background;
     _series.push_back(newSeries);
+    _numBins = bins.size() > 0 ? bins.size() : 1;
 }
 
 void Histogram::setNormalization(bool enabled)
@@ -31,9 +44,13 @@ void Histogram::setNormalization(bool enabled)
     _normalize = enabled;
 }
 
-void Histogram::plot()
+/**
+ * @brief Resolves colors and scales the bars to the binned counts.
+ *
+ * Called once per refresh; plot() can then be repeated for every page band. plot() calls it itself if it has not been called.
+ */
+void Histogram::prepare()
 {
-
 #if (EPD_SELECT == 1001) // do some translating of color settings
     if (_color == EPD_RED)
         _color = EPD_LIGHTGREY;
@@ -51,7 +68,16 @@ void Histogram::plot()
     else if (_color == EPD_DARKGREY)
         _color = EPD_RED;
 #endif
-    _gfx->fillRect(_x, _y, _w, _h, EPD_WHITE);
+    // Pre-process data to find ranges and frequencies
+    processData();
+    _prepared = true;
+}
+
+void Histogram::plot()
+{
+    if (!_prepared)
+        prepare();
+    PatternFill::fillRect(_gfx, _x, _y, _w, _h, FILL_SOLID, EPD_WHITE, EPD_WHITE);
     _gfx->fillRect(_x + PADDING_LEFT, _y + PADDING_TOP, _w - PADDING_LEFT - PADDING_RIGHT, _h - PADDING_TOP - PADDING_BOTTOM, EPD_WHITE);
     _gfx->fillRect(_x + PADDING_LEFT, _y, _w - PADDING_LEFT - PADDING_RIGHT, PADDING_TOP, _color);
     _gfx->drawRect(_x + PADDING_LEFT, _y, _w - PADDING_LEFT - PADDING_RIGHT, PADDING_TOP + 1, EPD_BLACK);
@@ -70,9 +96,6 @@ void Histogram::plot()
         return;
     }
 
-    // Pre-process data to find ranges and frequencies
-    processData();
-
     // Draw the histogram bars
     drawBars();
 
@@ -86,67 +109,19 @@ void Histogram::processData()
     if (_series.empty())
         return;
 
-    // Determine data range (min/max) across ALL datasets for a shared X-axis
-    _minVal = HUGE_VALF;
-    _maxVal = -HUGE_VALF;
-
-    for (const auto &s : _series)
-    {
-        if (!s.data.empty())
-        {
-            _minVal = std::min(_minVal, *std::min_element(s.data.begin(), s.data.end()));
-            _maxVal = std::max(_maxVal, *std::max_element(s.data.begin(), s.data.end()));
-        }
-    }
-
-    // Handle case where all values are the same
-    if (_minVal == _maxVal)
-    {
-        _minVal -= 1.0f;
-        _maxVal += 1.0f;
-    }
-    //_minVal = 0; // Forcing 0 min-val
-
-    // Bin the data for each series
-    float binWidth = (_maxVal - _minVal) / _numBins;
     _maxFreq = 0; // This will be the global max (if not normalizing) or 100 (if normalizing)
-
     for (auto &s : _series)
     {
-        s.bins.assign(_numBins, 0);
         s.seriesMaxFreq = 0; // Reset series-specific max
-        if (s.data.empty())
+        if (s.count == 0 || s.bins.empty())
             continue;
 
-        for (float val : s.data)
-        {
-            int binIndex = static_cast<int>((val - _minVal) / binWidth);
-            if (binIndex >= _numBins)
-                binIndex = _numBins - 1; // Put max value in last bin
-            if (binIndex >= 0)
-            {
-                s.bins[binIndex]++;
-            }
-        }
-
         // Find the max frequency for *this* series
-        if (!s.bins.empty())
-        {
-            float maxBin = (float)*std::max_element(s.bins.begin(), s.bins.end());
-            if (_normalize)
-            {
-                if (s.data.size() > 0)
-                {
-                    s.seriesMaxFreq = (int)((maxBin * 100.0f) / s.data.size());
-                }
-                else
-                {
-                    s.seriesMaxFreq = 0;
-                }
-            }
-            else
-                s.seriesMaxFreq = *std::max_element(s.bins.begin(), s.bins.end());
-        }
+        float maxBin = (float)*std::max_element(s.bins.begin(), s.bins.end());
+        if (_normalize)
+            s.seriesMaxFreq = (int)((maxBin * 100.0f) / s.count);
+        else
+            s.seriesMaxFreq = (int)maxBin;
 
         // Update the global max frequency (only used if not normalizing)
         if (s.seriesMaxFreq > _maxFreq)
@@ -186,14 +161,20 @@ void Histogram::drawAxes()
     //_gfx->drawRect(_plotX, _plotY, _plotW, _plotH, AXIS_COLOR);
 
     // Draw Title
-    if (_title)
+    if (_title[0])
     {
-        int16_t tx, ty;
-        uint16_t tw, th;
-        _gfx->setFont(&FreeSansBold9pt7b);
+        // Longer titles (e.g. the "Daily Mean" ones) fall back to the regular weight,
+        // then to the built-in font
+        static const GFXfont *const titleFonts[] = {&FreeSansBold9pt7b, &FreeSans9pt7b, nullptr};
+        TextBounds tb;
+        int fontIndex = TextMetrics::fitFont(titleFonts, 3, _title, _plotW, PADDING_TOP, &tb);
+        uint16_t tw = tb.w, th = tb.h;
+        _gfx->setFont(titleFonts[fontIndex]);
         _gfx->setTextSize(0);
-        _gfx->getTextBounds(_title, 0, 0, &tx, &ty, &tw, &th);
-        _gfx->setCursor(_x + (_w - tw) / 2, _plotY - th / 2 + 2); // Adjusted y
+        if (titleFonts[fontIndex])
+            _gfx->setCursor(_x + (_w - tw) / 2, _plotY - th / 2 + 2); // Adjusted y
+        else
+            _gfx->setCursor(_x + (_w - tw) / 2, _y + (PADDING_TOP - th) / 2); // cursor is the top left here
         _gfx->setTextColor(EPD_WHITE);
         _gfx->print(_title);
         _gfx->setTextSize(1);
@@ -226,7 +207,7 @@ void Histogram::drawAxes()
 
         int16_t tx, ty;
         uint16_t tw, th;
-        _gfx->getTextBounds(label, 0, 0, &tx, &ty, &tw, &th);
+        TextMetrics::bounds(nullptr, label, 0, 0, &tx, &ty, &tw, &th);
         _gfx->setCursor(_plotX - tw - 6, yPos - th / 2); // Adjusted y
         _gfx->setTextColor(EPD_BLACK);                   // Use standard text color
         _gfx->print(label);
@@ -263,7 +244,7 @@ void Histogram::drawAxes()
         // if(lbl.equals("0.0") || lbl.equals("-0.0")) drawDashedLine(xPos, _plotY + _plotH, xPos, _plotY , AXIS_COLOR, 2, 2);
         int16_t tx, ty;
         uint16_t tw, th;
-        _gfx->getTextBounds(label, 0, 0, &tx, &ty, &tw, &th);
+        TextMetrics::bounds(nullptr, label, 0, 0, &tx, &ty, &tw, &th);
         _gfx->setCursor(xPos - tw / 2, _plotY + _plotH + 5);
         _gfx->print(label);
     }
@@ -276,7 +257,7 @@ void Histogram::drawAxes()
     {
         int16_t tx, ty;
         uint16_t tw, th;
-        _gfx->getTextBounds(_xAxisLabel, 0, 0, &tx, &ty, &tw, &th);
+        TextMetrics::bounds(nullptr, _xAxisLabel, 0, 0, &tx, &ty, &tw, &th);
         _gfx->setCursor(_plotX + (_plotW - tw) / 2, _y + _h - th);
         _gfx->print(_xAxisLabel);
     }
@@ -323,9 +304,9 @@ void Histogram::drawBars()
                 if (s.seriesMaxFreq > 0)
                 {
                     // Calculate height as a percentage of this series's max
-                    if (s.data.size() > 0)
+                    if (s.count > 0)
                     {
-                        float freq = (static_cast<float>(s.bins[i]) / s.data.size()) * 100.0;
+                        float freq = (static_cast<float>(s.bins[i]) / s.count) * 100.0;
                         barH = static_cast<int16_t>((freq / _maxFreq) * _plotH);
                     }
                 }
@@ -349,18 +330,18 @@ void Histogram::drawBars()
                 switch (s.color)
                 {
                 case EPD_RED:
-                    _gfx->fillRect(barStartX, _plotY + _plotH - barH, barWidth, barH, EPD_BLACK);
+                    PatternFill::fillRect(_gfx, barStartX, _plotY + _plotH - barH, barWidth, barH, FILL_SOLID, EPD_BLACK, EPD_BLACK);
                     break;
                 case EPD_BLUE:
                     // drawCheckerRect(barStartX, _plotY + _plotH - barH, barWidth, barH, EPD_BLACK, EPD_WHITE);
 
-                    _gfx->fillRect(barStartX, _plotY + _plotH - barH, barWidth, barH, EPD_LIGHTGREY);
+                    PatternFill::fillRect(_gfx, barStartX, _plotY + _plotH - barH, barWidth, barH, FILL_SOLID, EPD_LIGHTGREY, EPD_LIGHTGREY);
                     _gfx->drawRect(barStartX, _plotY + _plotH - barH, barWidth, barH, EPD_BLACK);
                     break;
                 case EPD_GREEN:
                     // drawPatternRect(barStartX, _plotY + _plotH - barH, barWidth, barH, EPD_BLACK, EPD_WHITE);
 
-                    _gfx->fillRect(barStartX, _plotY + _plotH - barH, barWidth, barH, EPD_DARKGREY);
+                    PatternFill::fillRect(_gfx, barStartX, _plotY + _plotH - barH, barWidth, barH, FILL_SOLID, EPD_DARKGREY, EPD_DARKGREY);
                     _gfx->drawRect(barStartX, _plotY + _plotH - barH, barWidth, barH, EPD_BLACK);
                     break;
                 case EPD_YELLOW:
@@ -370,7 +351,7 @@ void Histogram::drawBars()
                 case EPD_BLACK:
                     //_gfx->drawRect(barStartX, _plotY + _plotH - barH, barWidth, barH, EPD_BLACK);
 
-                    _gfx->fillRect(barStartX, _plotY + _plotH - barH, barWidth, barH, EPD_WHITE);
+                    PatternFill::fillRect(_gfx, barStartX, _plotY + _plotH - barH, barWidth, barH, FILL_SOLID, EPD_WHITE, EPD_WHITE);
                     _gfx->drawRect(barStartX, _plotY + _plotH - barH, barWidth, barH, EPD_BLACK);
                     break;
                 }
@@ -422,78 +403,26 @@ void Histogram::drawLegend()
 
         int16_t tx, ty;
         uint16_t tw, th;
-        _gfx->getTextBounds(s.name, 0, 0, &tx, &ty, &tw, &th);
+        TextMetrics::bounds(nullptr, s.name, 0, 0, &tx, &ty, &tw, &th);
         legendX += markerW + tw + spacing + 10; // Move X for next legend item
     }
 }
 
 void Histogram::drawPatternRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color1, uint16_t color2)
 {
-    _gfx->fillRect(x, y, w, h, color2);
+    PatternFill::fillRect(_gfx, x, y, w, h, FILL_HATCH, EPD_BLACK, color2);
     _gfx->drawRect(x, y, w, h, color1);
-
-    if (w <= 0 || h <= 0)
-        return;
-
-    // Draw diagonal fill lines by drawing parallel lines of the form x-y=k.
-    // We iterate k through the box dimensions and calculate the clipped start
-    // and end points for the line segment that falls within the rectangle.
-    for (int16_t k = 4; k < w + h; k += 4)
-    { // Start at 4 to not draw on the border
-        // Calculate the start point (bottom-left of the line segment)
-        int16_t x1_rel = std::max(0, k - h);
-        int16_t y1_rel = k - x1_rel - 1;
-
-        // Calculate the end point (top-right of the line segment)
-        int16_t x2_rel = std::min(w, k) - 1;
-        int16_t y2_rel = k - x2_rel;
-
-        // Convert relative coordinates to absolute screen coordinates and draw the line.
-        _gfx->drawLine(x + x1_rel, y + y1_rel, x + x2_rel, y + y2_rel, EPD_BLACK);
-    }
 }
 
 void Histogram::drawHatchRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color1, uint16_t color2)
 {
-    _gfx->fillRect(x, y, w, h, color2);
+    PatternFill::fillRect(_gfx, x, y, w, h, FILL_HATCH, EPD_BLACK, color2);
     _gfx->drawRect(x, y, w, h, color1);
-
-    if (w <= 0 || h <= 0)
-        return;
-
-    // Draw diagonal fill lines /// by drawing parallel lines of the form x-y=k.
-    // We iterate k through the box dimensions and calculate the clipped start
-    // and end points for the line segment that falls within the rectangle.
-    for (int16_t k = 4; k < w + h; k += 4)
-    { // Start at 4 to not draw on the border
-
-        // Calculate the start point (bottom-left of the line segment)
-        int16_t x1_rel = std::max(0, k - h);
-        int16_t y1_rel = k - x1_rel - 1;
-
-        // Calculate the end point (top-right of the line segment)
-        int16_t x2_rel = std::min(w, k) - 1;
-        int16_t y2_rel = k - x2_rel;
-
-        // Convert relative coordinates to absolute screen coordinates and draw the line.
-        _gfx->drawLine(x + x1_rel, y + y1_rel, x + x2_rel, y + y2_rel, EPD_BLACK);
-    }
 }
 
 void Histogram::drawCheckerRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color1, uint16_t color2)
 {
-    bool checker = false;
-    for (int y1 = y; y1 < y + h; y1++)
-    {
-        for (int x1 = x; x1 < x + w; x1++)
-        {
-            if (checker ^ ((x1 - x) % 2))
-                _gfx->drawPixel(x1, y1, color1);
-            else
-                _gfx->drawPixel(x1, y1, color2);
-        }
-        checker = !checker;
-    }
+    PatternFill::fillRect(_gfx, x, y, w, h, FILL_CHECKER, color1, color2);
     _gfx->drawRect(x, y, w, h, color1);
 }
 
@@ -0,0 +1,113 @@
+#include "ui/LayoutCompiler.h"
+
+struct NameMapEntry {
+    const char *name;
+    uint8_t id;
+};
+
+static const NameMapEntry WIDGET_KINDS[] = {
+    {"ScatterPlot", WIDGET_SCATTER_PLOT},
+    {"Histogram", WIDGET_HISTOGRAM},
+    {"LinearGauge", WIDGET_LINEAR_GAUGE},
+    {"RingGauge", WIDGET_RING_GAUGE},
+    {"TextLabel", WIDGET_TEXT_LABEL},
+    {"StatusBox", WIDGET_STATUS_BOX},
+};
+
+static const NameMapEntry DATA_SOURCES[] = {
+    {"scatter", SOURCE_SCATTER},
+    {"temperature_history", SOURCE_TEMPERATURE_HISTORY},
+    {"humidity_history", SOURCE_HUMIDITY_HISTORY},
+    {"interval", SOURCE_INTERVAL},
+    {"duration", SOURCE_DURATION},
+    {"weight", SOURCE_WEIGHT},
+    {"weight_change", SOURCE_WEIGHT_CHANGE},
+    {"battery", SOURCE_BATTERY},
+    {"litter", SOURCE_LITTER},
+    {"waste", SOURCE_WASTE},
+    {"datetime", SOURCE_DATETIME},
+    {"temperature", SOURCE_TEMPERATURE},
+    {"humidity", SOURCE_HUMIDITY},
+    {"petkit_status", SOURCE_PETKIT_STATUS},
+};
+
+static const NameMapEntry DECIMATION_MODES[] = {
+    {"minmax", DECIMATE_MINMAX},
+    {"lttb", DECIMATE_LTTB},
+    {"none", DECIMATE_NONE},
+};
+
+WidgetKind LayoutCompiler::kindFromName(const String &type)
+{
+    for (const auto &e : WIDGET_KINDS)
+    {
+        if (type == e.name)
+            return (WidgetKind)e.id;
+    }
+    return WIDGET_UNKNOWN;
+}
+
+DataSourceId LayoutCompiler::sourceFromName(const String &dataSource)
+{
+    for (const auto &e : DATA_SOURCES)
+    {
+        if (dataSource == e.name)
+            return (DataSourceId)e.id;
+    }
+    return SOURCE_NONE;
+}
+
+DecimationMode LayoutCompiler::decimationFromName(const String &decimation)
+{
+    for (const auto &e : DECIMATION_MODES)
+    {
+        if (decimation == e.name)
+            return (DecimationMode)e.id;
+    }
+    return DECIMATE_MINMAX;
+}
+
+CompiledWidget LayoutCompiler::compile(const WidgetConfig &w)
+{
+    CompiledWidget c;
+    memset(&c, 0, sizeof(c));
+    c.kind = kindFromName(w.type);
+    c.source = sourceFromName(w.dataSource);
+    // A ScatterPlot without a dataSource plots the pet weights
+    if (c.kind == WIDGET_SCATTER_PLOT && w.dataSource.length() == 0)
+        c.source = SOURCE_SCATTER;
+    c.x = w.x;
+    c.y = w.y;
+    c.w = w.w;
+    c.h = w.h;
+    c.p1 = w.p1;
+    c.p2 = w.p2;
+    c.min = w.min;
+    c.max = w.max;
+    c.color = w.color;
+    strncpy(c.title, w.title.c_str(), sizeof(c.title) - 1);
+    strncpy(c.unit, w.unit.c_str(), sizeof(c.unit) - 1);
+    c.decimation = decimationFromName(w.decimation);
+    if (c.kind == WIDGET_UNKNOWN)
+        Serial.printf("[LayoutCompiler] Unknown widget type '%s', it will be skipped.\r\n", w.type.c_str());
+    return c;
+}
+
+void LayoutCompiler::compile(const std::vector<WidgetConfig> &layout, std::vector<CompiledWidget> &out)
+{
+    out.clear();
+    out.reserve(layout.size());
+    for (const auto &w : layout)
+        out.push_back(compile(w));
+}
+
+uint32_t LayoutCompiler::hash(const uint8_t *data, size_t len, uint32_t seed)
+{
+    uint32_t h = seed;
+    for (size_t i = 0; i < len; i++)
+    {
+        h ^= data[i];
+        h *= 16777619u;
+    }
+    return h;
+}
@@ -0,0 +1,185 @@
+#include "ui/MarkerSprite.h"
+#include "ui/PatternFill.h"
+#include "ui/PanelCanvas.h"
+#include "core/Config.h"
+#ifdef RENDER_PROFILE
+#include "ui/CaptureCanvas.h"
+#endif
+
+namespace
+{
+    // Records what the marker primitives draw into a SIZE x SIZE box
+    class SpriteBaker : public Adafruit_GFX
+    {
+    public:
+        SpriteBaker() : Adafruit_GFX(MarkerSprite::SIZE, MarkerSprite::SIZE)
+        {
+            memset(set, 0, sizeof(set));
+        }
+
+        void drawPixel(int16_t x, int16_t y, uint16_t color) override
+        {
+            if (x < 0 || y < 0 || x >= MarkerSprite::SIZE || y >= MarkerSprite::SIZE)
+                return;
+            pixels[y][x] = color;
+            set[y][x] = true;
+        }
+
+        uint16_t pixels[MarkerSprite::SIZE][MarkerSprite::SIZE];
+        bool set[MarkerSprite::SIZE][MarkerSprite::SIZE];
+    };
+}
+
+void MarkerSprite::drawShape(Adafruit_GFX *gfx, int16_t x, int16_t y, uint16_t color, uint16_t background)
+{
+#if (EPD_SELECT == 1002)
+    // You could customize this to draw different markers based on series index
+    // For now, all series use a filled circle
+    gfx->fillCircle(x, y, 3, background);
+    gfx->drawCircle(x, y, 3, color);
+    gfx->drawCircle(x, y, 1, color);
+
+#elif (EPD_SELECT == 1001)
+    switch (color)
+    {
+    case EPD_RED:
+        gfx->fillCircle(x, y, 3, EPD_BLACK);
+        break;
+    case EPD_BLUE:
+        gfx->fillCircle(x, y, 3, EPD_LIGHTGREY);
+        gfx->drawCircle(x, y, 3, EPD_BLACK);
+        break;
+    case EPD_GREEN:
+        gfx->drawRect(x - 1, y + 1, 4, 4, EPD_BLACK);
+        break;
+    case EPD_YELLOW:
+        gfx->fillRect(x - 1, y + 1, 4, 4, EPD_BLACK);
+        break;
+    case EPD_BLACK:
+        gfx->drawLine(x - 2, y + 2, x + 2, y - 2, EPD_BLACK);
+        gfx->drawLine(x + 1, y - 1, x - 1, y + 1, EPD_BLACK);
+        break;
+    }
+#endif
+}
+
+/**
+ * @brief Draws the marker primitives into a scratch box and keeps the result as runs.
+ *
+ * Overlapping primitives resolve exactly as they did on the display (last write
+ * wins), so stamping the sprite gives the same pixels as drawing the shape.
+ */
+void MarkerSprite::bake(uint16_t color, uint16_t background)
+{
+    SpriteBaker baker;
+    drawShape(&baker, ORIGIN, ORIGIN, color, background);
+
+    _count = 0;
+    for (int y = 0; y < SIZE; y++)
+    {
+        int x = 0;
+        while (x < SIZE)
+        {
+            if (!baker.set[y][x])
+            {
+                x++;
+                continue;
+            }
+            int start = x;
+            uint16_t c = baker.pixels[y][x];
+            while (x < SIZE && baker.set[y][x] && baker.pixels[y][x] == c)
+                x++;
+            _runs[_count++] = {(int8_t)(start - ORIGIN), (int8_t)(y - ORIGIN), (uint8_t)(x - start), c, PanelCanvas::quantize(c)};
+        }
+    }
+}
+
+/**
+ * @brief Stamps the baked runs centered on (x, y).
+ *
+ * The sprite box is clipped once; each run is then only trimmed to that box.
+ */
+void MarkerSprite::draw(Adafruit_GFX *gfx, int16_t x, int16_t y) const
+{
+    // Whole sprite outside the display or the page band: nothing to stamp
+    int16_t top = y - ORIGIN, bottom = y - ORIGIN + SIZE;
+    PatternFill::clipRows(gfx, top, bottom);
+    int16_t left = x - ORIGIN < 0 ? 0 : x - ORIGIN;
+    int16_t right = x - ORIGIN + SIZE > gfx->width() ? gfx->width() : x - ORIGIN + SIZE;
+    if (top >= bottom || left >= right)
+        return;
+
+    PanelCanvas *canvas = PatternFill::canvas();
+    if (canvas && gfx != (Adafruit_GFX *)canvas)
+        canvas = nullptr;
+    if (!canvas)
+        gfx->startWrite();
+    for (uint8_t i = 0; i < _count; i++)
+    {
+        const Run &r = _runs[i];
+        int16_t row = y + r.dy;
+        if (row < top)
+            continue;
+        if (row >= bottom)
+            break; // runs are in row order
+        int16_t x0 = x + r.dx < left ? left : x + r.dx;
+        int16_t x1 = x + r.dx + r.len > right ? right : x + r.dx + r.len;
+        if (x0 >= x1)
+            continue;
+        if (canvas)
+            canvas->fillIndexRun(row, x0, x1, r.index);
+        else
+            for (int16_t col = x0; col < x1; col++)
+                gfx->writePixel(col, row, r.color);
+    }
+    if (!canvas)
+        gfx->endWrite();
+}
+
+#ifdef RENDER_PROFILE
+/**
+ * @brief Compares drawing markers from primitives with stamping the baked sprite.
+ *
+ * Draws the same 1000-marker grid both ways for every series color pair of the
+ * default palette and logs time, pixel writes and whether the frames match.
+ *
+ * @return true if the frames matched for every color pair.
+ */
+bool MarkerSprite::benchmark(CaptureCanvas &canvas)
+{
+    static const uint16_t COLORS[][2] = {
+        {EPD_RED, EPD_YELLOW}, {EPD_BLUE, EPD_BLACK}, {EPD_GREEN, EPD_YELLOW}, {EPD_BLACK, EPD_WHITE}};
+    const int REPS = 1000;
+    bool match = true;
+    for (const auto &pair : COLORS)
+    {
+        uint32_t start, shapeUs, spriteUs, shapeWrites, shapeSum;
+
+        canvas.fillScreen(EPD_WHITE);
+        canvas.resetPixelWrites();
+        start = micros();
+        for (int i = 0; i < REPS; i++)
+            drawShape(&canvas, 10 + (i % 50) * 12, 10 + (i / 50) * 12, pair[0], pair[1]);
+        shapeUs = micros() - start;
+        shapeWrites = canvas.pixelWrites();
+        shapeSum = canvas.checksum();
+
+        MarkerSprite sprite;
+        sprite.bake(pair[0], pair[1]);
+        canvas.fillScreen(EPD_WHITE);
+        canvas.resetPixelWrites();
+        start = micros();
+        for (int i = 0; i < REPS; i++)
+            sprite.draw(&canvas, 10 + (i % 50) * 12, 10 + (i / 50) * 12);
+        spriteUs = micros() - start;
+        bool identical = canvas.checksum() == shapeSum;
+        match = match && identical;
+
+        Serial.printf("[MarkerSprite] %04x/%04x: primitives %lu us, %lu pixel writes; sprite (%u runs) %lu us, %lu pixel writes; %s\r\n",
+                      pair[0], pair[1], (unsigned long)shapeUs, (unsigned long)shapeWrites, sprite.runs(),
+                      (unsigned long)spriteUs, (unsigned long)canvas.pixelWrites(),
+                      identical ? "identical" : "MISMATCH");
+    }
+    return match;
+}
+#endif
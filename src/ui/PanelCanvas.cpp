@@ -0,0 +1,238 @@
+#include "ui/PanelCanvas.h"
+#include "ui/PatternFill.h"
+
+#if (EPD_SELECT == 1001)
+// Gray levels of palette indices 0..3 (black .. white)
+static const uint8_t PALETTE[][3] = {{0, 0, 0}, {85, 85, 85}, {170, 170, 170}, {255, 255, 255}};
+#else
+// GxEPD2_7C palette: black, white, green, blue, red, yellow, orange
+static const uint8_t PALETTE[][3] = {
+    {0, 0, 0}, {255, 255, 255}, {0, 255, 0}, {0, 0, 255}, {255, 0, 0}, {255, 255, 0}, {255, 128, 0}};
+#endif
+static_assert(sizeof(PALETTE) / sizeof(PALETTE[0]) == PanelCanvas::PALETTE_SIZE, "palette size");
+static constexpr uint8_t PIXEL_MASK = (1 << PanelCanvas::BITS_PER_PIXEL) - 1;
+
+// Bit offset of column x inside its byte: the leftmost pixel is in the high bits
+static inline int pixelShift(int16_t x)
+{
+    return (PanelCanvas::PIXELS_PER_BYTE - 1 - x % PanelCanvas::PIXELS_PER_BYTE) * PanelCanvas::BITS_PER_PIXEL;
+}
+
+static inline void setIndex(uint8_t *row, int16_t x, uint8_t index)
+{
+    uint8_t &b = row[x / PanelCanvas::PIXELS_PER_BYTE];
+    int shift = pixelShift(x);
+    b = (b & ~(PIXEL_MASK << shift)) | (index << shift);
+}
+
+// A byte holding PIXELS_PER_BYTE copies of one palette index
+static inline uint8_t repeatIndex(uint8_t index)
+{
+    uint8_t b = 0;
+    for (int i = 0; i < PanelCanvas::PIXELS_PER_BYTE; i++)
+        b = (b << PanelCanvas::BITS_PER_PIXEL) | index;
+    return b;
+}
+
+PanelCanvas::PanelCanvas(int16_t w, int16_t h) : Adafruit_GFX(w, h) {}
+
+PanelCanvas::~PanelCanvas()
+{
+    if (PatternFill::canvas() == this)
+        PatternFill::setCanvas(nullptr);
+    if (_frame)
+        heap_caps_free(_frame);
+}
+
+bool PanelCanvas::begin()
+{
+    if (_frame)
+        return true;
+    _frame = (uint8_t *)heap_caps_malloc(bufferSize(), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!_frame)
+    {
+        Serial.println("[PanelCanvas] Frame allocation failed!");
+        return false;
+    }
+    memset(_frame, repeatIndex(paletteIndex(EPD_WHITE)), bufferSize());
+    PatternFill::setCanvas(this);
+    return true;
+}
+
+/**
+ * @brief Quantizes an RGB565 color to the panel palette.
+ *
+ * E1001 maps to one of four grays by luminance, E1002 to the nearest of the seven
+ * panel colors.
+ */
+uint8_t PanelCanvas::quantize(uint16_t color)
+{
+    int r = ((color >> 11) & 0x1F) * 255 / 31;
+    int g = ((color >> 5) & 0x3F) * 255 / 63;
+    int b = (color & 0x1F) * 255 / 31;
+    uint8_t best = 0;
+#if (EPD_SELECT == 1001)
+    int lum = (r * 299 + g * 587 + b * 114) / 1000;
+    best = (lum + 42) / 85;
+#else
+    int32_t bestDist = INT32_MAX;
+    for (int i = 0; i < PALETTE_SIZE; i++)
+    {
+        int dr = r - PALETTE[i][0], dg = g - PALETTE[i][1], db = b - PALETTE[i][2];
+        int32_t d = dr * dr + dg * dg + db * db;
+        if (d < bestDist)
+        {
+            bestDist = d;
+            best = i;
+        }
+    }
+#endif
+    return best;
+}
+
+// quantize() with the last lookup cached, since widgets draw long runs in one color
+uint8_t PanelCanvas::paletteIndex(uint16_t color)
+{
+    if (color != _lastColor)
+    {
+        _lastColor = color;
+        _lastIndex = quantize(color);
+    }
+    return _lastIndex;
+}
+
+const uint8_t *PanelCanvas::paletteColor(uint8_t index)
+{
+    return PALETTE[index < PALETTE_SIZE ? index : 0];
+}
+
+void PanelCanvas::drawPixel(int16_t x, int16_t y, uint16_t color)
+{
+    if (!_frame || x < 0 || y < 0 || x >= WIDTH || y >= HEIGHT)
+        return;
+    setIndex(_frame + (size_t)y * rowBytes(), x, paletteIndex(color));
+    _pixelWrites++;
+}
+
+/**
+ * @brief Sets columns [x0, x1) of a packed row to one index.
+ *
+ * Partial bytes at either end are masked, the whole bytes between them set with memset.
+ */
+void PanelCanvas::writeRun(uint8_t *row, int16_t x0, int16_t x1, uint8_t index)
+{
+    _pixelWrites += x1 - x0;
+    for (; x0 < x1 && x0 % PIXELS_PER_BYTE; x0++)
+        setIndex(row, x0, index);
+    int16_t whole = (x1 - x0) / PIXELS_PER_BYTE;
+    if (whole > 0)
+    {
+        memset(row + x0 / PIXELS_PER_BYTE, repeatIndex(index), whole);
+        x0 += whole * PIXELS_PER_BYTE;
+    }
+    for (; x0 < x1; x0++)
+        setIndex(row, x0, index);
+}
+
+void PanelCanvas::fillRun(int16_t y, int16_t x0, int16_t x1, uint16_t color)
+{
+    if (!_frame)
+        return;
+    writeRun(_frame + (size_t)y * rowBytes(), x0, x1, paletteIndex(color));
+}
+
+void PanelCanvas::fillIndexRun(int16_t y, int16_t x0, int16_t x1, uint8_t index)
+{
+    if (!_frame)
+        return;
+    writeRun(_frame + (size_t)y * rowBytes(), x0, x1, index);
+}
+
+void PanelCanvas::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+{
+    if (w < 0)
+    {
+        x += w + 1;
+        w = -w;
+    }
+    int16_t x0 = x < 0 ? 0 : x;
+    int16_t x1 = x + w > WIDTH ? WIDTH : x + w;
+    if (y < 0 || y >= HEIGHT || x0 >= x1)
+        return;
+    fillRun(y, x0, x1, color);
+}
+
+void PanelCanvas::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    if (w < 0)
+    {
+        x += w + 1;
+        w = -w;
+    }
+    if (h < 0)
+    {
+        y += h + 1;
+        h = -h;
+    }
+    int16_t x0 = x < 0 ? 0 : x;
+    int16_t x1 = x + w > WIDTH ? WIDTH : x + w;
+    int16_t y0 = y < 0 ? 0 : y;
+    int16_t y1 = y + h > HEIGHT ? HEIGHT : y + h;
+    for (int16_t row = y0; row < y1 && x0 < x1; row++)
+        fillRun(row, x0, x1, color);
+}
+
+void PanelCanvas::fillScreen(uint16_t color)
+{
+    if (!_frame)
+        return;
+    memset(_frame, repeatIndex(paletteIndex(color)), bufferSize());
+    _pixelWrites += (uint32_t)WIDTH * HEIGHT;
+}
+
+/**
+ * @brief Writes one row of an 8-pixel tile straight into the packed frame.
+ *
+ * The tile repeats every 8 columns and a byte holds 2 or 4 pixels, so there are only
+ * 8 distinct bytes a row can contain; they are built once and then copied.
+ */
+void PanelCanvas::fillPatternRow(int16_t y, int16_t x0, int16_t x1, int16_t originX, uint8_t tileRow, uint16_t fg, uint16_t bg)
+{
+    if (!_frame)
+        return;
+    uint8_t *row = _frame + (size_t)y * rowBytes();
+    if (tileRow == 0xFF || tileRow == 0x00)
+    {
+        writeRun(row, x0, x1, paletteIndex(tileRow ? fg : bg));
+        return;
+    }
+
+    uint8_t index[8];
+    uint8_t fgIndex = paletteIndex(fg);
+    uint8_t bgIndex = paletteIndex(bg);
+    for (int i = 0; i < 8; i++)
+        index[i] = ((tileRow >> i) & 1) ? fgIndex : bgIndex;
+    uint8_t bytes[8]; // byte starting at tile column i
+    for (int i = 0; i < 8; i++)
+    {
+        bytes[i] = 0;
+        for (int p = 0; p < PIXELS_PER_BYTE; p++)
+            bytes[i] = (bytes[i] << BITS_PER_PIXEL) | index[(i + p) & 7];
+    }
+
+    _pixelWrites += x1 - x0;
+    int16_t x = x0;
+    for (; x < x1 && x % PIXELS_PER_BYTE; x++)
+        setIndex(row, x, index[(x - originX) & 7]);
+    for (; x + PIXELS_PER_BYTE <= x1; x += PIXELS_PER_BYTE)
+        row[x / PIXELS_PER_BYTE] = bytes[(x - originX) & 7];
+    for (; x < x1; x++)
+        setIndex(row, x, index[(x - originX) & 7]);
+}
+
+uint8_t PanelCanvas::getPixel(int16_t x, int16_t y) const
+{
+    if (!_frame || x < 0 || y < 0 || x >= WIDTH || y >= HEIGHT)
+        return 0;
+    return (_frame[(size_t)y * rowBytes() + x / PIXELS_PER_BYTE] >> pixelShift(x)) & PIXEL_MASK;
+}
@@ -0,0 +1,150 @@
+#include "ui/PatternFill.h"
+#include "ui/PanelCanvas.h"
+#ifdef RENDER_PROFILE
+#include "ui/CaptureCanvas.h"
+#endif
+
+// Tile rows, bit n = column n. Checker puts the foreground on odd columns of even rows,
+// hatch on x + y == 3 (mod 4), matching the per-pixel and drawLine versions they replace.
+static const uint8_t TILES[][8] = {
+    {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}, // FILL_SOLID
+    {0xAA, 0x55, 0xAA, 0x55, 0xAA, 0x55, 0xAA, 0x55}, // FILL_CHECKER
+    {0x88, 0x44, 0x22, 0x11, 0x88, 0x44, 0x22, 0x11}, // FILL_HATCH
+    {0x00, 0x22, 0x00, 0x00, 0x00, 0x22, 0x00, 0x00}, // FILL_DOTS
+};
+
+static int16_t s_clipTop = INT16_MIN;
+static int16_t s_clipBottom = INT16_MAX;
+static PanelCanvas *s_canvas = nullptr;
+
+void PatternFill::setClip(int16_t top, int16_t bottom)
+{
+    s_clipTop = top;
+    s_clipBottom = bottom;
+}
+
+void PatternFill::clearClip()
+{
+    s_clipTop = INT16_MIN;
+    s_clipBottom = INT16_MAX;
+}
+
+void PatternFill::clipRows(const Adafruit_GFX *gfx, int16_t &top, int16_t &bottom)
+{
+    if (top < s_clipTop)
+        top = s_clipTop;
+    if (top < 0)
+        top = 0;
+    if (bottom > s_clipBottom)
+        bottom = s_clipBottom;
+    if (bottom > gfx->height())
+        bottom = gfx->height();
+}
+
+void PatternFill::setCanvas(PanelCanvas *canvas)
+{
+    s_canvas = canvas;
+}
+
+PanelCanvas *PatternFill::canvas()
+{
+    return s_canvas;
+}
+
+/**
+ * @brief Fills a rect with a two-color pattern.
+ *
+ * @param gfx Target display or canvas.
+ * @param pattern Tile to repeat, anchored at (x, y).
+ * @param fg Color of the set tile bits.
+ * @param bg Color of the clear tile bits.
+ */
+void PatternFill::fillRect(Adafruit_GFX *gfx, int16_t x, int16_t y, int16_t w, int16_t h,
+                           FillPattern pattern, uint16_t fg, uint16_t bg)
+{
+    if (w <= 0 || h <= 0 || pattern > FILL_DOTS)
+        return;
+
+    // Clip to the display and the current band
+    int16_t x0 = x < 0 ? 0 : x;
+    int16_t x1 = x + w > gfx->width() ? gfx->width() : x + w;
+    int16_t y0 = y, y1 = y + h;
+    clipRows(gfx, y0, y1);
+    if (x0 >= x1 || y0 >= y1)
+        return;
+
+    const uint8_t *tile = TILES[pattern];
+    if (s_canvas && gfx == (Adafruit_GFX *)s_canvas)
+    {
+        for (int16_t row = y0; row < y1; row++)
+            s_canvas->fillPatternRow(row, x0, x1, x, tile[(row - y) & 7], fg, bg);
+        return;
+    }
+
+    gfx->startWrite();
+    for (int16_t row = y0; row < y1; row++)
+    {
+        uint8_t tileRow = tile[(row - y) & 7];
+        for (int16_t col = x0; col < x1; col++)
+            gfx->writePixel(col, row, ((tileRow >> ((col - x) & 7)) & 1) ? fg : bg);
+    }
+    gfx->endWrite();
+}
+
+#ifdef RENDER_PROFILE
+/**
+ * @brief Compares the old per-pixel checker fill with the paged and direct paths.
+ *
+ * Fills 200 bar-sized (12x120) rects with each method on the capture canvas and logs
+ * the time and pixel writes of each. The paged path is timed with the canvas
+ * unregistered, so it goes through writePixel as it does on the paged display.
+ *
+ * @return true if all three methods produced the same frame.
+ */
+bool PatternFill::benchmark(CaptureCanvas &canvas)
+{
+    const int REPS = 200;
+    const int16_t W = 12, H = 120;
+    uint32_t start, writes, legacySum;
+
+    canvas.fillScreen(EPD_WHITE);
+    canvas.resetPixelWrites();
+    start = micros();
+    for (int i = 0; i < REPS; i++)
+    {
+        int16_t x = (i * 16) % 780, y = 40;
+        bool checker = false;
+        for (int y1 = y; y1 < y + H; y1++)
+        {
+            for (int x1 = x; x1 < x + W; x1++)
+                canvas.drawPixel(x1, y1, (checker ^ ((x1 - x) % 2)) ? EPD_RED : EPD_YELLOW);
+            checker = !checker;
+        }
+    }
+    Serial.printf("[PatternFill] per-pixel: %lu us, %lu pixel writes\r\n", (unsigned long)(micros() - start), (unsigned long)canvas.pixelWrites());
+    legacySum = canvas.checksum();
+
+    PanelCanvas *direct = s_canvas;
+    s_canvas = nullptr;
+    canvas.fillScreen(EPD_WHITE);
+    canvas.resetPixelWrites();
+    start = micros();
+    for (int i = 0; i < REPS; i++)
+        fillRect(&canvas, (i * 16) % 780, 40, W, H, FILL_CHECKER, EPD_RED, EPD_YELLOW);
+    writes = canvas.pixelWrites();
+    Serial.printf("[PatternFill] paged:     %lu us, %lu pixel writes\r\n", (unsigned long)(micros() - start), (unsigned long)writes);
+    bool match = canvas.checksum() == legacySum;
+
+    s_canvas = &canvas;
+    canvas.fillScreen(EPD_WHITE);
+    canvas.resetPixelWrites();
+    start = micros();
+    for (int i = 0; i < REPS; i++)
+        fillRect(&canvas, (i * 16) % 780, 40, W, H, FILL_CHECKER, EPD_RED, EPD_YELLOW);
+    Serial.printf("[PatternFill] direct:    %lu us, %lu pixel writes\r\n", (unsigned long)(micros() - start), (unsigned long)canvas.pixelWrites());
+    match = match && canvas.checksum() == legacySum;
+    s_canvas = direct;
+    Serial.printf("[PatternFill] frames %s\r\n", match ? "identical" : "MISMATCH");
+    return match;
+}
+#endif
@@ -1,5 +1,7 @@
 #include "ui/PlotManager.h"
 #include "ui/DataProcessor.h"
+#include "ui/PatternFill.h"
+#include "ui/TextMetrics.h"
 #include "Fonts/FreeMono9pt7b.h"
 #include "Fonts/FreeMonoBold9pt7b.h"
 
@@ -28,50 +30,120 @@ namespace Layout
     constexpr int PADDING_LARGE = 20;
 }
 
-PlotManager::PlotManager(GxEPD2_DISPLAY_CLASS<GxEPD2_DRIVER_CLASS, MAX_HEIGHT(GxEPD2_DRIVER_CLASS)> *disp, DataManager *datamanager)
+PlotManager::PlotManager(Adafruit_GFX *disp, DataManager *datamanager)
     : _display(disp), _dataManager(datamanager) {}
 
 /**
- * @brief Renders the entire dashboard to the E-Paper display.
+ * @brief Vertical extent a widget may touch when drawn.
  *
- * This is the master rendering function. It performs the following steps:
- * 1. Prepares data histograms and scatter plots from the raw PetDataMap.
- * 2. Draws Interval and Duration histograms (bottom left).
- * 3. Draws the Weight ScatterPlot (main area).
- * 4. Draws the Status Bar (Battery, Update Time, Litterbox Status).
+ * Most widgets stay inside their box. Ring gauges are positioned by their center
+ * with w as the radius, and text labels put their baseline 12px below y, so both
+ * are widened accordingly. A small margin covers glyph overhang and outlines.
+ */
+WidgetSpan PlotManager::spanOf(const CompiledWidget &w)
+{
+    constexpr int16_t CULL_MARGIN = 4;
+    WidgetSpan span;
+    if (w.kind == WIDGET_RING_GAUGE)
+    {
+        int16_t below = w.w / 2 + 24; // label sits under the center
+        if (w.w > below)
+            below = w.w;
+        span.top = w.y - w.w;
+        span.bottom = w.y + below;
+    }
+    else if (w.kind == WIDGET_TEXT_LABEL)
+    {
+        span.top = w.y;
+        span.bottom = w.y + (w.h > 20 ? w.h : 20);
+    }
+    else
+    {
+        span.top = w.y;
+        span.bottom = w.y + w.h;
+    }
+    span.top -= CULL_MARGIN;
+    span.bottom += CULL_MARGIN;
+    return span;
+}
+
+/**
+ * @brief Builds the render model for one refresh.
+ *
+ * All data work happens here, exactly once: processing the pet and env series,
+ * reading the latest env sample, binning every histogram and computing every
+ * scatter plot's axis ranges. draw() then only issues drawing calls, which matters
+ * because the paged display replays it for every page band.
  *
  * @param pets Vector of Pet profiles.
- * @param allPetData Map of all historical pet data.
+ * @param allPetData Store of all historical pet data.
  * @param range The selected date range for the dashboard (7d, 30d, etc).
  * @param status The current status of the litterbox hardware.
  * @param vbat the measured battery voltage for display
  */
-void PlotManager::renderDashboard(const std::vector<SL_Pet> &pets, PetDataMap &allPetData, const DateRangeInfo &range, const SL_Status &status, float vbat)
+void PlotManager::prepare(const std::vector<SL_Pet> &pets, const PetDataStore &allPetData, const DateRangeInfo &range, const SL_Status &status, float vbat)
 {
-    //_display->fillScreen(EPD_LIGHTGREY);
+    uint32_t start = micros();
+    uint32_t heapBefore = ESP.getFreeHeap();
+    TextMetrics::beginFrame();
+    RenderModel &m = _model;
+    m = RenderModel();
+    m.range = range;
+    m.status = status;
+    m.vbat = vbat;
+    time(&m.now);
 
-    // 1. Process Data
-    DashboardData data = DataProcessor::process(pets, allPetData, range, _petColors);
+    int mv = analogReadMilliVolts(Config::Pins::BATTERY_ADC);
+    float v = (mv / 1000.0) * 2;
+    m.ringBatteryPercent = (v - 3.20) / (4.20 - 3.20) * 100.0;
+    if (m.ringBatteryPercent > 100)
+        m.ringBatteryPercent = 100;
+    if (m.ringBatteryPercent < 0)
+        m.ringBatteryPercent = 0;
 
-    // 1b. Process Env Data
-    std::vector<env_data> envRecords = _dataManager->getEnvData();
-    DashboardData envPlotData = DataProcessor::processEnvData(envRecords, range, _petColors);
+    // 1. Process Data, or bring this range's view from the card up to date
+    m.data = _processedCache.process(pets, allPetData, range, _petColors,
+                                     _dataManager->dataGeneration(), _dataManager->rewriteGeneration());
 
     // 2. Load Layout
-    std::vector<WidgetConfig> layout = _dataManager->loadLayout();
+    m.layout = &_dataManager->getLayout();
+    const std::vector<CompiledWidget> &layout = *m.layout;
 
-    // 3. Render Widgets
+    // 2b. Process Env Data, at the coarsest resolution that still fills the widest history plot
+    int envPixels = 0;
     for (const auto &w : layout)
     {
-        if (w.type == "ScatterPlot")
+        if (w.kind == WIDGET_SCATTER_PLOT && (w.source == SOURCE_TEMPERATURE_HISTORY || w.source == SOURCE_HUMIDITY_HISTORY) && w.w > envPixels)
+            envPixels = w.w;
+    }
+    if (envPixels > 0)
+    {
+        EnvTier tier = EnvStore::selectTier(range.seconds, envPixels);
+        std::vector<EnvAggregate> envHistory = _dataManager->getEnvHistory(tier, m.now - range.seconds);
+        m.envPlotData = DataProcessor::processEnvData(envHistory, range, _petColors);
+    }
+    m.haveEnv = _dataManager->getLatestEnvData(m.latestEnv);
+
+    // 3. Build the data-bound widgets. Series names point into m.data, which is not touched again.
+    m.slot.assign(layout.size(), -1);
+    m.spans.resize(layout.size());
+    ArenaVector<HistogramAccumulator> acc; // reused by every histogram
+    uint32_t histValues = 0, histBytes = 0, histUs = 0;
+    for (size_t i = 0; i < layout.size(); i++)
+    {
+        const CompiledWidget &w = layout[i];
+        m.spans[i] = spanOf(w);
+        if (w.kind == WIDGET_SCATTER_PLOT)
         {
-            ScatterPlot plot(_display, w.x, w.y, w.w, w.h, w.color);
+            m.slot[i] = m.scatterPlots.size();
+            m.scatterPlots.emplace_back(_display, w.x, w.y, w.w, w.h, w.color);
+            ScatterPlot &plot = m.scatterPlots.back();
             char titleBuf[64];
             // Format title with date range if requested, otherwise just use config title
-            if (w.title.indexOf("%s") >= 0)
-                snprintf(titleBuf, sizeof(titleBuf), w.title.c_str(), range.name);
+            if (strstr(w.title, "%s") != nullptr)
+                snprintf(titleBuf, sizeof(titleBuf), w.title, range.name);
             else
-                strncpy(titleBuf, w.title.c_str(), sizeof(titleBuf));
+                strncpy(titleBuf, w.title, sizeof(titleBuf));
 
             plot.setLabels(titleBuf, "Date", "Value"); // Generic Y label
             int xticks=8, yticks=8;
@@ -87,203 +159,314 @@ void PlotManager::renderDashboard(const std::vector<SL_Pet> &pets, PetDataMap &a
                     xticks = xticks / 2;
                 yticks = w.h / PIXELS_PER_TICK;
             }
-            if (w.dataSource == "scatter" || w.dataSource == "")
+            if (w.source == SOURCE_SCATTER)
             {
-                for (const auto &series : data.series)
+                for (const auto &series : m.data.series)
                 {
                     plot.addSeries(series.name.c_str(), series.scatterPoints, series.color, series.bgColor, xticks, yticks);
                 }
             }
-            else if (w.dataSource == "temperature_history")
+            else if (w.source == SOURCE_TEMPERATURE_HISTORY)
             {
                 // Add Temp from processed env data. Series 0 is Temp.
-                if (envPlotData.series.size() > 0)
+                if (m.envPlotData.series.size() > 0)
                 {
-                    const auto &s = envPlotData.series[0];
+                    const auto &s = m.envPlotData.series[0];
                     plot.addSeries(s.name.c_str(), s.scatterPoints, s.color, s.bgColor, xticks, 10);
                 }
             }
-            else if (w.dataSource == "humidity_history")
+            else if (w.source == SOURCE_HUMIDITY_HISTORY)
             {
                 // Add Humidity from processed env data. Series 1 is Humidity.
-                if (envPlotData.series.size() > 1)
+                if (m.envPlotData.series.size() > 1)
                 {
-                    const auto &s = envPlotData.series[1];
+                    const auto &s = m.envPlotData.series[1];
                     plot.addSeries(s.name.c_str(), s.scatterPoints, s.color, s.bgColor, xticks, 10);
                 }
             }
 
-            plot.draw();
+            plot.setDecimation((DecimationMode)w.decimation);
+            plot.prepare();
         }
-        else if (w.type == "Histogram")
+        else if (w.kind == WIDGET_HISTOGRAM)
         {
-            Histogram hist(_display, w.x, w.y, w.w, w.h, w.color);
-            hist.setTitle(w.title.c_str());
+            m.slot[i] = m.histograms.size();
+            m.histograms.emplace_back(_display, w.x, w.y, w.w, w.h, w.color);
+            Histogram &hist = m.histograms.back();
+            // Rollup ranges bin one mean per day and pet, not one value per visit
+            if (m.data.useRollups && w.title[0] &&
+                (w.source == SOURCE_INTERVAL || w.source == SOURCE_DURATION || w.source == SOURCE_WEIGHT))
+            {
+                char titleBuf[64];
+                snprintf(titleBuf, sizeof(titleBuf), "Daily Mean %s", w.title);
+                hist.setTitle(titleBuf);
+            }
+            else
+                hist.setTitle(w.title);
             hist.setNormalization(true);
 
+            int bins;
             if (w.p1 != 0)
-                hist.setBinCount(w.p1);
+                bins = w.p1;
             else
             {
                 if ((pets.size() == 1) && (w.w >= 400))
-                    hist.setBinCount(32);
+                    bins = 32;
                 else
-                    hist.setBinCount(14);
+                    bins = 14;
             }
-            for (const auto &series : data.series)
+            if (bins < 1)
+                bins = 1;
+            hist.setBinCount(bins);
+
+            uint32_t binStart = micros();
+            float minVal, maxVal;
+            histValues += DataProcessor::binHistogram(m.data, allPetData, (DataSourceId)w.source, bins, acc, minVal, maxVal);
+            histUs += micros() - binStart;
+            if (!acc.empty())
+                hist.setRange(minVal, maxVal);
+            for (size_t j = 0; j < acc.size(); j++)
             {
-                if (w.dataSource == "interval")
-                    hist.addSeries(series.name.c_str(), series.intervalValues, series.color, series.bgColor);
-                else if (w.dataSource == "duration")
-                    hist.addSeries(series.name.c_str(), series.durationValues, series.color, series.bgColor);
-                else if (w.dataSource == "weight")
-                    hist.addSeries(series.name.c_str(), series.weightValues, series.color, series.bgColor);
-                else if (w.dataSource == "weight_change")
-                    hist.addSeries(series.name.c_str(), series.deltaWeightValues, series.color, series.bgColor);
+                const ProcessedSeries &series = m.data.series[j];
+                hist.addBinnedSeries(series.name.c_str(), acc[j].bins(), acc[j].count(), series.color, series.bgColor);
+                histBytes += acc[j].bins().size() * sizeof(int);
             }
-            hist.plot();
+            hist.prepare();
         }
-        else if (w.type == "LinearGauge")
-        {
-            float val = 0;
+    }
+    Serial.printf("[PlotManager] Prepared %u widgets (%u plots, %u histograms) in %lu us, free heap %u -> %u\r\n",
+                  (unsigned)layout.size(), (unsigned)m.scatterPlots.size(), (unsigned)m.histograms.size(),
+                  (unsigned long)(micros() - start), (unsigned)heapBefore, (unsigned)ESP.getFreeHeap());
+    Serial.printf("[PlotManager] Histograms: %u values streamed into %u bytes of bins in %lu us (%u bytes as value vectors)\r\n",
+                  (unsigned)histValues, (unsigned)histBytes, (unsigned long)histUs, (unsigned)(histValues * sizeof(float)));
+}
+
+/**
+ * @brief Draws the prepared model into the current page band.
+ *
+ * Only drawing calls happen here; no data is processed or read from SD. Widgets
+ * whose extent does not overlap [bandTop, bandBottom) are skipped, since the
+ * display would clip everything they draw anyway.
+ *
+ * @param bandTop First screen row of the page being rendered.
+ * @param bandBottom One past the last screen row of the page.
+ * @return Number of widgets drawn.
+ */
+int PlotManager::draw(int16_t bandTop, int16_t bandBottom)
+{
+    const RenderModel &m = _model;
+    if (!m.layout)
+        return 0;
+    int drawn = 0;
+    PatternFill::setClip(bandTop, bandBottom);
+    for (size_t i = 0; i < m.layout->size(); i++)
+    {
+        if (m.spans[i].bottom <= bandTop || m.spans[i].top >= bandBottom)
+            continue;
+        drawWidget(i);
+        drawn++;
+    }
+    PatternFill::clearClip();
+    return drawn;
+}
+
+void PlotManager::release()
+{
+    _model = RenderModel();
+}
 
-            uint16_t color = EPD_BLACK;
+void PlotManager::markerStats(size_t &supplied, size_t &drawn) const
+{
+    supplied = 0;
+    drawn = 0;
+    for (const auto &plot : _model.scatterPlots)
+    {
+        supplied += plot.markersSupplied();
+        drawn += plot.markersDrawn();
+    }
+}
 
-            if (w.dataSource == "battery")
-            {
-                
-                // Simple percentage calc
-                val = (vbat - 3.20) / (4.10 - 3.20) * 100.0;
-                if (val > 100)
-                    val = 100;
-                if (val < 0)
-                    val = 0;
+void PlotManager::drawWidget(size_t i)
+{
+    const RenderModel &m = _model;
+    const CompiledWidget &w = (*m.layout)[i];
+    const SL_Status &status = m.status;
+
+    if (w.kind == WIDGET_SCATTER_PLOT)
+    {
+        _model.scatterPlots[m.slot[i]].draw();
+    }
+    else if (w.kind == WIDGET_HISTOGRAM)
+    {
+        _model.histograms[m.slot[i]].plot();
+    }
+    else if (w.kind == WIDGET_LINEAR_GAUGE)
+    {
+        float val = 0;
+
+        uint16_t color = EPD_BLACK;
+
+        if (w.source == SOURCE_BATTERY)
+        {
+            
+            // Simple percentage calc
+            val = (m.vbat - 3.20) / (4.10 - 3.20) * 100.0;
+            if (val > 100)
+                val = 100;
+            if (val < 0)
+                val = 0;
 
 #if (EPD_SELECT == 1002)
-                if (val > 80)
-                    color = EPD_GREEN;
-                else if (val > 20)
-                    color = EPD_YELLOW;
-                else
-                    color = EPD_RED;
+            if (val > 80)
+                color = EPD_GREEN;
+            else if (val > 20)
+                color = EPD_YELLOW;
+            else
+                color = EPD_RED;
 #endif
-            }
-            else if (w.dataSource == "litter")
-            {
-                val = status.litter_level_percent;
+        }
+        else if (w.source == SOURCE_LITTER)
+        {
+            val = status.litter_level_percent;
 #if (EPD_SELECT == 1002)
-                if (val > 80)
-                    color = EPD_GREEN;
-                else if (val > 60)
-                    color = EPD_YELLOW;
-                else
-                    color = EPD_RED;
+            if (val > 80)
+                color = EPD_GREEN;
+            else if (val > 60)
+                color = EPD_YELLOW;
+            else
+                color = EPD_RED;
 #endif
-            }
-            else if (w.dataSource == "waste")
-            {
-                val = status.waste_level_percent;
+        }
+        else if (w.source == SOURCE_WASTE)
+        {
+            val = status.waste_level_percent;
 #if (EPD_SELECT == 1002)
-                if (val < 30)
-                    color = EPD_GREEN;
-                else if (val > 80)
-                    color = EPD_RED;
-                else
-                    color = EPD_YELLOW;
+            if (val < 30)
+                color = EPD_GREEN;
+            else if (val > 80)
+                color = EPD_RED;
+            else
+                color = EPD_YELLOW;
 #endif
-            }
+        }
 
-            LinearGauge *gauge = nullptr;
+        LinearGauge *gauge = nullptr;
 
-            if (w.dataSource == "battery")
-            {
-                // Create BatteryGauge
-                BatteryGauge bg(_display, w.x, w.y, w.w, w.h, color, EPD_WHITE);
-                bg.setRange(w.min, w.max, w.unit);
-                bg.showLabel(true, w.title);
-                bg.draw(val);
-                int battRight = w.x + w.w;
-                const int16_t buttonTop = w.y + w.h / 3 - 1;
-                const int16_t buttonBottom = w.y + w.h - w.h / 3 + 1;
-                _display->drawLine(battRight, buttonTop, battRight, buttonBottom, EPD_BLACK); // three black lines to make the button top of battery
-                _display->drawLine(battRight + 1, buttonTop, battRight + 1, buttonBottom, EPD_BLACK);
-                _display->drawLine(battRight + 2, buttonTop, battRight + 2, buttonBottom, EPD_BLACK);
-
-                _display->drawLine(battRight - 1, buttonTop, battRight - 1, buttonBottom - 1, EPD_WHITE); // three white ones to erase a bit in the center
-                _display->drawLine(battRight, buttonTop, battRight, buttonBottom - 1, EPD_WHITE);
-                _display->drawLine(battRight + 1, buttonTop, battRight + 1, buttonBottom - 1, EPD_WHITE);
-            }
-            else
-            {
-                // Create Standard LinearGauge
-                LinearGauge lg(_display, w.x, w.y, w.w, w.h, color, EPD_WHITE);
-                lg.setRange(w.min, w.max, w.unit);
-                lg.showLabel(true, w.title);
-                lg.draw(val);
-            }
-        }
-        else if (w.type == "RingGauge")
+        if (w.source == SOURCE_BATTERY)
         {
-            float val = 0;
+            // Create BatteryGauge
+            BatteryGauge bg(_display, w.x, w.y, w.w, w.h, color, EPD_WHITE);
+            bg.setRange(w.min, w.max, w.unit);
+            bg.showLabel(true, w.title);
+            bg.draw(val);
+            int battRight = w.x + w.w;
+            const int16_t buttonTop = w.y + w.h / 3 - 1;
+            const int16_t buttonBottom = w.y + w.h - w.h / 3 + 1;
+            _display->drawLine(battRight, buttonTop, battRight, buttonBottom, EPD_BLACK); // three black lines to make the button top of battery
+            _display->drawLine(battRight + 1, buttonTop, battRight + 1, buttonBottom, EPD_BLACK);
+            _display->drawLine(battRight + 2, buttonTop, battRight + 2, buttonBottom, EPD_BLACK);
 
-            uint16_t color = w.color;
+            _display->drawLine(battRight - 1, buttonTop, battRight - 1, buttonBottom - 1, EPD_WHITE); // three white ones to erase a bit in the center
+            _display->drawLine(battRight, buttonTop, battRight, buttonBottom - 1, EPD_WHITE);
+            _display->drawLine(battRight + 1, buttonTop, battRight + 1, buttonBottom - 1, EPD_WHITE);
+        }
+        else
+        {
+            // Create Standard LinearGauge
+            LinearGauge lg(_display, w.x, w.y, w.w, w.h, color, EPD_WHITE);
+            lg.setRange(w.min, w.max, w.unit);
+            lg.showLabel(true, w.title);
+            lg.draw(val);
+        }
+    }
+    else if (w.kind == WIDGET_RING_GAUGE)
+    {
+        float val = 0;
 
-            if (w.dataSource == "battery")
-            {
-                int mv = analogReadMilliVolts(Config::Pins::BATTERY_ADC);
-                float v = (mv / 1000.0) * 2;
-                // Simple percentage calc
-                val = (v - 3.20) / (4.20 - 3.20) * 100.0;
-                if (val > 100)
-                    val = 100;
-                if (val < 0)
-                    val = 0;
-            }
-            else if (w.dataSource == "litter")
-            {
-                val = status.litter_level_percent;
-            }
-            else if (w.dataSource == "waste")
-            {
-                val = status.waste_level_percent;
-            }
+        uint16_t color = w.color;
 
-            RingGauge rg(_display, w.x, w.y, w.w, w.h, color, EPD_WHITE);
-            rg.setRange(w.min, w.max, w.unit);
-            rg.setAngleRange(w.p1, w.p2);
-            rg.showLabel(true, w.title);
-            rg.draw(val);
+        if (w.source == SOURCE_BATTERY)
+        {
+            val = m.ringBatteryPercent;
+        }
+        else if (w.source == SOURCE_LITTER)
+        {
+            val = status.litter_level_percent;
         }
-        else if (w.type == "TextLabel")
+        else if (w.source == SOURCE_WASTE)
         {
-            TextLabel label(_display, w.x, w.y, w.w, w.h, w.color, EPD_WHITE);
-            label.setFormat(w.title.length() > 0 ? w.title : "%m/%d %H:%M");
+            val = status.waste_level_percent;
+        }
 
-            if (w.dataSource == "datetime")
-            {
-                time_t now;
-                time(&now);
-                label.draw(now);
-            }
-            else if (w.dataSource == "temperature" && !envRecords.empty())
-            {
-                char buf[16];
-                snprintf(buf, sizeof(buf), "%.1f C", envRecords.back().temperature);
-                label.setFormat(buf);
-                label.draw(envRecords.back().temperature);
-            }
-            else if (w.dataSource == "humidity" && !envRecords.empty())
-            {
-                char buf[16];
-                snprintf(buf, sizeof(buf), "%.0f%%", envRecords.back().humidity);
-                label.setFormat(buf);
-                label.draw(envRecords.back().humidity);
-            }
+        RingGauge rg(_display, w.x, w.y, w.w, w.h, color, EPD_WHITE);
+        rg.setRange(w.min, w.max, w.unit);
+        rg.setAngleRange(w.p1, w.p2);
+        rg.showLabel(true, w.title);
+        rg.draw(val);
+    }
+    else if (w.kind == WIDGET_TEXT_LABEL)
+    {
+        TextLabel label(_display, w.x, w.y, w.w, w.h, w.color, EPD_WHITE);
+        label.setFormat(w.title[0] ? w.title : "%m/%d %H:%M");
+
+        if (w.source == SOURCE_DATETIME)
+        {
+            label.draw(m.now);
         }
-        else if (w.type == "StatusBox")
+        else if (w.source == SOURCE_TEMPERATURE && m.haveEnv)
         {
-            StatusBox box(_display, w.x, w.y, w.w, w.h);
-            box.draw(status);
+            char buf[16];
+            snprintf(buf, sizeof(buf), "%.1f C", m.latestEnv.temperature);
+            label.setFormat(buf);
+            label.draw(m.latestEnv.temperature);
         }
+        else if (w.source == SOURCE_HUMIDITY && m.haveEnv)
+        {
+            char buf[16];
+            snprintf(buf, sizeof(buf), "%.0f%%", m.latestEnv.humidity);
+            label.setFormat(buf);
+            label.draw(m.latestEnv.humidity);
+        }
+    }
+    else if (w.kind == WIDGET_STATUS_BOX)
+    {
+        StatusBox box(_display, w.x, w.y, w.w, w.h);
+        box.draw(status);
+    }
+}
+
+#ifdef RENDER_PROFILE
+/**
+ * @brief Draws the prepared model into a capture canvas one widget at a time.
+ *
+ * prepare() must have been called with the canvas as the display. Logs the draw
+ * time and pixel writes of every widget, then the frame totals and checksum.
+ */
+void PlotManager::profile(CaptureCanvas &canvas)
+{
+    const RenderModel &m = _model;
+    if (!m.layout)
+        return;
+    uint32_t totalUs = 0, totalWrites = 0;
+    canvas.fillScreen(EPD_WHITE);
+    for (size_t i = 0; i < m.layout->size(); i++)
+    {
+        const CompiledWidget &w = (*m.layout)[i];
+        canvas.resetPixelWrites();
+        uint32_t start = micros();
+        drawWidget(i);
+        uint32_t us = micros() - start;
+        totalUs += us;
+        totalWrites += canvas.pixelWrites();
+        Serial.printf("[Profile] #%u kind %u source %u '%s' at %d,%d %dx%d: %lu us, %lu pixel writes\r\n",
+                      (unsigned)i, w.kind, w.source, w.title, w.x, w.y, w.w, w.h,
+                      (unsigned long)us, (unsigned long)canvas.pixelWrites());
     }
-}
\ No newline at end of file
+    Serial.printf("[Profile] %u widgets: %lu us, %lu pixel writes, frame checksum %08lx\r\n",
+                  (unsigned)m.layout->size(), (unsigned long)totalUs, (unsigned long)totalWrites,
+                  (unsigned long)canvas.checksum());
+    size_t supplied, drawn;
+    markerStats(supplied, drawn);
+    Serial.printf("[Profile] scatter markers: %u drawn of %u points supplied\r\n", (unsigned)drawn, (unsigned)supplied);
+}
+#endif
@@ -0,0 +1,659 @@
+#include "ui/PngImage.h"
+
+static const uint8_t SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+static constexpr size_t CHUNK_BYTES = 8192; // IDAT chunk size when writing
+static constexpr uint16_t MAX_MATCH = 258;
+
+// Deflate length and distance codes (RFC 1951, 3.2.5)
+static const uint16_t LENGTH_BASE[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                         35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                         3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t DIST_BASE[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129,
+                                       193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097,
+                                       6145, 8193, 12289, 16385, 24577};
+static const uint8_t DIST_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+                                       6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+static uint32_t crc32Update(uint32_t crc, const uint8_t *data, size_t len)
+{
+    static uint32_t table[256];
+    static bool ready = false;
+    if (!ready)
+    {
+        for (uint32_t n = 0; n < 256; n++)
+        {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[n] = c;
+        }
+        ready = true;
+    }
+    for (size_t i = 0; i < len; i++)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+static void putBE32(uint8_t *p, uint32_t v)
+{
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static uint32_t getBE32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+// ---------------------------------------------------------------------------
+// Writer
+
+PngWriter::~PngWriter()
+{
+    release();
+}
+
+void PngWriter::release()
+{
+    free(_rows);
+    free(_out);
+    _rows = nullptr;
+    _out = nullptr;
+}
+
+void PngWriter::writeChunk(const char *type, const uint8_t *data, size_t len)
+{
+    uint8_t head[8];
+    putBE32(head, len);
+    memcpy(head + 4, type, 4);
+    uint32_t crc = crc32Update(0xFFFFFFFFu, head + 4, 4);
+    crc = crc32Update(crc, data, len) ^ 0xFFFFFFFFu;
+    uint8_t tail[4];
+    putBE32(tail, crc);
+    _ok = _ok && _file->write(head, 8) == 8;
+    _ok = _ok && (len == 0 || _file->write(data, len) == len);
+    _ok = _ok && _file->write(tail, 4) == 4;
+}
+
+bool PngWriter::begin(File &file, uint16_t width, uint16_t height, const uint8_t *palette, uint16_t paletteSize)
+{
+    release();
+    _file = &file;
+    _width = width;
+    _height = height;
+    _row = 0;
+    _outLen = 0;
+    _bits = 0;
+    _bitCount = 0;
+    _adlerA = 1;
+    _adlerB = 0;
+    _rows = (uint8_t *)malloc(2 * ((size_t)width + 1));
+    _out = (uint8_t *)malloc(CHUNK_BYTES);
+    _ok = _rows && _out && width > 0 && height > 0 && paletteSize > 0 && paletteSize <= 256;
+    if (!_ok)
+        return false;
+
+    _ok = file.write(SIGNATURE, sizeof(SIGNATURE)) == sizeof(SIGNATURE);
+    uint8_t ihdr[13];
+    putBE32(ihdr, width);
+    putBE32(ihdr + 4, height);
+    ihdr[8] = 8;  // bit depth
+    ihdr[9] = 3;  // palette
+    ihdr[10] = 0; // deflate
+    ihdr[11] = 0; // adaptive filtering
+    ihdr[12] = 0; // not interlaced
+    writeChunk("IHDR", ihdr, sizeof(ihdr));
+    writeChunk("PLTE", palette, (size_t)paletteSize * 3);
+
+    // zlib header (deflate, 32K window, fastest), then the one final fixed-Huffman block
+    putByte(0x78);
+    putByte(0x01);
+    putBits(1, 1);
+    putBits(1, 2);
+    return _ok;
+}
+
+void PngWriter::putByte(uint8_t b)
+{
+    _out[_outLen++] = b;
+    if (_outLen == CHUNK_BYTES)
+        flushData();
+}
+
+void PngWriter::flushData()
+{
+    if (_outLen)
+        writeChunk("IDAT", _out, _outLen);
+    _outLen = 0;
+}
+
+// Deflate packs bits from the least significant end
+void PngWriter::putBits(uint32_t value, int count)
+{
+    _bits |= value << _bitCount;
+    _bitCount += count;
+    while (_bitCount >= 8)
+    {
+        putByte(_bits & 0xFF);
+        _bits >>= 8;
+        _bitCount -= 8;
+    }
+}
+
+// Huffman codes are sent most significant bit first
+void PngWriter::putCode(uint16_t code, int length)
+{
+    uint16_t reversed = 0;
+    for (int i = 0; i < length; i++)
+        reversed |= ((code >> i) & 1) << (length - 1 - i);
+    putBits(reversed, length);
+}
+
+// Fixed Huffman code of a literal/length symbol
+void PngWriter::putLiteral(uint16_t symbol)
+{
+    if (symbol < 144)
+        putCode(0x30 + symbol, 8);
+    else if (symbol < 256)
+        putCode(0x190 + symbol - 144, 9);
+    else if (symbol < 280)
+        putCode(symbol - 256, 7);
+    else
+        putCode(0xC0 + symbol - 280, 8);
+}
+
+void PngWriter::putMatch(uint16_t length, uint16_t distance)
+{
+    int l = 28;
+    while (LENGTH_BASE[l] > length)
+        l--;
+    putLiteral(257 + l);
+    putBits(length - LENGTH_BASE[l], LENGTH_EXTRA[l]);
+    int d = 29;
+    while (DIST_BASE[d] > distance)
+        d--;
+    putCode(d, 5);
+    putBits(distance - DIST_BASE[d], DIST_EXTRA[d]);
+}
+
+/**
+ * @brief Compresses one row (filter type 0) against itself and the row above.
+ *
+ * Each position takes the longer of a run of the previous byte and a copy of the
+ * byte above; anything shorter than 3 bytes goes out as a literal.
+ */
+bool PngWriter::writeRow(const uint8_t *indices)
+{
+    if (!_ok || _row >= _height)
+        return _ok = false;
+    size_t rowLen = (size_t)_width + 1;
+    uint8_t *cur = _rows + rowLen;
+    cur[0] = 0;
+    memcpy(cur + 1, indices, _width);
+    for (size_t i = 0; i < rowLen; i++)
+    {
+        _adlerA = (_adlerA + cur[i]) % 65521;
+        _adlerB = (_adlerB + _adlerA) % 65521;
+    }
+
+    // _rows holds [previous row | current row]; distances reach back into the first
+    // half only once a previous row has been sent
+    size_t start = _row ? 0 : rowLen;
+    size_t end = 2 * rowLen;
+    for (size_t i = rowLen; i < end;)
+    {
+        size_t limit = end - i < MAX_MATCH ? end - i : MAX_MATCH;
+        size_t bestLen = 0, bestDist = 0;
+        const size_t dists[2] = {1, rowLen};
+        for (size_t dist : dists)
+        {
+            if (i < start + dist || dist > 32768)
+                continue;
+            size_t n = 0;
+            while (n < limit && _rows[i + n] == _rows[i + n - dist])
+                n++;
+            if (n > bestLen)
+            {
+                bestLen = n;
+                bestDist = dist;
+            }
+        }
+        if (bestLen >= 3)
+        {
+            putMatch(bestLen, bestDist);
+            i += bestLen;
+        }
+        else
+            putLiteral(_rows[i++]);
+    }
+    memcpy(_rows, cur, rowLen);
+    _row++;
+    return _ok;
+}
+
+bool PngWriter::end()
+{
+    if (!_rows)
+        return false;
+    _ok = _ok && _row == _height;
+    putLiteral(256); // end of block
+    if (_bitCount)
+        putBits(0, 8 - _bitCount);
+    uint8_t adler[4];
+    putBE32(adler, (_adlerB << 16) | _adlerA);
+    for (uint8_t b : adler)
+        putByte(b);
+    flushData();
+    writeChunk("IEND", nullptr, 0);
+    release();
+    return _ok;
+}
+
+// ---------------------------------------------------------------------------
+// Reader
+
+namespace
+{
+    struct Huffman
+    {
+        int16_t count[16];
+        int16_t symbol[288];
+    };
+
+    // Inflate over whole buffers, after Mark Adler's puff
+    class Inflater
+    {
+    public:
+        Inflater(const uint8_t *in, size_t inLen, uint8_t *out, size_t outLen)
+            : _in(in), _inLen(inLen), _out(out), _outLen(outLen) {}
+
+        // True if the zlib stream decoded to exactly outLen bytes
+        bool run()
+        {
+            if (_inLen < 2 || (_in[0] & 0x0F) != 8 || ((_in[0] << 8) | _in[1]) % 31 != 0 || (_in[1] & 0x20))
+                return false;
+            _inPos = 2;
+            bool last;
+            do
+            {
+                last = bits(1);
+                uint32_t type = bits(2);
+                if (type == 0)
+                    stored();
+                else if (type == 1)
+                    fixed();
+                else if (type == 2)
+                    dynamic();
+                else
+                    _error = true;
+            } while (!last && !_error);
+            return !_error && _outPos == _outLen;
+        }
+
+    private:
+        const uint8_t *_in;
+        size_t _inLen;
+        size_t _inPos = 0;
+        uint8_t *_out;
+        size_t _outLen;
+        size_t _outPos = 0;
+        uint32_t _bitBuf = 0;
+        int _bitCount = 0;
+        bool _error = false;
+
+        uint32_t bits(int need)
+        {
+            uint32_t val = _bitBuf;
+            while (_bitCount < need)
+            {
+                if (_inPos == _inLen)
+                {
+                    _error = true;
+                    return 0;
+                }
+                val |= (uint32_t)_in[_inPos++] << _bitCount;
+                _bitCount += 8;
+            }
+            _bitBuf = val >> need;
+            _bitCount -= need;
+            return val & ((1u << need) - 1);
+        }
+
+        void put(uint8_t b)
+        {
+            if (_outPos == _outLen)
+                _error = true;
+            else
+                _out[_outPos++] = b;
+        }
+
+        void stored()
+        {
+            _bitBuf = 0;
+            _bitCount = 0;
+            if (_inPos + 4 > _inLen)
+            {
+                _error = true;
+                return;
+            }
+            uint16_t len = _in[_inPos] | (_in[_inPos + 1] << 8);
+            uint16_t nlen = _in[_inPos + 2] | (_in[_inPos + 3] << 8);
+            _inPos += 4;
+            if (len != (uint16_t)~nlen || _inPos + len > _inLen)
+            {
+                _error = true;
+                return;
+            }
+            while (len-- && !_error)
+                put(_in[_inPos++]);
+        }
+
+        static bool build(Huffman &h, const uint8_t *lengths, int n)
+        {
+            memset(h.count, 0, sizeof(h.count));
+            for (int i = 0; i < n; i++)
+                h.count[lengths[i]]++;
+            int left = 1;
+            for (int len = 1; len < 16; len++)
+            {
+                left = (left << 1) - h.count[len];
+                if (left < 0)
+                    return false; // over-subscribed
+            }
+            int16_t offs[16];
+            offs[1] = 0;
+            for (int len = 1; len < 15; len++)
+                offs[len + 1] = offs[len] + h.count[len];
+            for (int i = 0; i < n; i++)
+                if (lengths[i])
+                    h.symbol[offs[lengths[i]]++] = i;
+            return true;
+        }
+
+        int decode(const Huffman &h)
+        {
+            int code = 0, first = 0, index = 0;
+            for (int len = 1; len < 16; len++)
+            {
+                code |= bits(1);
+                if (_error)
+                    return -1;
+                int count = h.count[len];
+                if (code - count < first)
+                    return h.symbol[index + (code - first)];
+                index += count;
+                first = (first + count) << 1;
+                code <<= 1;
+            }
+            return -1;
+        }
+
+        void codes(const Huffman &lencode, const Huffman &distcode)
+        {
+            while (!_error)
+            {
+                int symbol = decode(lencode);
+                if (symbol < 0)
+                    break;
+                if (symbol < 256)
+                {
+                    put(symbol);
+                    continue;
+                }
+                if (symbol == 256)
+                    return;
+                symbol -= 257;
+                if (symbol >= 29)
+                    break;
+                size_t len = LENGTH_BASE[symbol] + bits(LENGTH_EXTRA[symbol]);
+                int dsym = decode(distcode);
+                if (dsym < 0 || dsym >= 30)
+                    break;
+                size_t dist = DIST_BASE[dsym] + bits(DIST_EXTRA[dsym]);
+                if (dist > _outPos)
+                    break;
+                while (len-- && !_error)
+                    put(_out[_outPos - dist]);
+            }
+            _error = true;
+        }
+
+        void fixed()
+        {
+            static Huffman lencode, distcode;
+            static bool ready = false;
+            if (!ready)
+            {
+                uint8_t lengths[288];
+                int i = 0;
+                for (; i < 144; i++)
+                    lengths[i] = 8;
+                for (; i < 256; i++)
+                    lengths[i] = 9;
+                for (; i < 280; i++)
+                    lengths[i] = 7;
+                for (; i < 288; i++)
+                    lengths[i] = 8;
+                build(lencode, lengths, 288);
+                for (i = 0; i < 30; i++)
+                    lengths[i] = 5;
+                build(distcode, lengths, 30);
+                ready = true;
+            }
+            codes(lencode, distcode);
+        }
+
+        void dynamic()
+        {
+            static const uint8_t ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+            int nlen = bits(5) + 257;
+            int ndist = bits(5) + 1;
+            int ncode = bits(4) + 4;
+            if (_error || nlen > 286 || ndist > 30)
+            {
+                _error = true;
+                return;
+            }
+            uint8_t lengths[320] = {};
+            for (int i = 0; i < ncode; i++)
+                lengths[ORDER[i]] = bits(3);
+            Huffman lencode, distcode;
+            if (!build(lencode, lengths, 19))
+            {
+                _error = true;
+                return;
+            }
+            int index = 0;
+            while (index < nlen + ndist && !_error)
+            {
+                int symbol = decode(lencode);
+                if (symbol < 0)
+                    break;
+                if (symbol < 16)
+                {
+                    lengths[index++] = symbol;
+                    continue;
+                }
+                uint8_t len = 0;
+                int repeat;
+                if (symbol == 16)
+                {
+                    if (index == 0)
+                        break;
+                    len = lengths[index - 1];
+                    repeat = 3 + bits(2);
+                }
+                else if (symbol == 17)
+                    repeat = 3 + bits(3);
+                else
+                    repeat = 11 + bits(7);
+                if (index + repeat > nlen + ndist)
+                    break;
+                while (repeat--)
+                    lengths[index++] = len;
+            }
+            if (_error || index != nlen + ndist || lengths[256] == 0 ||
+                !build(lencode, lengths, nlen) || !build(distcode, lengths + nlen, ndist))
+            {
+                _error = true;
+                return;
+            }
+            codes(lencode, distcode);
+        }
+    };
+}
+
+PngReader::~PngReader()
+{
+    if (_pixels)
+        heap_caps_free(_pixels);
+}
+
+/**
+ * @brief Reads the chunks, inflates the image data and undoes the row filters.
+ *
+ * The compressed data and the image are held in PSRAM while decoding.
+ */
+bool PngReader::read(File &file)
+{
+    if (_pixels)
+        heap_caps_free(_pixels);
+    _pixels = nullptr;
+    _width = _height = 0;
+
+    uint8_t head[8];
+    if (file.read(head, 8) != 8 || memcmp(head, SIGNATURE, 8) != 0)
+        return false;
+    size_t capacity = file.size();
+    uint8_t *data = (uint8_t *)heap_caps_malloc(capacity ? capacity : 1, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!data)
+        return false;
+
+    size_t dataLen = 0;
+    bool header = false, ok = true;
+    while (ok)
+    {
+        if (file.read(head, 8) != 8)
+        {
+            ok = false;
+            break;
+        }
+        uint32_t len = getBE32(head);
+        const uint8_t *type = head + 4;
+        if (!memcmp(type, "IEND", 4))
+            break;
+        if (!memcmp(type, "IDAT", 4))
+        {
+            ok = dataLen + len <= capacity && file.read(data + dataLen, len) == len;
+            dataLen += len;
+        }
+        else if (!memcmp(type, "IHDR", 4) || !memcmp(type, "PLTE", 4))
+        {
+            uint8_t chunk[768];
+            ok = len <= sizeof(chunk) && file.read(chunk, len) == len;
+            if (ok && type[0] == 'I')
+            {
+                static const uint8_t CHANNELS[7] = {1, 0, 3, 1, 2, 0, 4};
+                uint32_t w = getBE32(chunk), h = getBE32(chunk + 4);
+                _colorType = chunk[9];
+                ok = len == 13 && w > 0 && h > 0 && w <= 0xFFFF && h <= 0xFFFF && chunk[8] == 8 &&
+                     _colorType < 7 && CHANNELS[_colorType] && chunk[12] == 0;
+                _width = w;
+                _height = h;
+                _channels = ok ? CHANNELS[_colorType] : 0;
+                header = ok;
+            }
+            else if (ok)
+                memcpy(_palette, chunk, len);
+        }
+        else
+            ok = file.seek(len, SeekCur);
+        uint8_t crc[4]; // not checked
+        ok = ok && file.read(crc, 4) == 4;
+    }
+
+    if (ok && header)
+    {
+        size_t rawLen = stride() * _height;
+        _pixels = (uint8_t *)heap_caps_malloc(rawLen, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        ok = _pixels && Inflater(data, dataLen, _pixels, rawLen).run() && unfilter();
+    }
+    heap_caps_free(data);
+    if (!ok || !header)
+    {
+        if (_pixels)
+            heap_caps_free(_pixels);
+        _pixels = nullptr;
+        _width = _height = 0;
+        return false;
+    }
+    return true;
+}
+
+bool PngReader::unfilter()
+{
+    size_t rowBytes = stride() - 1;
+    const int bpp = _channels;
+    for (uint16_t y = 0; y < _height; y++)
+    {
+        uint8_t *row = _pixels + y * stride();
+        uint8_t filter = row[0];
+        uint8_t *p = row + 1;
+        const uint8_t *up = y ? p - stride() : nullptr;
+        for (size_t i = 0; i < rowBytes; i++)
+        {
+            int a = i >= (size_t)bpp ? p[i - bpp] : 0;
+            int b = up ? up[i] : 0;
+            int c = up && i >= (size_t)bpp ? up[i - bpp] : 0;
+            switch (filter)
+            {
+            case 0:
+                break;
+            case 1:
+                p[i] += a;
+                break;
+            case 2:
+                p[i] += b;
+                break;
+            case 3:
+                p[i] += (a + b) / 2;
+                break;
+            case 4:
+            {
+                int pa = abs(b - c), pb = abs(a - c), pc = abs(a + b - 2 * c);
+                p[i] += (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+                break;
+            }
+            default:
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void PngReader::rgbRow(uint16_t y, uint8_t *out) const
+{
+    if (!_pixels || y >= _height)
+        return;
+    const uint8_t *p = _pixels + y * stride() + 1;
+    for (uint16_t x = 0; x < _width; x++, p += _channels, out += 3)
+    {
+        switch (_colorType)
+        {
+        case 0: // gray
+        case 4: // gray + alpha
+            out[0] = out[1] = out[2] = p[0];
+            break;
+        case 3: // palette
+            memcpy(out, _palette[p[0]], 3);
+            break;
+        default: // RGB, RGB + alpha
+            memcpy(out, p, 3);
+            break;
+        }
+    }
+}
@@ -0,0 +1,210 @@
+#include "ui/ProcessedCache.h"
+#include "ui/DataProcessor.h"
+#include "ui/LayoutCompiler.h"
+
+ProcessedCache::ProcessedCache(const char *dir) : _dir(dir) {}
+
+String ProcessedCache::path(const DateRangeInfo &range) const
+{
+    char name[20];
+    snprintf(name, sizeof(name), "/range%d.bin", (int)range.type);
+    return _dir + name;
+}
+
+ProcessedCacheHeader ProcessedCache::keyOf(const std::vector<SL_Pet> &pets, const DateRangeInfo &range,
+                                           const std::vector<ColorPair> &colors, uint32_t generation)
+{
+    ProcessedCacheHeader key;
+    memset(&key, 0, sizeof(key));
+    key.magic = ProcessedCacheFormat::MAGIC;
+    key.version = ProcessedCacheFormat::VERSION;
+    key.pointSize = sizeof(DataPoint);
+    key.generation = generation;
+    key.rangeSeconds = (int32_t)range.seconds;
+    key.rangeType = (uint8_t)range.type;
+    key.useRollups = range.useRollups ? 1 : 0;
+
+    uint32_t h = 2166136261u;
+    for (const auto &pet : pets)
+    {
+        int32_t id = pet.id.toInt();
+        h = LayoutCompiler::hash((const uint8_t *)&id, sizeof(id), h);
+        h = LayoutCompiler::hash((const uint8_t *)pet.name.c_str(), pet.name.length() + 1, h);
+    }
+    key.petsHash = h;
+    key.colorsHash = LayoutCompiler::hash((const uint8_t *)colors.data(), colors.size() * sizeof(ColorPair));
+    return key;
+}
+
+/**
+ * @brief Reads the cached view for a key, if it is there and matches.
+ *
+ * Everything but the generation must match. The series are matched up with the pets
+ * the way process() builds them (in pet order, one per pet the store has records
+ * for), which also restores their names; a pet that has gained records since the
+ * view was processed makes it a miss.
+ *
+ * @param generation Set to the generation the cached view is up to date with.
+ * @return true if data holds the cached view.
+ */
+bool ProcessedCache::read(const String &path, const ProcessedCacheHeader &key, const std::vector<SL_Pet> &pets,
+                          const PetDataStore &allPetData, DashboardData &data, uint32_t &generation)
+{
+    File file = SdCard::open(path, FILE_READ);
+    if (!file)
+        return false;
+
+    ProcessedCacheHeader h;
+    bool ok = file.read((uint8_t *)&h, sizeof(h)) == sizeof(h) &&
+              h.magic == key.magic && h.version == key.version && h.pointSize == key.pointSize &&
+              h.rangeSeconds == key.rangeSeconds && h.rangeType == key.rangeType && h.useRollups == key.useRollups &&
+              h.petsHash == key.petsHash && h.colorsHash == key.colorsHash &&
+              h.seriesCount <= ProcessedCacheFormat::MAX_SERIES;
+    data.timeStart = h.timeStart;
+    data.useRollups = h.useRollups != 0;
+
+    size_t next = 0; // index into pets
+    for (uint8_t i = 0; ok && i < h.seriesCount; i++)
+    {
+        ProcessedCacheSeries s;
+        ok = file.read((uint8_t *)&s, sizeof(s)) == sizeof(s) &&
+             (size_t)file.available() >= (size_t)s.pointCount * sizeof(DataPoint);
+        if (!ok)
+            break;
+        while (next < pets.size() && allPetData.find(pets[next].id.toInt()) == nullptr)
+            next++;
+        if (next == pets.size() || pets[next].id.toInt() != s.petId)
+        {
+            ok = false;
+            break;
+        }
+
+        data.series.emplace_back();
+        ProcessedSeries &series = data.series.back();
+        series.name = pets[next].name;
+        series.petId = s.petId;
+        series.color = s.color;
+        series.bgColor = s.bgColor;
+        series.lastSource = (time_t)s.lastSource;
+        series.scatterPoints.resize(s.pointCount);
+        size_t bytes = s.pointCount * sizeof(DataPoint);
+        ok = bytes == 0 || file.read((uint8_t *)series.scatterPoints.data(), bytes) == bytes;
+        next++;
+    }
+    file.close();
+
+    for (; ok && next < pets.size(); next++)
+    {
+        if (allPetData.find(pets[next].id.toInt()) != nullptr)
+            ok = false;
+    }
+    if (!ok)
+    {
+        data = DashboardData();
+        return false;
+    }
+    generation = h.generation;
+    return true;
+}
+
+bool ProcessedCache::write(const String &path, const ProcessedCacheHeader &key, const DashboardData &data)
+{
+    if (data.series.size() > ProcessedCacheFormat::MAX_SERIES)
+    {
+        SD.remove(path);
+        return false;
+    }
+    if (!SD.exists(_dir) && !SD.mkdir(_dir))
+    {
+        Serial.println("[ProcessedCache] Failed to create cache directory!");
+        return false;
+    }
+
+    ProcessedCacheHeader h = key;
+    h.seriesCount = (uint8_t)data.series.size();
+    h.timeStart = (uint32_t)data.timeStart;
+    File file = SdCard::open(path, FILE_WRITE);
+    if (!file)
+    {
+        Serial.println("[ProcessedCache] Failed to write cache!");
+        return false;
+    }
+
+    // A short write leaves counts the rest of the file can't satisfy, which read() rejects
+    size_t expected = sizeof(h);
+    size_t written = file.write((const uint8_t *)&h, sizeof(h));
+    for (const auto &series : data.series)
+    {
+        ProcessedCacheSeries s = {series.petId, series.color, series.bgColor, (uint32_t)series.lastSource,
+                                  (uint32_t)series.scatterPoints.size()};
+        size_t bytes = series.scatterPoints.size() * sizeof(DataPoint);
+        expected += sizeof(s) + bytes;
+        written += file.write((const uint8_t *)&s, sizeof(s));
+        if (bytes > 0)
+            written += file.write((const uint8_t *)series.scatterPoints.data(), bytes);
+    }
+    file.flush();
+    file.close();
+
+    if (written != expected)
+    {
+        Serial.println("[ProcessedCache] Short write, removing cache file.");
+        SD.remove(path);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Returns the processed pet view for a range, from the card where possible.
+ *
+ * A button wake only changes the range, and a refresh that fetched nothing new
+ * leaves the history as it was, so most views are already on the card. A view is
+ * reused as is when its generation is the current one, and extended with just the
+ * new records when every change since has been an append (the rewrite generation
+ * is not newer than the view). Either way the points that have fallen out of the
+ * range are dropped. Anything else is processed in full.
+ *
+ * @param generation Current SegmentStore::generation().
+ * @param rewriteGeneration Current SegmentStore::rewriteGeneration().
+ */
+DashboardData ProcessedCache::process(const std::vector<SL_Pet> &pets,
+                                      const PetDataStore &allPetData,
+                                      const DateRangeInfo &range,
+                                      const std::vector<ColorPair> &colors,
+                                      uint32_t generation,
+                                      uint32_t rewriteGeneration)
+{
+    uint32_t start = micros();
+    ProcessedCacheHeader key = keyOf(pets, range, colors, generation);
+    String file = path(range);
+    time_t timeStart = time(NULL) - range.seconds;
+
+    DashboardData data;
+    uint32_t cached = 0;
+    if (read(file, key, pets, allPetData, data, cached))
+    {
+        // Generations only count up (modulo 2^32) from wherever the manifest started
+        bool unchanged = cached == generation;
+        bool appended = (int32_t)(generation - cached) > 0 && (int32_t)(cached - rewriteGeneration) >= 0;
+        if ((unchanged || appended) && DataProcessor::extend(data, allPetData, timeStart))
+        {
+            if (appended)
+                write(file, key, data);
+            size_t points = 0;
+            for (const auto &series : data.series)
+                points += series.scatterPoints.size();
+            Serial.printf("[ProcessedCache] %s %s view (generation %u -> %u): %u points in %lu us\r\n",
+                          unchanged ? "Reused" : "Extended", range.name, cached, generation, (unsigned)points,
+                          (unsigned long)(micros() - start));
+            return data;
+        }
+        data = DashboardData();
+    }
+
+    data = DataProcessor::process(pets, allPetData, range, colors);
+    write(file, key, data);
+    Serial.printf("[ProcessedCache] Processed %s view in full (generation %u) in %lu us\r\n", range.name, generation,
+                  (unsigned long)(micros() - start));
+    return data;
+}
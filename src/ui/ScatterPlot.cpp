@@ -1,7 +1,11 @@
 // ScatterPlot.cpp
 
 #include "ui/ScatterPlot.h"
+#include "ui/TextMetrics.h"
+#include "ui/PatternFill.h"
 #include <time.h> // For timestamp formatting
+#include <algorithm>
+#include <math.h>
 #include <Fonts/FreeSans9pt7b.h>
 #include <Fonts/FreeSansBold12pt7b.h>
 #include <Fonts/FreeSansBold9pt7b.h>
@@ -13,10 +17,10 @@ const int MARGIN_LEFT = 26;
 const int MARGIN_RIGHT = 5;
 
 // Constructor: Initializes the plot with its position and a reference to the display
-ScatterPlot::ScatterPlot(GxEPD2_DISPLAY_CLASS<GxEPD2_DRIVER_CLASS, MAX_HEIGHT(GxEPD2_DRIVER_CLASS)> *disp, int x, int y, int width, int height, uint16_t color)
+ScatterPlot::ScatterPlot(Adafruit_GFX *disp, int x, int y, int width, int height, uint16_t color)
     : display(disp), _x(x), _y(y), _width(width), _height(height), _color(color) {}
 
-void ScatterPlot::addSeries(const String &name, const std::vector<DataPoint> &data, uint16_t color, uint16_t bgcolor, int xticks, int yticks)
+void ScatterPlot::addSeries(const String &name, const ArenaVector<DataPoint> &data, uint16_t color, uint16_t bgcolor, int xticks, int yticks)
 {
     _series.push_back({name, data, color, bgcolor});
     _xticks = xticks;
@@ -30,7 +34,13 @@ void ScatterPlot::setLabels(const String &title, const String &xLabel, const Str
     _yLabel = yLabel;
 }
 
-void ScatterPlot::draw()
+/**
+ * @brief Resolves colors and computes the axis ranges from the series.
+ *
+ * Called once per refresh; draw() can then be repeated for every page band without
+ * rescanning the data. draw() calls it itself if it has not been called.
+ */
+void ScatterPlot::prepare()
 {
 #if (EPD_SELECT == 1001) // do some translating of color settings
     if (_color == EPD_RED)
@@ -49,20 +59,20 @@ void ScatterPlot::draw()
     else if (_color == EPD_DARKGREY)
         _color = EPD_RED;
 #endif
-    // 1. Find min and max values for auto-scaling
-    display->setTextSize(1);
-    display->setFont(NULL);
-    display->setTextColor(EPD_BLACK);
-
+    _prepared = true;
+    _sprites.resize(_series.size());
+    for (size_t i = 0; i < _series.size(); i++)
+        _sprites[i].bake(_series[i].color, _series[i].background);
     if (_series.empty())
     {
-        drawAxes(0, 10, 0, 10);
-        drawLegend();
-        return; // Nothing to draw
+        _xMin = 0, _xMax = 10, _yMin = 0, _yMax = 10;
+        return;
     }
+
+    // 1. Find min and max values for auto-scaling
     float xMin = 1.0e38, xMax = -1.0e38, yMin = 1.0e38, yMax = -1.0e38;
 
-    auto findMinMax = [&](const std::vector<DataPoint> &data)
+    auto findMinMax = [&](const ArenaVector<DataPoint> &data)
     {
         for (const auto &p : data)
         {
@@ -108,13 +118,220 @@ void ScatterPlot::draw()
         yMin -= 1.0;
     }
     // yMin = 0;
+    _xMin = xMin, _xMax = xMax, _yMin = yMin, _yMax = yMax;
+    decimate();
+}
+
+int ScatterPlot::plotColumns() const
+{
+    return _width - MARGIN_LEFT - MARGIN_RIGHT;
+}
+
+int ScatterPlot::plotRows() const
+{
+    return _height - MARGIN_TOP - MARGIN_BOTTOM;
+}
+
+/**
+ * @brief Thins every series to what can actually be told apart at the plot width.
+ *
+ * Runs at the end of prepare(), once the axis ranges (and so the pixel column of
+ * every point) are known. A series is only reduced when it holds more points than
+ * the mode keeps, so sparse plots are drawn exactly as before.
+ */
+void ScatterPlot::decimate()
+{
+    _rawPoints = 0;
+    for (const auto &s : _series)
+        _rawPoints += s.data.size();
+    int columns = plotColumns();
+    if (_decimation == DECIMATE_NONE || columns < 1)
+        return;
+
+    uint32_t start = micros();
+    size_t kept = 0;
+    for (auto &s : _series)
+    {
+        if (_decimation == DECIMATE_LTTB)
+            decimateLTTB(s.data, (size_t)columns * 2);
+        else
+            decimateMinMax(s.data, columns, _xMin, _xMax);
+        kept += s.data.size();
+    }
+    Serial.printf("[ScatterPlot] '%s': %u -> %u points (%s) in %lu us\r\n", _title.c_str(), (unsigned)_rawPoints,
+                  (unsigned)kept, _decimation == DECIMATE_LTTB ? "lttb" : "minmax", (unsigned long)(micros() - start));
+}
+
+/**
+ * @brief Keeps the lowest and highest point of every pixel column.
+ *
+ * Markers in one column only differ by their row, so the two extremes carry every
+ * outlier the plot can show. Points are kept in their original order.
+ *
+ * @param data Series points, reduced in place.
+ * @param columns Plot area width in pixels.
+ * @param xMin X value at the left edge of the plot area.
+ * @param xMax X value at the right edge of the plot area.
+ */
+void ScatterPlot::decimateMinMax(ArenaVector<DataPoint> &data, int columns, float xMin, float xMax)
+{
+    if (data.size() <= (size_t)columns)
+        return;
+
+    ArenaVector<int32_t> lo(columns, -1), hi(columns, -1);
+    const float xScale = columns / (xMax - xMin);
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        int c = (int)((data[i].x - xMin) * xScale);
+        if (c < 0)
+            c = 0;
+        if (c >= columns)
+            c = columns - 1;
+        if (lo[c] < 0 || data[i].y < data[lo[c]].y)
+            lo[c] = i;
+        if (hi[c] < 0 || data[i].y > data[hi[c]].y)
+            hi[c] = i;
+    }
+
+    ArenaVector<int32_t> keep;
+    keep.reserve(columns * 2);
+    for (int c = 0; c < columns; c++)
+    {
+        if (lo[c] < 0)
+            continue;
+        keep.push_back(lo[c]);
+        if (hi[c] != lo[c])
+            keep.push_back(hi[c]);
+    }
+    std::sort(keep.begin(), keep.end());
+
+    ArenaVector<DataPoint> out;
+    out.reserve(keep.size());
+    for (int32_t i : keep)
+        out.push_back(data[i]);
+    data.swap(out);
+}
+
+/**
+ * @brief Largest-Triangle-Three-Buckets downsampling.
+ *
+ * The first and last points are kept; every bucket in between contributes the point
+ * forming the largest triangle with the previously kept point and the average of the
+ * next bucket. The series' lowest and highest points always win their bucket, so the
+ * outliers survive just as with the min/max mode.
+ *
+ * @param data Series points, sorted by x and reduced in place.
+ * @param threshold Number of points to keep.
+ */
+void ScatterPlot::decimateLTTB(ArenaVector<DataPoint> &data, size_t threshold)
+{
+    const size_t n = data.size();
+    if (threshold < 3 || n <= threshold)
+        return;
+
+    auto byX = [](const DataPoint &a, const DataPoint &b) { return a.x < b.x; };
+    if (!std::is_sorted(data.begin(), data.end(), byX))
+        std::stable_sort(data.begin(), data.end(), byX);
+
+    size_t minIdx = 0, maxIdx = 0;
+    for (size_t i = 1; i < n; i++)
+    {
+        if (data[i].y < data[minIdx].y)
+            minIdx = i;
+        if (data[i].y > data[maxIdx].y)
+            maxIdx = i;
+    }
+
+    ArenaVector<DataPoint> out;
+    out.reserve(threshold + 1);
+    out.push_back(data[0]);
+    const float every = (float)(n - 2) / (threshold - 2);
+    size_t a = 0;
+    for (size_t b = 0; b < threshold - 2; b++)
+    {
+        size_t first = (size_t)(b * every) + 1;
+        size_t last = (size_t)((b + 1) * every) + 1;
+        if (last > n - 1)
+            last = n - 1;
+        if (first >= last)
+            continue;
+
+        // Average of the next bucket (the last point for the final bucket)
+        size_t nextFirst = last;
+        size_t nextLast = (size_t)((b + 2) * every) + 1;
+        if (nextLast > n)
+            nextLast = n;
+        float avgX = data[n - 1].x, avgY = data[n - 1].y;
+        if (nextLast > nextFirst)
+        {
+            avgX = avgY = 0;
+            for (size_t j = nextFirst; j < nextLast; j++)
+            {
+                avgX += data[j].x;
+                avgY += data[j].y;
+            }
+            avgX /= (nextLast - nextFirst);
+            avgY /= (nextLast - nextFirst);
+        }
+
+        bool hasMin = minIdx >= first && minIdx < last;
+        bool hasMax = maxIdx >= first && maxIdx < last;
+        if (hasMin || hasMax)
+        {
+            size_t p = hasMin ? minIdx : maxIdx;
+            if (hasMin && hasMax && maxIdx != minIdx)
+            {
+                size_t q = minIdx < maxIdx ? maxIdx : minIdx;
+                p = minIdx < maxIdx ? minIdx : maxIdx;
+                out.push_back(data[p]);
+                p = q;
+            }
+            out.push_back(data[p]);
+            a = p;
+            continue;
+        }
+
+        // Triangle area is scaled by a constant in data units, so no pixel mapping is needed
+        const DataPoint &pa = data[a];
+        float bestArea = -1.0f;
+        size_t best = first;
+        for (size_t j = first; j < last; j++)
+        {
+            float area = fabsf((pa.x - avgX) * (data[j].y - pa.y) - (pa.x - data[j].x) * (avgY - pa.y));
+            if (area > bestArea)
+            {
+                bestArea = area;
+                best = j;
+            }
+        }
+        out.push_back(data[best]);
+        a = best;
+    }
+    out.push_back(data[n - 1]);
+    data.swap(out);
+}
+
+void ScatterPlot::draw()
+{
+    if (!_prepared)
+        prepare();
+    display->setTextSize(1);
+    display->setFont(NULL);
+    display->setTextColor(EPD_BLACK);
+
+    if (_series.empty())
+    {
+        drawAxes(_xMin, _xMax, _yMin, _yMax);
+        drawLegend();
+        return; // Nothing to draw
+    }
 
     // 2. Clear the plot area (fill with white)
     // display->fillRect(_x, _y, _width, _height, GxEPD_WHITE);
 
     // 3. Draw components
-    drawAxes(xMin, xMax, yMin, yMax);
-    plotDataPoints(xMin, xMax, yMin, yMax);
+    drawAxes(_xMin, _xMax, _yMin, _yMax);
+    plotDataPoints(_xMin, _xMax, _yMin, _yMax);
     drawLegend();
     // add_refresh_timestamp();
 }
@@ -127,9 +344,8 @@ void ScatterPlot::drawAxes(float xMin, float xMax, float yMin, float yMax)
     int plotAreaHeight = _height - MARGIN_TOP - MARGIN_BOTTOM;
 
     // drawCheckerRect(plotAreaX, plotAreaY, plotAreaWidth, plotAreaHeight,EPD_WHITE, EPD_DARKGREY);
-    display->fillRect(_x, _y, _width, _height, EPD_WHITE);
-    display->fillRect(plotAreaX, plotAreaY, plotAreaWidth, plotAreaHeight, EPD_WHITE);
-    display->fillRect(plotAreaX, _y, plotAreaWidth, MARGIN_TOP, _color);
+    PatternFill::fillRect(display, _x, _y, _width, _height, FILL_SOLID, EPD_WHITE, EPD_WHITE);
+    PatternFill::fillRect(display, plotAreaX, _y, plotAreaWidth, MARGIN_TOP, FILL_SOLID, _color, _color);
     display->drawRect(plotAreaX, _y, plotAreaWidth, MARGIN_TOP + 1, EPD_BLACK);
     display->drawRect(plotAreaX, plotAreaY, plotAreaWidth, plotAreaHeight, EPD_BLACK);
 
@@ -160,7 +376,7 @@ void ScatterPlot::drawAxes(float xMin, float xMax, float yMin, float yMax)
         uint16_t w = 0, h = 0;
         display->setFont(NULL);
         display->setTextSize(1);
-        display->getTextBounds(buffer, x, y, &x1, &y1, &w, &h);
+        TextMetrics::bounds(nullptr, buffer, x, y, &x1, &y1, &w, &h);
         display->setTextColor(EPD_BLACK);
         display->setCursor(plotAreaX - w - 1, yPos - h / 2); // Centered text
         display->print(buffer);
@@ -169,20 +385,20 @@ void ScatterPlot::drawAxes(float xMin, float xMax, float yMin, float yMax)
     // --- Draw X-Axis Ticks and Labels ---
     const int numXTicks = _xticks;
     time_t now = time(NULL);
-    struct tm *midnight_tomorrow = localtime(&now);
-    midnight_tomorrow->tm_hour = 0;
-    midnight_tomorrow->tm_min = 0;
-    midnight_tomorrow->tm_sec = 0;
-    time_t midnight = mktime(midnight_tomorrow) + (60.0 * 60.0 * 24.0);
+    struct tm midnight_tomorrow;
+    localtime_r(&now, &midnight_tomorrow);
+    midnight_tomorrow.tm_hour = 0;
+    midnight_tomorrow.tm_min = 0;
+    midnight_tomorrow.tm_sec = 0;
+    midnight_tomorrow.tm_isdst = -1;
+    time_t midnight = mktime(&midnight_tomorrow) + (60.0 * 60.0 * 24.0);
     float days_in_xrange = (xMax - xMin) / (60.0 * 60.0 * 24.0);
     float days_per_xtick = ceil(days_in_xrange / numXTicks);
     float seconds_per_xtick = days_per_xtick * (60.0 * 60.0 * 24.0);
     for (int i = numXTicks; i >= 0; --i)
     {
         time_t tickTime = midnight - (time_t)((float)i * seconds_per_xtick);
-        struct tm *thisticktime = localtime(&tickTime);
-        time_t adjustedticktime = mktime(thisticktime);
-        DataPoint tickpoint = {(float)adjustedticktime, 0.0};
+        DataPoint tickpoint = {(float)tickTime, 0.0};
         int xPos, yPos;
         mapPoint(tickpoint, xPos, yPos, xMin, xMax, yMin, yMax);
         if ((xPos < plotAreaX) || (xPos > plotAreaX + plotAreaWidth))
@@ -203,13 +419,14 @@ void ScatterPlot::drawAxes(float xMin, float xMax, float yMin, float yMax)
         // Convert timestamp to Month/Day format
         char buffer[10];
         // time_t tick_time = (time_t)labelVal;
-        struct tm *tm_info = localtime(&tickTime);
-        strftime(buffer, sizeof(buffer), "%m/%d", tm_info);
+        struct tm tm_info;
+        localtime_r(&tickTime, &tm_info);
+        strftime(buffer, sizeof(buffer), "%m/%d", &tm_info);
         int16_t x = plotAreaX, y = plotAreaY, x1 = 0, y1 = 0;
         uint16_t w = 0, h = 0;
         display->setFont(NULL);
         display->setTextSize(1);
-        display->getTextBounds(buffer, x, y, &x1, &y1, &w, &h);
+        TextMetrics::bounds(nullptr, buffer, x, y, &x1, &y1, &w, &h);
         display->setTextColor(EPD_BLACK);
         display->setCursor(xPos - w / 2, plotAreaY + plotAreaHeight + 2); // Centered text
         display->print(buffer);
@@ -220,7 +437,7 @@ void ScatterPlot::drawAxes(float xMin, float xMax, float yMin, float yMax)
     uint16_t w = 0, h = 0;
     display->setFont(&FreeSansBold9pt7b);
     display->setTextSize(0);
-    display->getTextBounds(_title.c_str(), x, y, &x1, &y1, &w, &h);
+    TextMetrics::bounds(&FreeSansBold9pt7b, _title.c_str(), x, y, &x1, &y1, &w, &h);
     display->setTextColor(EPD_WHITE);
     display->setCursor(_x + (_width - w) / 2, _y + MARGIN_TOP - h / 2 + 2); // Centered title
     display->print(_title);
@@ -241,18 +458,49 @@ void ScatterPlot::mapPoint(const DataPoint &p, int &screenX, int &screenY, float
     screenY = (plotAreaY + plotAreaHeight) - ((p.y - yMin) / (yMax - yMin)) * plotAreaHeight;
 }
 
+/**
+ * @brief Draws the markers of every series.
+ *
+ * Repeated readings often map to the same pixel. A marker whose center is already
+ * taken by its own series is skipped, since redrawing it would change nothing: the
+ * series are drawn one after another, so no other series can have covered it since.
+ */
 void ScatterPlot::plotDataPoints(float xMin, float xMax, float yMin, float yMax)
 {
+    uint32_t start = micros();
+    const int plotAreaX = _x + MARGIN_LEFT;
+    const int plotAreaY = _y + MARGIN_TOP;
+    const int columns = plotColumns();
+    const int rows = plotRows();
+    size_t bits = (columns > 0 && rows > 0) ? (size_t)columns * rows * _series.size() : 0;
+    _occupied.assign((bits + 31) / 32, 0);
+
+    size_t supplied = 0;
+    _markersDrawn = 0;
     // Loop over all series and plot their points
-    for (const auto &s : _series)
+    for (size_t si = 0; si < _series.size(); si++)
     {
+        const PlotSeries &s = _series[si];
         for (const auto &p : s.data)
         {
             int sx, sy;
             mapPoint(p, sx, sy, xMin, xMax, yMin, yMax);
-            drawMarker(sx, sy, s.color, s.background);
+            int cx = sx - plotAreaX, cy = sy - plotAreaY;
+            if (bits && cx >= 0 && cx < columns && cy >= 0 && cy < rows)
+            {
+                size_t bit = (si * rows + cy) * (size_t)columns + cx;
+                uint32_t mask = 1u << (bit & 31);
+                if (_occupied[bit >> 5] & mask)
+                    continue;
+                _occupied[bit >> 5] |= mask;
+            }
+            _sprites[si].draw(display, sx, sy);
+            _markersDrawn++;
         }
+        supplied += s.data.size();
     }
+    Serial.printf("[ScatterPlot] '%s': drew %u of %u markers (%u before decimation) in %lu us\r\n", _title.c_str(),
+                  (unsigned)_markersDrawn, (unsigned)supplied, (unsigned)_rawPoints, (unsigned long)(micros() - start));
 }
 
 void ScatterPlot::drawLegend()
@@ -269,16 +517,17 @@ void ScatterPlot::drawLegend()
     int16_t widthsum = 0;
     for (const auto &s : _series)
     {
-        display->getTextBounds(s.name, legendX, legendY, &x1, &y1, &w, &h);
+        TextMetrics::bounds(&FreeSans9pt7b, s.name.c_str(), legendX, legendY, &x1, &y1, &w, &h);
         widthsum += w;
     }
     // display->getTextBounds(_series.front().name, legendX, legendY, &x1, &y1, &w, &h);
     display->fillRect(legendX, legendY, widthsum + _series.size() * (markerw + spacing + 3), h + 16, EPD_WHITE);
     display->drawRect(legendX, legendY, widthsum + _series.size() * (markerw + spacing + 3), h + 16, EPD_BLACK);
-    for (const auto &s : _series)
+    for (size_t si = 0; si < _series.size(); si++)
     {
-        display->getTextBounds(s.name, legendX, legendY, &x1, &y1, &w, &h);
-        drawMarker(legendX + markerw / 2, legendY + markerh + 5, s.color, s.background);
+        const PlotSeries &s = _series[si];
+        TextMetrics::bounds(&FreeSans9pt7b, s.name.c_str(), legendX, legendY, &x1, &y1, &w, &h);
+        _sprites[si].draw(display, legendX + markerw / 2, legendY + markerh + 5);
         // display->fillRect(legendX, legendY, markerw, markerh, s.color);
         display->setCursor(legendX + markerw, legendY + markerh * 2);
         display->print(s.name);
@@ -288,39 +537,6 @@ void ScatterPlot::drawLegend()
     }
 }
 
-void ScatterPlot::drawMarker(int x, int y, uint16_t color, uint16_t background)
-{
-#if (EPD_SELECT == 1002)
-    // You could customize this to draw different markers based on series index
-    // For now, all series use a filled circle
-    display->fillCircle(x, y, 3, background);
-    display->drawCircle(x, y, 3, color);
-    display->drawCircle(x, y, 1, color);
-
-#elif (EPD_SELECT == 1001)
-    switch (color)
-    {
-    case EPD_RED:
-        display->fillCircle(x, y, 3, EPD_BLACK);
-        break;
-    case EPD_BLUE:
-        display->fillCircle(x, y, 3, EPD_LIGHTGREY);
-        display->drawCircle(x, y, 3, EPD_BLACK);
-        break;
-    case EPD_GREEN:
-        display->drawRect(x - 1, y + 1, 4, 4, EPD_BLACK);
-        break;
-    case EPD_YELLOW:
-        display->fillRect(x - 1, y + 1, 4, 4, EPD_BLACK);
-        break;
-    case EPD_BLACK:
-        display->drawLine(x - 2, y + 2, x + 2, y - 2, EPD_BLACK);
-        display->drawLine(x + 1, y - 1, x - 1, y + 1, EPD_BLACK);
-        break;
-    }
-#endif
-}
-
 // Helper function to simplify drawing text
 void ScatterPlot::drawString(int x, int y, const String &text, const GFXfont *font, uint16_t color)
 {
@@ -345,7 +561,7 @@ void ScatterPlot::add_refresh_timestamp()
     strftime(strftime_buf, sizeof(strftime_buf), "%m/%d/%y %H:%M", &timeinfo);
     display->setFont(NULL);
     display->setTextSize(1);
-    display->getTextBounds(strftime_buf, x, y, &x1, &y1, &w, &h);
+    TextMetrics::bounds(nullptr, strftime_buf, x, y, &x1, &y1, &w, &h);
     x = Config::EPD_WIDTH_PX - MARGIN_RIGHT - w;
 
     drawString(x, h / 2, strftime_buf, NULL, EPD_BLACK); // Use NULL font for default
@@ -442,17 +658,6 @@ float ScatterPlot::floatMap(float x, float in_min, float in_max, float out_min,
 
 void ScatterPlot::drawCheckerRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color1, uint16_t color2)
 {
-    bool checker = false;
-    for (int y1 = y; y1 < y + h; y1++)
-    {
-        for (int x1 = x; x1 < x + w; x1++)
-        {
-            if (checker ^ ((x1 - x) % 2))
-                display->drawPixel(x1, y1, color1);
-            else
-                display->drawPixel(x1, y1, color2);
-        }
-        checker = !checker;
-    }
+    PatternFill::fillRect(display, x, y, w, h, FILL_CHECKER, color1, color2);
     display->drawRect(x, y, w, h, color1);
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "ui/StatusBox.h"
+#include "ui/TextMetrics.h"
 #include <Fonts/FreeMonoBold9pt7b.h>
 
 StatusBox::StatusBox(Adafruit_GFX* gfx, int16_t x, int16_t y, int16_t w, int16_t h)
@@ -45,7 +46,7 @@ void StatusBox::draw(const SL_Status& status)
     _gfx->setTextColor(textColor);
     
     int16_t tx, ty; uint16_t tw, th;
-    _gfx->getTextBounds(statusString, 0, 0, &tx, &ty, &tw, &th);
+    TextMetrics::bounds(&FreeMonoBold9pt7b, statusString.c_str(), 0, 0, &tx, &ty, &tw, &th);
     
     // Center text
     _gfx->setCursor(_x + (_w - tw)/2, _y + (_h - th)/2 + th/2 + 2); 
@@ -1,4 +1,5 @@
 #include "ui/TextLabel.h"
+#include "ui/TextMetrics.h"
 #include <Fonts/FreeMono9pt7b.h>
 #include <Fonts/FreeMonoBold9pt7b.h>
 
@@ -37,7 +38,7 @@ void TextLabel::draw(time_t now)
     if (_w > 0)
     {
         int16_t x1, y1; uint16_t tw, th;
-        _gfx->getTextBounds(strftime_buf, 0, 0, &x1, &y1, &tw, &th);
+        TextMetrics::bounds(&FreeMono9pt7b, strftime_buf, 0, 0, &x1, &y1, &tw, &th);
         _gfx->setCursor(_x, _y + 12); 
     }
     else
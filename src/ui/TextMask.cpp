@@ -0,0 +1,74 @@
+#include "ui/TextMask.h"
+
+/**
+ * @brief Emits one run of set glyph bits, split into its left and right colored parts.
+ */
+static void drawRun(Adafruit_GFX *gfx, int16_t x0, int16_t x1, int16_t y, int16_t splitX, uint16_t leftColor, uint16_t rightColor)
+{
+    int16_t mid = splitX < x0 ? x0 : (splitX > x1 ? x1 : splitX);
+    if (mid > x0)
+    {
+        if (mid - x0 == 1)
+            gfx->drawPixel(x0, y, leftColor);
+        else
+            gfx->drawFastHLine(x0, y, mid - x0, leftColor);
+    }
+    if (x1 > mid)
+    {
+        if (x1 - mid == 1)
+            gfx->drawPixel(mid, y, rightColor);
+        else
+            gfx->drawFastHLine(mid, y, x1 - mid, rightColor);
+    }
+}
+
+/**
+ * @brief Draws text from the glyph bitmaps, coloring each pixel by its side of splitX.
+ *
+ * Replaces rendering into a temporary GFXcanvas1 and testing it pixel by pixel: set
+ * bits are collected into runs per glyph row and written with at most two calls each.
+ */
+void TextMask::draw(Adafruit_GFX *gfx, const GFXfont *font, const char *text, int16_t x, int16_t y,
+                    int16_t splitX, uint16_t leftColor, uint16_t rightColor)
+{
+    if (!font || !text)
+        return;
+    const FontMetrics &m = TextMetrics::font(font);
+    const uint8_t *bitmap = (const uint8_t *)pgm_read_ptr(&font->bitmap);
+    const GFXglyph *glyphs = (const GFXglyph *)pgm_read_ptr(&font->glyph);
+
+    gfx->startWrite();
+    int16_t cursor = x;
+    for (const char *p = text; *p; p++)
+    {
+        uint8_t c = (uint8_t)*p;
+        if (c < m.first || c >= m.first + m.count)
+            continue;
+        const GlyphMetrics &g = m.glyphs[c - m.first];
+        uint16_t bo = pgm_read_word(&glyphs[c - m.first].bitmapOffset);
+        int16_t gx = cursor + g.xOffset;
+        uint8_t bits = 0, bit = 0;
+        for (int16_t yy = 0; yy < g.height; yy++)
+        {
+            int16_t runStart = -1;
+            for (int16_t xx = 0; xx < g.width; xx++)
+            {
+                if (!(bit++ & 7))
+                    bits = pgm_read_byte(&bitmap[bo++]);
+                bool on = bits & 0x80;
+                bits <<= 1;
+                if (on && runStart < 0)
+                    runStart = xx;
+                else if (!on && runStart >= 0)
+                {
+                    drawRun(gfx, gx + runStart, gx + xx, y + g.yOffset + yy, splitX, leftColor, rightColor);
+                    runStart = -1;
+                }
+            }
+            if (runStart >= 0)
+                drawRun(gfx, gx + runStart, gx + g.width, y + g.yOffset + yy, splitX, leftColor, rightColor);
+        }
+        cursor += g.xAdvance;
+    }
+    gfx->endWrite();
+}
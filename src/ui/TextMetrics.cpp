@@ -0,0 +1,172 @@
+#include "ui/TextMetrics.h"
+
+// Font headers define their GFXfont objects with internal linkage, so every source
+// file that includes one gets its own copy at its own address. Tables are therefore
+// keyed by pointer and sized for the handful of copies the UI ends up with.
+static constexpr int MAX_CACHED_FONTS = 16;
+static FontMetrics s_fonts[MAX_CACHED_FONTS];
+static uint8_t s_nextFont = 0;
+
+// Direct-mapped memo of string measurements, keyed by font and FNV-1a of the text
+struct MemoEntry
+{
+    const GFXfont *font;
+    uint32_t hash;
+    uint16_t len;
+    bool valid;
+    TextBounds bounds;
+};
+static constexpr int MEMO_SIZE = 128;
+static MemoEntry s_memo[MEMO_SIZE];
+static uint32_t s_hits = 0, s_misses = 0;
+
+/**
+ * @brief Returns the metrics table for a font, building it on first use.
+ *
+ * Fonts beyond the cache size replace the oldest slot.
+ */
+const FontMetrics &TextMetrics::font(const GFXfont *font)
+{
+    for (const auto &m : s_fonts)
+    {
+        if (m.font == font)
+            return m;
+    }
+    FontMetrics &m = s_fonts[s_nextFont];
+    s_nextFont = (s_nextFont + 1) % MAX_CACHED_FONTS;
+    m.font = font;
+    m.first = pgm_read_word(&font->first);
+    uint16_t last = pgm_read_word(&font->last);
+    m.count = last >= m.first ? last - m.first + 1 : 0;
+    if (m.count > FontMetrics::MAX_GLYPHS)
+        m.count = FontMetrics::MAX_GLYPHS;
+    const GFXglyph *glyphs = (const GFXglyph *)pgm_read_ptr(&font->glyph);
+    for (uint16_t i = 0; i < m.count; i++)
+    {
+        const GFXglyph *g = &glyphs[i];
+        m.glyphs[i].xAdvance = pgm_read_byte(&g->xAdvance);
+        m.glyphs[i].width = pgm_read_byte(&g->width);
+        m.glyphs[i].height = pgm_read_byte(&g->height);
+        m.glyphs[i].xOffset = (int8_t)pgm_read_byte(&g->xOffset);
+        m.glyphs[i].yOffset = (int8_t)pgm_read_byte(&g->yOffset);
+    }
+    return m;
+}
+
+void TextMetrics::beginFrame()
+{
+    memset(s_memo, 0, sizeof(s_memo));
+    s_hits = 0;
+    s_misses = 0;
+}
+
+uint32_t TextMetrics::hits() { return s_hits; }
+uint32_t TextMetrics::misses() { return s_misses; }
+
+/**
+ * @brief Bounds of a string, accumulated the same way as Adafruit_GFX::charBounds.
+ */
+static TextBounds compute(const GFXfont *font, const char *text, size_t len)
+{
+    TextBounds b = {0, 0, 0, 0};
+    if (!font)
+    {
+        // Built-in font: fixed 6x8 cells, cursor at the top-left
+        size_t n = 0;
+        for (size_t i = 0; i < len; i++)
+        {
+            if (text[i] != '\n' && text[i] != '\r')
+                n++;
+        }
+        b.w = n * 6;
+        b.h = n ? 8 : 0;
+        return b;
+    }
+
+    const FontMetrics &m = TextMetrics::font(font);
+    int16_t minx = INT16_MAX, miny = INT16_MAX, maxx = -1, maxy = -1;
+    int16_t cursor = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        uint8_t c = (uint8_t)text[i];
+        if (c < m.first || c >= m.first + m.count)
+            continue;
+        const GlyphMetrics &g = m.glyphs[c - m.first];
+        int16_t x1 = cursor + g.xOffset, y1 = g.yOffset;
+        int16_t x2 = x1 + g.width - 1, y2 = y1 + g.height - 1;
+        if (x1 < minx)
+            minx = x1;
+        if (y1 < miny)
+            miny = y1;
+        if (x2 > maxx)
+            maxx = x2;
+        if (y2 > maxy)
+            maxy = y2;
+        cursor += g.xAdvance;
+    }
+    if (maxx >= minx)
+    {
+        b.x = minx;
+        b.w = maxx - minx + 1;
+    }
+    if (maxy >= miny)
+    {
+        b.y = miny;
+        b.h = maxy - miny + 1;
+    }
+    return b;
+}
+
+TextBounds TextMetrics::measure(const GFXfont *font, const char *text)
+{
+    if (!text)
+        return TextBounds{0, 0, 0, 0};
+    uint32_t h = 2166136261u;
+    size_t len = 0;
+    for (const char *p = text; *p; p++, len++)
+    {
+        h ^= (uint8_t)*p;
+        h *= 16777619u;
+    }
+    h ^= (uint32_t)(uintptr_t)font;
+    MemoEntry &e = s_memo[(h ^ (h >> 16)) % MEMO_SIZE];
+    if (e.valid && e.font == font && e.hash == h && e.len == len)
+    {
+        s_hits++;
+        return e.bounds;
+    }
+    s_misses++;
+    e.font = font;
+    e.hash = h;
+    e.len = len;
+    e.valid = true;
+    e.bounds = compute(font, text, len);
+    return e.bounds;
+}
+
+void TextMetrics::bounds(const GFXfont *font, const char *text, int16_t x, int16_t y,
+                         int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h)
+{
+    TextBounds b = measure(font, text);
+    *x1 = x + b.x;
+    *y1 = y + b.y;
+    *w = b.w;
+    *h = b.h;
+}
+
+int TextMetrics::fitFont(const GFXfont *const *fonts, int count, const char *text, uint16_t maxW, uint16_t maxH, TextBounds *bounds)
+{
+    int i = 0;
+    TextBounds b = {0, 0, 0, 0};
+    for (; i < count; i++)
+    {
+        b = measure(fonts[i], text);
+        if (b.w <= maxW && b.h <= maxH)
+            break;
+    }
+    if (i == count)
+        i = count - 1;
+    if (bounds)
+        *bounds = b;
+    return i;
+}
@@ -1,5 +1,6 @@
 #include <Arduino.h>
 #include "ui/Widget.h"
+#include "ui/TextMetrics.h"
 #include <math.h>
 #include <Fonts/FreeSansBold24pt7b.h>
 #include <Fonts/FreeSansBold18pt7b.h>
@@ -7,16 +8,18 @@
 #include <Fonts/FreeSansBold9pt7b.h>
 
 #include "core/Config.h"
+#include "ui/TextMask.h"
+#include "ui/PatternFill.h"
 
 // --- Base Widget ---
 Widget::Widget(Adafruit_GFX *gfx, int16_t x, int16_t y, int16_t w, int16_t h, uint16_t colorFg, uint16_t colorBg)
     : _gfx(gfx), _x(x), _y(y), _w(w), _h(h), _cFg(colorFg), _cBg(colorBg) {}
 
-void Widget::textCenteredCursor(Adafruit_GFX *disp, String text, int16_t x, int16_t y)
+void Widget::textCenteredCursor(Adafruit_GFX *disp, const GFXfont *font, const char *text, int16_t x, int16_t y)
 {
     int16_t x1, y1;
     uint16_t w, h;
-    disp->getTextBounds(text, x, y, &x1, &y1, &w, &h);
+    TextMetrics::bounds(font, text, x, y, &x1, &y1, &w, &h);
     disp->setCursor(x + (x - x1) - (w / 2), y + (y - y1) - (h / 2));
 }
 
@@ -28,17 +31,17 @@ LinearGauge::LinearGauge(Adafruit_GFX *gfx, int16_t x, int16_t y, int16_t w, int
     _max = 100;
 }
 
-void LinearGauge::setRange(float minVal, float maxVal, String units)
+void LinearGauge::setRange(float minVal, float maxVal, const char *units)
 {
     _min = minVal;
     _max = maxVal;
-    _units = units;
+    _units = units ? units : "";
 }
 
-void LinearGauge::showLabel(bool show, String label)
+void LinearGauge::showLabel(bool show, const char *label)
 {
     _showLabel = show;
-    _label = label;
+    _label = label ? label : "";
 }
 
 void LinearGauge::draw(float value)
@@ -73,73 +76,26 @@ void LinearGauge::draw(float value)
         _gfx->fillRect(_x + 2, _y + 2 + activeH - barH, _w - 4, barH, _cFg);
     }
 
-    // 5. Inverted Text Label (Pixel-by-Pixel Analysis)
+    // 5. Inverted Text Label: glyph pixels over the filled bar take the background color
     if (_showLabel)
     {
-        String valStr = String(value, 0);
-        valStr = _label + valStr + _units;
-        int16_t x1, y1;
-        uint16_t w = 800, h = 480;
-        GFXfont *fon;
-        int textsize = 0;
-        //_gfx->setFont(fon);
-        _gfx->setTextSize(textsize);
-        //_gfx->getTextBounds(valStr, 0, 0, &x1, &y1, &w, &h);
-        const GFXfont *fonts[] = {&FreeSansBold24pt7b, &FreeSansBold18pt7b, &FreeSansBold12pt7b, &FreeSansBold9pt7b};
-        uint16_t textIndex = 0;
-        while (((w > _w - 8) || (h > _h - 8)) && textIndex < 4)
-        {
-            // fon = NULL;
-            // textsize = 0;
-            fon = (GFXfont *)fonts[textIndex];
-            _gfx->setFont(fon);
-            _gfx->setTextSize(textsize);
-            _gfx->getTextBounds(valStr, 0, 0, &x1, &y1, &w, &h);
-            textIndex++;
-        }
-
-        // Calculate where the text *should* go on the screen (centered)
-        int16_t textScreenX = _x + (_w - w) / 2;
-        int16_t textScreenY = _y + (_h - h) / 2;
+        char valStr[64];
+        snprintf(valStr, sizeof(valStr), "%s%2.0f%s", _label, value, _units);
+        static const GFXfont *const fonts[] = {&FreeSansBold24pt7b, &FreeSansBold18pt7b, &FreeSansBold12pt7b, &FreeSansBold9pt7b};
+        TextBounds b;
+        uint16_t maxW = _w > 8 ? _w - 8 : 0, maxH = _h > 8 ? _h - 8 : 0;
+        int fontIndex = TextMetrics::fitFont(fonts, 4, valStr, maxW, maxH, &b);
 
-        // Create a temporary 1-bit canvas just for the text
-        // This acts as a bitmap mask
-        GFXcanvas1 textCanvas(w, h);
-        textCanvas.setFont(fon);
-        textCanvas.setTextSize(textsize);
-        textCanvas.setTextColor(1); // "On" pixels
-        // Adjust cursor so the text fills the canvas tightly (negating the bounds offset)
-        textCanvas.setCursor(-x1, -y1);
-        textCanvas.print(valStr);
+        // Centered, with the cursor offset by the bounds so the ink lands in the box
+        int16_t cursorX = _x + (_w - b.w) / 2 - b.x;
+        int16_t cursorY = _y + (_h - b.h) / 2 - b.y;
 
         // Define the X-limit of the filled bar
         int16_t barLimitX = _x + 2 + barW;
-
-        // Iterate through the text canvas pixels
-        for (int16_t j = 0; j < h; j++)
-        {
-            for (int16_t i = 0; i < w; i++)
-            {
-                // If this pixel is part of the text
-                if (textCanvas.getPixel(i, j))
-                {
-                    int16_t absX = textScreenX + i;
-                    int16_t absY = textScreenY + j;
-
-                    // INVERSION LOGIC:
-                    // Check if this specific pixel lies on top of the filled bar.
-                    // If yes -> Draw in Background Color (White)
-                    // If no  -> Draw in Foreground Color (Black)
-
-                    bool overBar = (absX >= _x + 2) && (absX < barLimitX);
-
-                    uint16_t finalColor = overBar ? _cBg : _cFg;
-                    if (_cFg == EPD_YELLOW)
-                        finalColor = EPD_BLACK;
-                    _gfx->drawPixel(absX, absY, finalColor);
-                }
-            }
-        }
+        uint16_t overBar = _cBg, offBar = _cFg;
+        if (_cFg == EPD_YELLOW)
+            overBar = offBar = EPD_BLACK;
+        TextMask::draw(_gfx, fonts[fontIndex], valStr, cursorX, cursorY, barLimitX, overBar, offBar);
     }
 }
 
@@ -153,17 +109,17 @@ RingGauge::RingGauge(Adafruit_GFX *gfx, int16_t x, int16_t y, int16_t radius, in
     _max = 100;
 }
 
-void RingGauge::setRange(float minVal, float maxVal, String units)
+void RingGauge::setRange(float minVal, float maxVal, const char *units)
 {
     _min = minVal;
     _max = maxVal;
-    _units = units;
+    _units = units ? units : "";
 }
 
-void RingGauge::showLabel(bool show, String label)
+void RingGauge::showLabel(bool show, const char *label)
 {
     _showLabel = show;
-    _label = label;
+    _label = label ? label : "";
 }
 
 void RingGauge::setAngleRange(int16_t startAngle, int16_t endAngle)
@@ -172,43 +128,137 @@ void RingGauge::setAngleRange(int16_t startAngle, int16_t endAngle)
     _endAngle = endAngle;
 }
 
-// Custom Helper to draw thick arc without native GFX support
-void RingGauge::fillArc(int16_t cx, int16_t cy, int16_t start_angle, int16_t end_angle, int16_t r_outer, int16_t r_inner, uint16_t color)
+// sin(0..90 degrees) scaled by 2^14, evaluated at compile time
+struct QuarterSinTable
 {
-    float angle_step = 1.0; // Resolution in degrees (higher = smoother but slower)
+    int16_t v[91];
+};
 
-    // Convert 0-360 standard to GFX standard (0 is Right, 90 is Bottom in standard math,
-    // but usually 0 is Top in UI thinking. Let's stick to standard Trig: 0=Right, -90=Top)
-    // To make it intuitive: Input 0 = Top, 90 = Right.
-    // Math adjustment: theta = (angle - 90)
-
-    for (float i = start_angle; i < end_angle; i += angle_step)
+static constexpr double taylorSin(double x)
+{
+    double term = x, sum = x;
+    for (int n = 1; n < 12; n++)
     {
-        float a1 = i * DEG_TO_RAD;
-        float a2 = (i + angle_step) * DEG_TO_RAD;
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+static constexpr QuarterSinTable makeQuarterSinTable()
+{
+    QuarterSinTable t{};
+    for (int d = 0; d <= 90; d++)
+        t.v[d] = (int16_t)(taylorSin(d * 3.14159265358979323846 / 180.0) * 16384.0 + 0.5);
+    return t;
+}
+
+static constexpr QuarterSinTable SIN_TABLE = makeQuarterSinTable();
+
+static int32_t sinDeg(int deg)
+{
+    deg %= 360;
+    if (deg < 0)
+        deg += 360;
+    if (deg <= 90)
+        return SIN_TABLE.v[deg];
+    if (deg <= 180)
+        return SIN_TABLE.v[180 - deg];
+    if (deg <= 270)
+        return -SIN_TABLE.v[deg - 180];
+    return -SIN_TABLE.v[360 - deg];
+}
+
+static int32_t cosDeg(int deg) { return sinDeg(deg + 90); }
+
+static int32_t isqrt(int32_t n)
+{
+    int32_t r = (int32_t)sqrtf((float)n);
+    while (r * r > n)
+        r--;
+    while ((r + 1) * (r + 1) <= n)
+        r++;
+    return r;
+}
+
+// > 0 when b lies clockwise of a on screen (y grows downward), i.e. at a larger angle
+static inline int32_t cross(int32_t ax, int32_t ay, int32_t bx, int32_t by)
+{
+    return ax * by - ay * bx;
+}
 
-        // Ensure we don't over-shoot the end angle
-        if (i + angle_step > end_angle)
+/**
+ * @brief Fills an annular sector by scanline.
+ *
+ * Angles are in degrees with 0 pointing right and growing clockwise, as before. Each
+ * row of the ring is walked once: pixels whose center lies between r_inner - 0.5 and
+ * r_outer + 0.5 are tested against the start and end directions with integer cross
+ * products, and the ones inside are written as horizontal runs. No pixel is written
+ * twice, and rows outside the display or the current page band are skipped.
+ */
+void RingGauge::fillArc(int16_t cx, int16_t cy, int16_t start_angle, int16_t end_angle, int16_t r_outer, int16_t r_inner, uint16_t color)
+{
+    if (end_angle <= start_angle || r_outer <= 0)
+        return;
+    int sweep = end_angle - start_angle;
+    int32_t sx = cosDeg(start_angle), sy = sinDeg(start_angle);
+    int32_t ex = cosDeg(end_angle), ey = sinDeg(end_angle);
+    int32_t outer2 = (int32_t)r_outer * r_outer + r_outer;
+    int32_t inner2 = r_inner > 0 ? (int32_t)r_inner * r_inner - r_inner : -1;
+
+    auto inside = [&](int32_t dx, int32_t dy) -> bool
+    {
+        if (sweep >= 360)
+            return true;
+        if (sweep <= 180)
+            return cross(sx, sy, dx, dy) >= 0 && cross(dx, dy, ex, ey) >= 0;
+        // More than half a turn: inside unless strictly within the gap from end to start
+        return !(cross(ex, ey, dx, dy) > 0 && cross(dx, dy, sx, sy) > 0);
+    };
+
+    auto fillSegment = [&](int16_t y, int32_t dy, int32_t fromDx, int32_t toDx)
+    {
+        int32_t runStart = 0;
+        bool inRun = false;
+        for (int32_t dx = fromDx; dx <= toDx + 1; dx++)
         {
-            a2 = end_angle * DEG_TO_RAD;
+            bool on = dx <= toDx && inside(dx, dy);
+            if (on && !inRun)
+            {
+                runStart = dx;
+                inRun = true;
+            }
+            else if (!on && inRun)
+            {
+                _gfx->drawFastHLine(cx + runStart, y, dx - runStart, color);
+                inRun = false;
+            }
         }
+    };
 
-        // Outer points
-        int16_t x1_out = cx + cos(a1) * r_outer;
-        int16_t y1_out = cy + sin(a1) * r_outer;
-        int16_t x2_out = cx + cos(a2) * r_outer;
-        int16_t y2_out = cy + sin(a2) * r_outer;
-
-        // Inner points
-        int16_t x1_in = cx + cos(a1) * r_inner;
-        int16_t y1_in = cy + sin(a1) * r_inner;
-        int16_t x2_in = cx + cos(a2) * r_inner;
-        int16_t y2_in = cy + sin(a2) * r_inner;
-
-        // Draw two triangles to form the quad segment
-        _gfx->fillTriangle(x1_out, y1_out, x1_in, y1_in, x2_out, y2_out, color);
-        _gfx->fillTriangle(x2_out, y2_out, x1_in, y1_in, x2_in, y2_in, color);
+    int16_t top = cy - r_outer, bottom = cy + r_outer + 1;
+    PatternFill::clipRows(_gfx, top, bottom);
+    _gfx->startWrite();
+    for (int16_t y = top; y < bottom; y++)
+    {
+        int32_t dy = y - cy;
+        int32_t rem = outer2 - dy * dy;
+        if (rem < 0)
+            continue;
+        int32_t xo = isqrt(rem);
+        int32_t holeRem = inner2 - dy * dy;
+        if (holeRem < 0)
+        {
+            fillSegment(y, dy, -xo, xo);
+        }
+        else
+        {
+            int32_t xi = isqrt(holeRem);
+            fillSegment(y, dy, -xo, -xi - 1);
+            fillSegment(y, dy, xi + 1, xo);
+        }
     }
+    _gfx->endWrite();
 }
 
 void RingGauge::draw(float value)
@@ -235,23 +285,17 @@ void RingGauge::draw(float value)
     fillArc(arcCenter_x, arcCenter_y, _startAngle, _endAngle, arcRadius, arcRadius - _thickness, EPD_BLACK);                      // border
     fillArc(arcCenter_x, arcCenter_y, _startAngle + 3, _endAngle - 3, arcRadius - 1, arcRadius - _thickness + 1, _cBg);      // empty fill
     fillArc(arcCenter_x, arcCenter_y, _startAngle + 3, activeEndAngle - 3, arcRadius - 1, arcRadius - _thickness + 1, _cFg); // active bar
-    const GFXfont *fonts[] = {&FreeSansBold24pt7b, &FreeSansBold18pt7b, &FreeSansBold12pt7b, &FreeSansBold9pt7b};
-    uint8_t textIndex = 0;
-
+    static const GFXfont *const fonts[] = {&FreeSansBold24pt7b, &FreeSansBold18pt7b, &FreeSansBold12pt7b, &FreeSansBold9pt7b};
 
-    String valStr = String((int)value) + _units;
-    // 3. Draw Value in Center
-    _gfx->setFont(&FreeSansBold9pt7b);
+    char valStr[32];
+    snprintf(valStr, sizeof(valStr), "%d%s", (int)value, _units);
+    // 3. Draw Value in Center, in the largest font that fits inside the ring
+    uint16_t centerspace = (_radius - _thickness) * 2;
+    const GFXfont *valueFont = fonts[TextMetrics::fitFont(fonts, 4, valStr, centerspace, centerspace, nullptr)];
+    _gfx->setFont(valueFont);
     _gfx->setTextColor(EPD_BLACK);
     _gfx->setTextSize(0);
-    uint16_t centerspace = (_radius - _thickness) * 2;
-    while (((w > centerspace) || (h > centerspace)) && textIndex < 4)
-    {
-        _gfx->setFont(fonts[textIndex]);
-        _gfx->getTextBounds(valStr, arcCenter_x, arcCenter_y, &x1, &y1, &w, &h);
-        textIndex++;
-    }
-    textCenteredCursor(_gfx, valStr, _x, _y);
+    textCenteredCursor(_gfx, valueFont, valStr, _x, _y);
     //_gfx->setCursor(cx +(cx -x1 ) - (w / 2), cy + (cy - y1) - (h / 2));
     _gfx->print(valStr);
 
@@ -260,10 +304,10 @@ void RingGauge::draw(float value)
     _gfx->setTextSize(0);
     if (_showLabel)
     {
-        _gfx->getTextBounds(_label, arcCenter_x, arcCenter_y, &x1, &y1, &w, &h);
+        TextMetrics::bounds(&FreeSansBold9pt7b, _label, arcCenter_x, arcCenter_y, &x1, &y1, &w, &h);
         //arcCenter_y -= (h+3);
         //arcRadius -= h;
-        textCenteredCursor(_gfx, _label, arcCenter_x, _y+_radius/2 + h + 2);
+        textCenteredCursor(_gfx, &FreeSansBold9pt7b, _label, arcCenter_x, _y+_radius/2 + h + 2);
         _gfx->print(_label);
     }
 }
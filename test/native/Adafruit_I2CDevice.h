@@ -0,0 +1,7 @@
+#ifndef NATIVE_ADAFRUIT_I2CDEVICE_H
+#define NATIVE_ADAFRUIT_I2CDEVICE_H
+
+// Adafruit_GFX.h includes the BusIO headers for its display drivers. The native env
+// ignores BusIO and skips those drivers (see gfx_native.py), so nothing is declared.
+
+#endif
@@ -0,0 +1,458 @@
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+// Host stand-in for the parts of the ESP32 Arduino core the render and storage code
+// uses, for the native test env. Serial goes to stdout, PSRAM is the heap, and
+// time() reads a clock the tests set (see NativeClock).
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <math.h>
+#include <time.h>
+#include <ctime>
+#include <chrono>
+#include <string>
+#include <algorithm>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define PI 3.1415926535897932384626433832795
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define PROGMEM
+class __FlashStringHelper;
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+#define pgm_read_ptr(addr) (*(void *const *)(addr))
+
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_DEFAULT (1 << 12)
+
+class String
+{
+public:
+    String() {}
+    String(const char *s) : _s(s ? s : "") {}
+    String(const std::string &s) : _s(s) {}
+    explicit String(char c) : _s(1, c) {}
+    String(int v, unsigned char base = DEC) : _s(number((long long)v, base)) {}
+    String(unsigned int v, unsigned char base = DEC) : _s(number((unsigned long long)v, base)) {}
+    String(long v, unsigned char base = DEC) : _s(number((long long)v, base)) {}
+    String(unsigned long v, unsigned char base = DEC) : _s(number((unsigned long long)v, base)) {}
+    String(long long v, unsigned char base = DEC) : _s(number(v, base)) {}
+    String(unsigned long long v, unsigned char base = DEC) : _s(number(v, base)) {}
+    String(float v, unsigned int decimals = 2) : _s(fixed(v, decimals)) {}
+    String(double v, unsigned int decimals = 2) : _s(fixed(v, decimals)) {}
+
+    const char *c_str() const { return _s.c_str(); }
+    unsigned int length() const { return (unsigned int)_s.size(); }
+    bool isEmpty() const { return _s.empty(); }
+    bool reserve(unsigned int size)
+    {
+        _s.reserve(size);
+        return true;
+    }
+
+    char charAt(unsigned int i) const { return i < _s.size() ? _s[i] : 0; }
+    char operator[](unsigned int i) const { return charAt(i); }
+    char &operator[](unsigned int i) { return _s[i]; }
+
+    bool concat(const String &s)
+    {
+        _s += s._s;
+        return true;
+    }
+    bool concat(const char *s)
+    {
+        if (s)
+            _s += s;
+        return s != nullptr;
+    }
+    bool concat(char c)
+    {
+        _s += c;
+        return true;
+    }
+    template <typename T>
+    bool concat(T v) { return concat(String(v)); }
+
+    String &operator+=(const String &s) { concat(s); return *this; }
+    String &operator+=(const char *s) { concat(s); return *this; }
+    String &operator+=(char c) { concat(c); return *this; }
+    template <typename T>
+    String &operator+=(T v) { concat(String(v)); return *this; }
+
+    bool equals(const String &s) const { return _s == s._s; }
+    bool equals(const char *s) const { return _s == (s ? s : ""); }
+    bool equalsIgnoreCase(const String &s) const { return lower(_s) == lower(s._s); }
+    bool operator==(const String &s) const { return equals(s); }
+    bool operator==(const char *s) const { return equals(s); }
+    bool operator!=(const String &s) const { return !equals(s); }
+    bool operator!=(const char *s) const { return !equals(s); }
+    bool operator<(const String &s) const { return _s < s._s; }
+    int compareTo(const String &s) const { return _s.compare(s._s); }
+
+    bool startsWith(const String &prefix) const { return _s.compare(0, prefix._s.size(), prefix._s) == 0; }
+    bool endsWith(const String &suffix) const
+    {
+        return _s.size() >= suffix._s.size() && _s.compare(_s.size() - suffix._s.size(), suffix._s.size(), suffix._s) == 0;
+    }
+
+    int indexOf(char c, unsigned int from = 0) const { return found(_s.find(c, from)); }
+    int indexOf(const String &s, unsigned int from = 0) const { return found(_s.find(s._s, from)); }
+    int lastIndexOf(char c) const { return found(_s.rfind(c)); }
+    int lastIndexOf(const String &s) const { return found(_s.rfind(s._s)); }
+
+    String substring(unsigned int from) const { return from < _s.size() ? String(_s.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const
+    {
+        if (from > to)
+            std::swap(from, to);
+        if (from >= _s.size())
+            return String();
+        return String(_s.substr(from, to - from));
+    }
+
+    void replace(const String &find, const String &with)
+    {
+        if (find._s.empty())
+            return;
+        for (size_t pos = _s.find(find._s); pos != std::string::npos; pos = _s.find(find._s, pos + with._s.size()))
+            _s.replace(pos, find._s.size(), with._s);
+    }
+    void remove(unsigned int index) { remove(index, (unsigned int)_s.size()); }
+    void remove(unsigned int index, unsigned int count)
+    {
+        if (index < _s.size())
+            _s.erase(index, count);
+    }
+    void trim()
+    {
+        size_t b = _s.find_first_not_of(" \t\r\n");
+        size_t e = _s.find_last_not_of(" \t\r\n");
+        _s = b == std::string::npos ? std::string() : _s.substr(b, e - b + 1);
+    }
+    void toLowerCase() { _s = lower(_s); }
+    void toUpperCase()
+    {
+        for (auto &c : _s)
+            c = (char)toupper((unsigned char)c);
+    }
+
+    long toInt() const { return atol(_s.c_str()); }
+    float toFloat() const { return (float)atof(_s.c_str()); }
+    double toDouble() const { return atof(_s.c_str()); }
+
+private:
+    std::string _s;
+
+    static int found(size_t pos) { return pos == std::string::npos ? -1 : (int)pos; }
+    static std::string lower(std::string s)
+    {
+        for (auto &c : s)
+            c = (char)tolower((unsigned char)c);
+        return s;
+    }
+    static std::string fixed(double v, unsigned int decimals)
+    {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "%.*f", (int)decimals, v);
+        return buf;
+    }
+    static std::string number(unsigned long long v, unsigned char base)
+    {
+        if (base < 2)
+            base = 10;
+        char buf[72];
+        char *p = buf + sizeof(buf) - 1;
+        *p = 0;
+        do
+        {
+            unsigned d = (unsigned)(v % base);
+            *--p = (char)(d < 10 ? '0' + d : 'A' + d - 10);
+            v /= base;
+        } while (v);
+        return p;
+    }
+    static std::string number(long long v, unsigned char base)
+    {
+        if (v < 0 && base == DEC)
+            return "-" + number((unsigned long long)(-v), base);
+        return number((unsigned long long)v, base);
+    }
+};
+
+inline String operator+(const String &a, const String &b)
+{
+    String s(a);
+    s += b;
+    return s;
+}
+inline String operator+(const String &a, const char *b)
+{
+    String s(a);
+    s += b;
+    return s;
+}
+inline String operator+(const char *a, const String &b)
+{
+    String s(a);
+    s += b;
+    return s;
+}
+inline String operator+(const String &a, char b)
+{
+    String s(a);
+    s += b;
+    return s;
+}
+
+// Same formatting as the Arduino core's Print (printFloat included), so text drawn
+// through Adafruit_GFX::print matches the device.
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size)
+    {
+        size_t n = 0;
+        while (size--)
+            n += write(*buffer++);
+        return n;
+    }
+    size_t write(const char *str) { return str ? write((const uint8_t *)str, strlen(str)) : 0; }
+    size_t write(const char *buffer, size_t size) { return write((const uint8_t *)buffer, size); }
+
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)))
+    {
+        char buf[256];
+        va_list args;
+        va_start(args, format);
+        int len = vsnprintf(buf, sizeof(buf), format, args);
+        va_end(args);
+        if (len < 0)
+            return 0;
+        if ((size_t)len < sizeof(buf))
+            return write((const uint8_t *)buf, len);
+        std::string big(len + 1, '\0');
+        va_start(args, format);
+        vsnprintf(&big[0], big.size(), format, args);
+        va_end(args);
+        return write((const uint8_t *)big.data(), len);
+    }
+
+    size_t print(const String &s) { return write(s.c_str(), s.length()); }
+    size_t print(const char *s) { return write(s); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char n, int base = DEC) { return printNumber(n, base); }
+    size_t print(int n, int base = DEC) { return printSigned(n, base); }
+    size_t print(unsigned int n, int base = DEC) { return printNumber(n, base); }
+    size_t print(long n, int base = DEC) { return printSigned(n, base); }
+    size_t print(unsigned long n, int base = DEC) { return printNumber(n, base); }
+    size_t print(long long n, int base = DEC) { return printSigned(n, base); }
+    size_t print(unsigned long long n, int base = DEC) { return printNumber(n, base); }
+    size_t print(double n, int digits = 2) { return printFloat(n, digits); }
+
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(const T &v)
+    {
+        size_t n = print(v);
+        return n + println();
+    }
+    template <typename T>
+    size_t println(const T &v, int format)
+    {
+        size_t n = print(v, format);
+        return n + println();
+    }
+
+private:
+    size_t printSigned(long long n, int base)
+    {
+        if (base == 0)
+            return write((uint8_t)n);
+        if (base == DEC && n < 0)
+            return print('-') + printNumber((unsigned long long)(-n), DEC);
+        return printNumber((unsigned long long)n, base);
+    }
+    size_t printNumber(unsigned long long n, int base)
+    {
+        if (base < 2)
+            base = 10;
+        char buf[8 * sizeof(n) + 1];
+        char *str = &buf[sizeof(buf) - 1];
+        *str = '\0';
+        do
+        {
+            char c = (char)(n % base);
+            n /= base;
+            *--str = c < 10 ? c + '0' : c + 'A' - 10;
+        } while (n);
+        return write(str);
+    }
+    size_t printFloat(double number, uint8_t digits)
+    {
+        if (isnan(number))
+            return print("nan");
+        if (isinf(number))
+            return print("inf");
+        if (number > 4294967040.0 || number < -4294967040.0)
+            return print("ovf");
+
+        size_t n = 0;
+        if (number < 0.0)
+        {
+            n += print('-');
+            number = -number;
+        }
+        double rounding = 0.5;
+        for (uint8_t i = 0; i < digits; ++i)
+            rounding /= 10.0;
+        number += rounding;
+
+        unsigned long int_part = (unsigned long)number;
+        double remainder = number - (double)int_part;
+        n += print(int_part);
+        if (digits > 0)
+            n += print('.');
+        while (digits-- > 0)
+        {
+            remainder *= 10.0;
+            unsigned int toPrint = (unsigned int)remainder;
+            n += print(toPrint);
+            remainder -= toPrint;
+        }
+        return n;
+    }
+};
+
+class HardwareSerial : public Print
+{
+public:
+    void begin(unsigned long) {}
+    void end() {}
+    void flush() { fflush(stdout); }
+    int available() { return 0; }
+    int read() { return -1; }
+    operator bool() const { return true; }
+
+    using Print::write;
+    size_t write(uint8_t c) override
+    {
+        if (c != '\r')
+            fputc(c, stdout);
+        return 1;
+    }
+};
+
+inline HardwareSerial Serial;
+
+// stdlib_noniso
+inline char *itoa(int value, char *str, int base)
+{
+    strcpy(str, String(value, (unsigned char)base).c_str());
+    return str;
+}
+inline char *dtostrf(double number, signed char width, unsigned char prec, char *s)
+{
+    sprintf(s, "%*.*f", width, prec, number);
+    return s;
+}
+
+inline unsigned long micros()
+{
+    using namespace std::chrono;
+    static const steady_clock::time_point start = steady_clock::now();
+    return (unsigned long)duration_cast<microseconds>(steady_clock::now() - start).count();
+}
+inline unsigned long millis() { return micros() / 1000; }
+inline void delay(unsigned long) {}
+inline void yield() {}
+
+// Board I/O: outputs are ignored, inputs read fixed values the tests can set
+namespace NativeBoard
+{
+    inline int &adcMilliVolts()
+    {
+        static int mv = 1900; // 3.8 V after the board's 1:2 divider
+        return mv;
+    }
+}
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t) { return HIGH; }
+inline uint32_t analogReadMilliVolts(uint8_t) { return (uint32_t)NativeBoard::adcMilliVolts(); }
+
+inline bool psramFound() { return true; }
+inline bool psramInit() { return true; }
+inline void *ps_malloc(size_t size) { return malloc(size); }
+inline void *heap_caps_malloc(size_t size, uint32_t) { return malloc(size); }
+inline void heap_caps_free(void *ptr) { free(ptr); }
+inline size_t heap_caps_get_free_size(uint32_t) { return 0; }
+inline size_t heap_caps_get_largest_free_block(uint32_t) { return 0; }
+inline size_t heap_caps_get_minimum_free_size(uint32_t) { return 0; }
+
+class EspClass
+{
+public:
+    uint32_t getFreeHeap() { return 0; }
+    uint32_t getMinFreeHeap() { return 0; }
+    uint32_t getMaxAllocHeap() { return 0; }
+    uint32_t getFreePsram() { return 0; }
+    void restart() { exit(0); }
+};
+inline EspClass ESP;
+
+inline uint32_t esp_random()
+{
+    static uint32_t state = 0x2545F491;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// Wall clock seen by the code under test. Renders depend on "now", so tests pin it;
+// left at 0 it follows the host clock.
+namespace NativeClock
+{
+    inline time_t &pinned()
+    {
+        static time_t t = 0;
+        return t;
+    }
+    inline void set(time_t t) { pinned() = t; }
+    inline time_t now(time_t *out)
+    {
+        time_t t = pinned() ? pinned() : std::time(nullptr);
+        if (out)
+            *out = t;
+        return t;
+    }
+}
+// <time.h> and <ctime> are already in, so nothing after this redeclares time()
+#define time(out) NativeClock::now(out)
+
+#endif
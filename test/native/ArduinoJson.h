@@ -0,0 +1,9 @@
+#ifndef NATIVE_ARDUINO_JSON_H
+#define NATIVE_ARDUINO_JSON_H
+
+// The native env leaves out DataManager.cpp, the only user of ArduinoJson; its
+// header still names the document type in private declarations.
+
+class JsonDocument;
+
+#endif
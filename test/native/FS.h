@@ -0,0 +1,178 @@
+#ifndef NATIVE_FS_H
+#define NATIVE_FS_H
+
+// Host stand-in for the ESP32 FS File, backed by stdio and std::filesystem. Paths
+// are resolved by the filesystem that opened the file (see SD.h).
+
+#include <Arduino.h>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+enum SeekMode
+{
+    SeekSet = 0,
+    SeekCur = 1,
+    SeekEnd = 2
+};
+
+class File
+{
+public:
+    File() {}
+
+    // Open a host file (mode as for fopen, without the "b") or a directory
+    static File openHost(const std::filesystem::path &host, const char *name, const char *mode)
+    {
+        File f;
+        std::error_code ec;
+        if (std::filesystem::is_directory(host, ec))
+        {
+            if (mode[0] != 'r')
+                return f;
+            f._impl = std::make_shared<Impl>();
+            f._impl->name = name;
+            f._impl->host = host;
+            f._impl->directory = true;
+            for (const auto &entry : std::filesystem::directory_iterator(host, ec))
+                f._impl->entries.push_back(entry.path().filename().string());
+            std::sort(f._impl->entries.begin(), f._impl->entries.end());
+            return f;
+        }
+
+        std::string m = std::string(mode);
+        m.insert(1, "b");
+        FILE *fp = fopen(host.string().c_str(), m.c_str());
+        if (!fp)
+            return f;
+        f._impl = std::make_shared<Impl>();
+        f._impl->name = name;
+        f._impl->host = host;
+        f._impl->fp = fp;
+        return f;
+    }
+
+    explicit operator bool() const { return _impl && (_impl->fp || _impl->directory); }
+
+    size_t read(uint8_t *buf, size_t size) { return isFile() ? fread(buf, 1, size, _impl->fp) : 0; }
+    int read()
+    {
+        uint8_t c;
+        return read(&c, 1) == 1 ? c : -1;
+    }
+    size_t readBytes(char *buf, size_t size) { return read((uint8_t *)buf, size); }
+    int peek()
+    {
+        if (!isFile())
+            return -1;
+        int c = fgetc(_impl->fp);
+        if (c != EOF)
+            ungetc(c, _impl->fp);
+        return c == EOF ? -1 : c;
+    }
+    int available()
+    {
+        if (!isFile())
+            return 0;
+        size_t pos = position();
+        size_t len = size();
+        return len > pos ? (int)(len - pos) : 0;
+    }
+
+    size_t write(const uint8_t *buf, size_t size) { return isFile() ? fwrite(buf, 1, size, _impl->fp) : 0; }
+    size_t write(uint8_t c) { return write(&c, 1); }
+    size_t print(const char *s) { return s ? write((const uint8_t *)s, strlen(s)) : 0; }
+    size_t print(const String &s) { return write((const uint8_t *)s.c_str(), s.length()); }
+    size_t println(const char *s) { return print(s) + print("\r\n"); }
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)))
+    {
+        if (!isFile())
+            return 0;
+        va_list args;
+        va_start(args, format);
+        int n = vfprintf(_impl->fp, format, args);
+        va_end(args);
+        return n < 0 ? 0 : (size_t)n;
+    }
+    void flush()
+    {
+        if (isFile())
+            fflush(_impl->fp);
+    }
+
+    bool seek(uint32_t pos, SeekMode mode = SeekSet)
+    {
+        static const int whence[] = {SEEK_SET, SEEK_CUR, SEEK_END};
+        return isFile() && fseek(_impl->fp, (long)pos, whence[mode]) == 0;
+    }
+    size_t position() const { return isFile() ? (size_t)ftell(_impl->fp) : 0; }
+    size_t size() const
+    {
+        if (!isFile())
+            return 0;
+        fflush(_impl->fp);
+        std::error_code ec;
+        uintmax_t len = std::filesystem::file_size(_impl->host, ec);
+        return ec ? 0 : (size_t)len;
+    }
+
+    void close()
+    {
+        if (_impl && _impl->fp)
+        {
+            fclose(_impl->fp);
+            _impl->fp = nullptr;
+        }
+        _impl.reset();
+    }
+
+    const char *name() const { return _impl ? _impl->name.c_str() : ""; }
+    const char *path() const { return name(); }
+    bool isDirectory() const { return _impl && _impl->directory; }
+    File openNextFile(const char *mode = FILE_READ)
+    {
+        if (!isDirectory() || _impl->next >= _impl->entries.size())
+            return File();
+        const std::string &entry = _impl->entries[_impl->next++];
+        std::string child = _impl->name;
+        if (child.empty() || child.back() != '/')
+            child += '/';
+        child += entry;
+        return openHost(_impl->host / entry, child.c_str(), mode);
+    }
+    void rewindDirectory()
+    {
+        if (isDirectory())
+            _impl->next = 0;
+    }
+
+private:
+    struct Impl
+    {
+        std::string name; // as seen by the code under test
+        std::filesystem::path host;
+        FILE *fp = nullptr;
+        bool directory = false;
+        std::vector<std::string> entries;
+        size_t next = 0;
+        ~Impl()
+        {
+            if (fp)
+                fclose(fp);
+        }
+    };
+    std::shared_ptr<Impl> _impl;
+
+    bool isFile() const { return _impl && _impl->fp; }
+};
+
+namespace fs
+{
+    typedef ::File File;
+}
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef NATIVE_GXEPD2_4G_4G_H
+#define NATIVE_GXEPD2_4G_4G_H
+
+#include "GxEPD2_EPD.h"
+
+template <typename GxEPD2_Type, const uint16_t page_height>
+class GxEPD2_4G_4G;
+
+#endif
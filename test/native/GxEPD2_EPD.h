@@ -0,0 +1,36 @@
+#ifndef NATIVE_GXEPD2_EPD_H
+#define NATIVE_GXEPD2_EPD_H
+
+// Host stand-in for the GxEPD2 panel classes named by Config.h: the color constants
+// and driver dimensions. Rendering in the native env goes to a CaptureCanvas, so the
+// display templates are declared but never instantiated.
+
+#include <Adafruit_GFX.h>
+
+#define GxEPD_BLACK 0x0000
+#define GxEPD_WHITE 0xFFFF
+#define GxEPD_DARKGREY 0x7BEF
+#define GxEPD_LIGHTGREY 0xC618
+#define GxEPD_RED 0xF800
+#define GxEPD_YELLOW 0xFFE0
+#define GxEPD_GREEN 0x07E0
+#define GxEPD_BLUE 0x001F
+#define GxEPD_ORANGE 0xFC00
+
+// reTerminal E1001, 7.5" 4-gray
+class GxEPD2_750_GDEY075T7
+{
+public:
+    static const uint16_t WIDTH = 800;
+    static const uint16_t HEIGHT = 480;
+};
+
+// reTerminal E1002, 7.3" 7-color
+class GxEPD2_730c_GDEP073E01
+{
+public:
+    static const uint16_t WIDTH = 800;
+    static const uint16_t HEIGHT = 480;
+};
+
+#endif
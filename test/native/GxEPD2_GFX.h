@@ -0,0 +1,6 @@
+#ifndef NATIVE_GXEPD2_GFX_H
+#define NATIVE_GXEPD2_GFX_H
+
+// Included by Config.h for the 7-color panel; nothing in it is used off the device
+
+#endif
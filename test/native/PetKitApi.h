@@ -0,0 +1,44 @@
+#ifndef NATIVE_PETKIT_API_H
+#define NATIVE_PETKIT_API_H
+
+// The record types of the SmartLitterbox library, which cannot be built for the host
+// (it needs the ESP32 HTTP stack). Keep in step with the library.
+
+#include <Arduino.h>
+#include <vector>
+
+enum ApiType
+{
+    PETKIT,
+    WHISKER
+};
+
+struct SL_Record
+{
+    time_t timestamp;
+    float weight_lbs;
+    int duration_seconds;
+    int PetId;
+};
+
+struct SL_Pet
+{
+    String id;
+    String name;
+    float weight_lbs;
+};
+
+struct SL_Status
+{
+    ApiType api_type;
+    bool is_drawer_full;
+    String device_name;
+    String device_type;
+    int litter_level_percent;
+    int waste_level_percent;
+    bool is_error_state;
+    String status_text;
+    time_t timestamp;
+};
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef NATIVE_PRINT_H
+#define NATIVE_PRINT_H
+
+// Adafruit_GFX includes the core's Print.h; the shim's Print lives in Arduino.h
+
+#include <Arduino.h>
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef NATIVE_SD_H
+#define NATIVE_SD_H
+
+// Host stand-in for the ESP32 SD library: card paths map into a host directory
+// picked with mount(). Nothing is reachable until a directory is mounted.
+
+#include <FS.h>
+#include <SPI.h>
+
+class SDFS
+{
+public:
+    // Serve the card from a host directory (created if missing)
+    bool mount(const std::string &hostDir)
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(hostDir, ec);
+        _root = hostDir;
+        return !ec;
+    }
+    const std::filesystem::path &root() const { return _root; }
+
+    bool begin(uint8_t = 0, SPIClass & = SPI, uint32_t = 4000000, const char * = "/sd", uint8_t = 5, bool = false)
+    {
+        return !_root.empty();
+    }
+    void end() {}
+
+    File open(const char *path, const char *mode = FILE_READ, bool create = false)
+    {
+        if (_root.empty() || !path || path[0] != '/')
+            return File();
+        return File::openHost(host(path), path, mode);
+    }
+    File open(const String &path, const char *mode = FILE_READ, bool create = false) { return open(path.c_str(), mode, create); }
+
+    bool exists(const char *path)
+    {
+        std::error_code ec;
+        return !_root.empty() && std::filesystem::exists(host(path), ec);
+    }
+    bool exists(const String &path) { return exists(path.c_str()); }
+
+    bool remove(const char *path)
+    {
+        std::error_code ec;
+        return !_root.empty() && std::filesystem::is_regular_file(host(path), ec) && std::filesystem::remove(host(path), ec);
+    }
+    bool remove(const String &path) { return remove(path.c_str()); }
+
+    // Like the card: fails if the target exists
+    bool rename(const char *from, const char *to)
+    {
+        std::error_code ec;
+        if (_root.empty() || !std::filesystem::exists(host(from), ec) || std::filesystem::exists(host(to), ec))
+            return false;
+        std::filesystem::rename(host(from), host(to), ec);
+        return !ec;
+    }
+    bool rename(const String &from, const String &to) { return rename(from.c_str(), to.c_str()); }
+
+    bool mkdir(const char *path)
+    {
+        std::error_code ec;
+        if (_root.empty())
+            return false;
+        std::filesystem::create_directory(host(path), ec);
+        return !ec && std::filesystem::is_directory(host(path), ec);
+    }
+    bool mkdir(const String &path) { return mkdir(path.c_str()); }
+
+    bool rmdir(const char *path)
+    {
+        std::error_code ec;
+        return !_root.empty() && std::filesystem::is_directory(host(path), ec) && std::filesystem::remove(host(path), ec);
+    }
+    bool rmdir(const String &path) { return rmdir(path.c_str()); }
+
+    uint64_t cardSize() { return 0; }
+    uint64_t totalBytes() { return 0; }
+    uint64_t usedBytes() { return 0; }
+
+private:
+    std::filesystem::path _root;
+
+    std::filesystem::path host(const char *path) const { return _root / std::string(path).substr(path[0] == '/' ? 1 : 0); }
+};
+
+inline SDFS SD;
+
+#endif
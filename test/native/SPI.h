@@ -0,0 +1,18 @@
+#ifndef NATIVE_SPI_H
+#define NATIVE_SPI_H
+
+// Host stand-in for the ESP32 SPI class; only passed around, never driven
+
+#include <Arduino.h>
+
+class SPIClass
+{
+public:
+    explicit SPIClass(uint8_t bus = 0) {}
+    void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1) {}
+    void end() {}
+};
+
+inline SPIClass SPI;
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef NATIVE_WIFI_PROVISIONER_H
+#define NATIVE_WIFI_PROVISIONER_H
+
+// Included by Config.h; the native env has no provisioning portal
+
+#endif
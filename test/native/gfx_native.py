@@ -0,0 +1,7 @@
+# Extra script for the native envs: builds Adafruit GFX for the host without its
+# display drivers, which need the ESP32 SPI/I2C stack and Adafruit BusIO, and
+# without the fontconvert tool, which needs FreeType.
+Import("env")
+
+for pattern in ("*/Adafruit_SPITFT.cpp", "*/Adafruit_GrayOLED.cpp", "*/fontconvert/*"):
+    env.AddBuildMiddleware(lambda node: None, pattern)
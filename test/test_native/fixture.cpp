@@ -0,0 +1,193 @@
+#include "fixture.h"
+#include <filesystem>
+#include <SD.h>
+
+#ifndef NATIVE_TEST_DIR
+#define NATIVE_TEST_DIR "test"
+#endif
+
+namespace
+{
+    // xorshift32; std distributions differ between standard libraries
+    struct Rng
+    {
+        uint32_t state;
+        explicit Rng(uint32_t seed) : state(seed ? seed : 1) {}
+        uint32_t next()
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return state;
+        }
+        // Uniform in [lo, hi]
+        int32_t range(int32_t lo, int32_t hi) { return lo + (int32_t)(next() % (uint32_t)(hi - lo + 1)); }
+        float unit() { return (next() >> 8) / 16777216.0f; }
+    };
+
+    time_t monthStartUtc(time_t t)
+    {
+        struct tm tm;
+        gmtime_r(&t, &tm);
+        tm.tm_mday = 1;
+        tm.tm_hour = tm.tm_min = tm.tm_sec = 0;
+        return timegm(&tm);
+    }
+
+    time_t nextMonthUtc(time_t monthStart)
+    {
+        struct tm tm;
+        gmtime_r(&monthStart, &tm);
+        tm.tm_mon++;
+        return timegm(&tm);
+    }
+}
+
+namespace Fixture
+{
+    std::string testPath(const char *rel)
+    {
+        return std::string(NATIVE_TEST_DIR) + "/" + rel;
+    }
+
+    std::string cardPath()
+    {
+        return (std::filesystem::temp_directory_path() / "catto_native_card").string();
+    }
+
+    void begin()
+    {
+        std::error_code ec;
+        std::filesystem::remove_all(cardPath(), ec);
+        SD.mount(cardPath());
+        setenv("TZ", "EST5EDT,M3.2.0,M11.1.0", 1);
+        tzset();
+        NativeClock::set(NOW);
+        NativeBoard::adcMilliVolts() = 1900;
+    }
+
+    std::vector<SL_Record> makeRecords(int petId, size_t count, time_t start, uint32_t seed)
+    {
+        Rng rng(seed);
+        float base = 8.0f + (petId % 7);
+        std::vector<SL_Record> records;
+        records.reserve(count);
+        time_t t = start;
+        for (size_t i = 0; i < count; i++)
+        {
+            t += rng.range(3 * 3600, 8 * 3600);
+            float days = (float)(t - start) / 86400.0f;
+            SL_Record rec;
+            rec.timestamp = t;
+            rec.weight_lbs = base + 0.6f * sinf(days / 58.0f) + 0.002f * days + (rng.unit() - 0.5f) * 0.4f;
+            rec.duration_seconds = rng.range(0, 24) == 0 ? 0 : rng.range(60, 480);
+            rec.PetId = petId;
+            records.push_back(rec);
+        }
+        return records;
+    }
+
+    void makePets(std::vector<SL_Pet> &pets, PetDataStore &store)
+    {
+        pets = {{"101", "Mochi", 9.5f}, {"102", "Biscuit", 12.0f}};
+        store.clear();
+        time_t from = NOW - (time_t)HISTORY_DAYS * 86400;
+        for (const auto &pet : pets)
+        {
+            int id = pet.id.toInt();
+            PetSeries &series = store.pet(id);
+            for (const auto &rec : makeRecords(id, HISTORY_DAYS * 6, from, 0x9E3779B9u * id))
+            {
+                if (rec.timestamp <= NOW - 600)
+                    series.insert(rec);
+            }
+
+            std::vector<DailyRollup> days;
+            for (time_t month = monthStartUtc(from); month <= NOW; month = nextMonthUtc(month))
+            {
+                time_t next = nextMonthUtc(month);
+                series.buildRollups(month, next, days);
+                series.replaceRollups(PetSeries::dayOf(month), PetSeries::dayOf(next), days);
+            }
+        }
+    }
+
+    void recordEnv(DataManager &dataManager)
+    {
+        Rng rng(42);
+        time_t from = NOW - (time_t)HISTORY_DAYS * 86400;
+        for (time_t t = from; t <= NOW; t += 7200)
+        {
+            float day = (float)(t % 86400) / 86400.0f;
+            float season = (float)(t - from) / (365.0f * 86400.0f);
+            env_data sample;
+            sample.timestamp = t;
+            sample.temperature = 21.0f + 3.0f * sinf(2 * PI * season) + 1.5f * sinf(2 * PI * day) + (rng.unit() - 0.5f);
+            sample.humidity = 45.0f + 10.0f * cosf(2 * PI * season) - 5.0f * sinf(2 * PI * day) + (rng.unit() - 0.5f) * 4;
+            dataManager.addEnvData(sample);
+        }
+    }
+
+    SL_Status status(ApiType api)
+    {
+        SL_Status s;
+        s.api_type = api;
+        s.is_drawer_full = false;
+        s.device_name = api == PETKIT ? "Pura Max" : "Litter-Robot 4";
+        s.device_type = api == PETKIT ? "t4" : "LR4";
+        s.litter_level_percent = 72;
+        s.waste_level_percent = 41;
+        s.is_error_state = false;
+        s.status_text = "Ready";
+        s.timestamp = NOW - 900;
+        return s;
+    }
+
+    DateRangeInfo range(DateRangeEnum type)
+    {
+        // As App::dateRangeInfo
+        static const DateRangeInfo ranges[] = {
+            {LAST_7_DAYS, "7 Days", 7 * 86400L, false},
+            {LAST_30_DAYS, "30 Days", 30 * 86400L, false},
+            {LAST_90_DAYS, "90 Days", 90 * 86400L, true},
+            {LAST_365_DAYS, "365 Days", 365 * 86400L, true},
+        };
+        return ranges[type];
+    }
+}
+
+// DataManager without the card settings (DataManager.cpp needs ArduinoJson and the
+// board): the history and layout parts the renderer reads, backed by the real
+// EnvStore on the scratch card.
+
+DataManager::DataManager() {}
+
+bool DataManager::begin(SPIClass &spi)
+{
+    _envStore.begin();
+    return true;
+}
+
+void DataManager::addEnvData(env_data newvalue)
+{
+    if (!_envStore.append(newvalue))
+        Serial.println("[DataManager] Failed to log ENV data.");
+}
+
+std::vector<EnvAggregate> DataManager::getEnvHistory(EnvTier tier, time_t from)
+{
+    std::vector<EnvAggregate> env;
+    _envStore.read(tier, from, env);
+    return env;
+}
+
+bool DataManager::getLatestEnvData(env_data &sample)
+{
+    return _envStore.latest(sample);
+}
+
+void DataManager::saveLayout(const std::vector<WidgetConfig> &layout)
+{
+    _layoutSource = layout;
+    LayoutCompiler::compile(layout, _layout);
+}
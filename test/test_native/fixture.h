@@ -0,0 +1,42 @@
+#ifndef NATIVE_TEST_FIXTURE_H
+#define NATIVE_TEST_FIXTURE_H
+
+#include <Arduino.h>
+#include <string>
+#include <vector>
+#include "core/SharedTypes.h"
+#include "core/DataManager.h"
+
+// Deterministic inputs for the native tests: a scratch SD card, a pinned clock and
+// synthetic pet and environment history. Nothing here depends on the host beyond
+// the TZ rules, which are fixed to US Eastern.
+namespace Fixture
+{
+    // Sun 15 Jun 2025 10:40 EDT
+    constexpr time_t NOW = 1749998400;
+    constexpr int HISTORY_DAYS = 400;
+
+    // Empty card in a scratch directory, TZ set, clock pinned to NOW
+    void begin();
+
+    // <project>/test/<rel>
+    std::string testPath(const char *rel);
+    // Scratch card directory on the host
+    std::string cardPath();
+
+    // Two pets with 3 to 5 visits a day over HISTORY_DAYS, plus their daily rollups
+    // (built per UTC month, as SegmentStore keeps them)
+    void makePets(std::vector<SL_Pet> &pets, PetDataStore &store);
+
+    // count visits of one pet from start on, 3 to 8 hours apart, weight drifting
+    // around a per-pet base. The same seed always gives the same records.
+    std::vector<SL_Record> makeRecords(int petId, size_t count, time_t start, uint32_t seed);
+
+    // A temperature/humidity sample every two hours over HISTORY_DAYS
+    void recordEnv(DataManager &dataManager);
+
+    SL_Status status(ApiType api);
+    DateRangeInfo range(DateRangeEnum type);
+}
+
+#endif
@@ -0,0 +1,207 @@
+#include <unity.h>
+#include <vector>
+#include <algorithm>
+#include "core/RenderArena.h"
+#include "ui/ScatterPlot.h"
+
+// ScatterPlot decimation on a dense synthetic series, far above the point counts the
+// dashboard scenes reach: min/max must keep every column's extremes, LTTB the global ones.
+
+static constexpr size_t RAW_POINTS = 20000;
+static constexpr int COLUMNS = 700;             // about the plot area width on the 800 px panels
+static constexpr size_t SPIKE_HIGH = 7000;      // global maximum, right next to
+static constexpr size_t SPIKE_LOW = 7003;       // the global minimum, so one LTTB bucket holds both
+static constexpr float GAP_START = 400.0f;      // x range without samples, leaving columns empty
+static constexpr float GAP_END = 430.0f;
+
+/**
+ * @brief Dense series sorted by strictly increasing x: a slow wave with noise, a gap
+ * and two spikes.
+ */
+static std::vector<DataPoint> makeSeries()
+{
+    std::vector<DataPoint> points;
+    points.reserve(RAW_POINTS);
+    uint32_t seed = 0x2545F491u;
+    float x = 0;
+    for (size_t i = 0; i < RAW_POINTS; i++)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        x += 0.01f + (seed >> 24) * 0.0001f;
+        if (x >= GAP_START && x < GAP_END)
+            x = GAP_END;
+        seed = seed * 1664525u + 1013904223u;
+        float noise = ((seed >> 16) & 0xFFFF) / 65535.0f - 0.5f;
+        points.push_back({x, 10.0f + 2.0f * sinf(x * 0.02f) + noise});
+    }
+    points[SPIKE_HIGH].y = 40.0f;
+    points[SPIKE_LOW].y = -20.0f;
+    return points;
+}
+
+static ArenaVector<DataPoint> toArena(const std::vector<DataPoint> &points)
+{
+    return ArenaVector<DataPoint>(points.begin(), points.end());
+}
+
+static bool samePoint(const DataPoint &a, const DataPoint &b)
+{
+    return a.x == b.x && a.y == b.y;
+}
+
+// Pixel column of x, as ScatterPlot maps it
+static int columnOf(float x, float xMin, float xMax)
+{
+    int c = (int)((x - xMin) * (COLUMNS / (xMax - xMin)));
+    return c < 0 ? 0 : (c >= COLUMNS ? COLUMNS - 1 : c);
+}
+
+// True if every point of kept appears in raw, in the same order
+static bool isSubsequence(const ArenaVector<DataPoint> &kept, const std::vector<DataPoint> &raw)
+{
+    size_t j = 0;
+    for (size_t i = 0; i < kept.size(); i++)
+    {
+        while (j < raw.size() && !samePoint(raw[j], kept[i]))
+            j++;
+        if (j == raw.size())
+            return false;
+        j++;
+    }
+    return true;
+}
+
+static bool contains(const ArenaVector<DataPoint> &points, const DataPoint &p)
+{
+    for (const DataPoint &q : points)
+        if (samePoint(p, q))
+            return true;
+    return false;
+}
+
+static void checkLTTB(const std::vector<DataPoint> &raw, size_t threshold, const ArenaVector<DataPoint> &kept)
+{
+    std::vector<DataPoint> sorted = raw;
+    std::stable_sort(sorted.begin(), sorted.end(), [](const DataPoint &a, const DataPoint &b)
+                     { return a.x < b.x; });
+    auto byY = [](const DataPoint &a, const DataPoint &b) { return a.y < b.y; };
+    const DataPoint &lowest = *std::min_element(sorted.begin(), sorted.end(), byY);
+    const DataPoint &highest = *std::max_element(sorted.begin(), sorted.end(), byY);
+
+    // One extra point when the minimum and maximum share a bucket
+    TEST_ASSERT_TRUE(kept.size() >= threshold && kept.size() <= threshold + 1);
+    TEST_ASSERT_TRUE(samePoint(kept[0], sorted.front()));
+    TEST_ASSERT_TRUE(samePoint(kept[kept.size() - 1], sorted.back()));
+    TEST_ASSERT_TRUE(contains(kept, lowest));
+    TEST_ASSERT_TRUE(contains(kept, highest));
+    TEST_ASSERT_TRUE(isSubsequence(kept, sorted));
+}
+
+static void test_decimate_minmax()
+{
+    const std::vector<DataPoint> raw = makeSeries();
+    const float xMin = 0, xMax = raw.back().x;
+
+    // Reference: the lowest and highest y of every column
+    std::vector<int> count(COLUMNS, 0);
+    std::vector<float> lo(COLUMNS), hi(COLUMNS);
+    for (const DataPoint &p : raw)
+    {
+        int c = columnOf(p.x, xMin, xMax);
+        if (count[c]++ == 0)
+            lo[c] = hi[c] = p.y;
+        lo[c] = std::min(lo[c], p.y);
+        hi[c] = std::max(hi[c], p.y);
+    }
+    size_t expected = 0;
+    int empty = 0;
+    for (int c = 0; c < COLUMNS; c++)
+    {
+        if (count[c] == 0)
+            empty++;
+        else
+            expected += lo[c] == hi[c] ? 1 : 2;
+    }
+    TEST_ASSERT_TRUE(empty > 0);
+
+    {
+        ArenaVector<DataPoint> kept = toArena(raw);
+        uint32_t start = micros();
+        ScatterPlot::decimateMinMax(kept, COLUMNS, xMin, xMax);
+        uint32_t elapsedUs = micros() - start;
+
+        TEST_ASSERT_EQUAL_INT(expected, kept.size());
+        TEST_ASSERT_TRUE(isSubsequence(kept, raw));
+        std::vector<bool> hasLo(COLUMNS, false), hasHi(COLUMNS, false);
+        for (const DataPoint &p : kept)
+        {
+            int c = columnOf(p.x, xMin, xMax);
+            TEST_ASSERT_TRUE(count[c] > 0);
+            hasLo[c] = hasLo[c] || p.y == lo[c];
+            hasHi[c] = hasHi[c] || p.y == hi[c];
+        }
+        for (int c = 0; c < COLUMNS; c++)
+        {
+            TEST_ASSERT_TRUE(hasLo[c] == (count[c] > 0));
+            TEST_ASSERT_TRUE(hasHi[c] == (count[c] > 0));
+        }
+        Serial.printf("[Decimation] minmax: %u -> %u points over %d columns (%d empty) in %lu us\r\n",
+                      (unsigned)raw.size(), (unsigned)kept.size(), COLUMNS, empty, (unsigned long)elapsedUs);
+
+        // A series that already fits is left alone
+        ArenaVector<DataPoint> small(kept.begin(), kept.begin() + COLUMNS);
+        ScatterPlot::decimateMinMax(small, COLUMNS, xMin, xMax);
+        TEST_ASSERT_EQUAL_INT(COLUMNS, small.size());
+    }
+    RenderArena::reset();
+}
+
+static void test_decimate_lttb()
+{
+    const std::vector<DataPoint> raw = makeSeries();
+    const size_t threshold = COLUMNS * 2;
+    {
+        ArenaVector<DataPoint> kept = toArena(raw);
+        uint32_t start = micros();
+        ScatterPlot::decimateLTTB(kept, threshold);
+        uint32_t elapsedUs = micros() - start;
+        checkLTTB(raw, threshold, kept);
+        TEST_ASSERT_EQUAL_INT(threshold + 1, kept.size());
+        Serial.printf("[Decimation] lttb: %u -> %u points in %lu us\r\n",
+                      (unsigned)raw.size(), (unsigned)kept.size(), (unsigned long)elapsedUs);
+
+        // Shuffled input is sorted first, giving the same result (x values are unique)
+        std::vector<DataPoint> shuffled = raw;
+        uint32_t seed = 0x68E31DA4u;
+        for (size_t i = shuffled.size() - 1; i > 0; i--)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            std::swap(shuffled[i], shuffled[seed % (i + 1)]);
+        }
+        ArenaVector<DataPoint> fromShuffled = toArena(shuffled);
+        ScatterPlot::decimateLTTB(fromShuffled, threshold);
+        TEST_ASSERT_EQUAL_INT(kept.size(), fromShuffled.size());
+        for (size_t i = 0; i < kept.size(); i++)
+            TEST_ASSERT_TRUE(samePoint(kept[i], fromShuffled[i]));
+
+        // Extremes on the first and last point, which are kept outside the buckets
+        std::vector<DataPoint> edges = raw;
+        edges.front().y = -50.0f;
+        edges.back().y = 80.0f;
+        ArenaVector<DataPoint> fromEdges = toArena(edges);
+        ScatterPlot::decimateLTTB(fromEdges, threshold);
+        checkLTTB(edges, threshold, fromEdges);
+
+        // A series that already fits is left alone
+        ArenaVector<DataPoint> small(kept.begin(), kept.begin() + threshold);
+        ScatterPlot::decimateLTTB(small, threshold);
+        TEST_ASSERT_EQUAL_INT(threshold, small.size());
+    }
+    RenderArena::reset();
+}
+
+void runDecimationTests()
+{
+    RUN_TEST(test_decimate_minmax);
+    RUN_TEST(test_decimate_lttb);
+}
@@ -0,0 +1,21 @@
+#include <unity.h>
+
+// Host tests, run with `pio test -e native` (E1002 palette) or `-e native_e1001`
+
+void runRenderTests();
+void runPetStoreTests();
+void runDecimationTests();
+void runProcessedCacheTests();
+
+void setUp() {}
+void tearDown() {}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    runRenderTests();
+    runPetStoreTests();
+    runDecimationTests();
+    runProcessedCacheTests();
+    return UNITY_END();
+}
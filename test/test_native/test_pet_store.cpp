@@ -0,0 +1,236 @@
+#include <unity.h>
+#include <map>
+#include <algorithm>
+#include "fixture.h"
+#include "core/PetDataStore.h"
+
+// PetDataStore against the nested map it replaced, built from the same synthetic
+// records: load (a log replay), merge (an overlapping API batch) and range scans.
+
+// The old PetDataMap: PetID -> timestamp -> record
+typedef std::map<int, std::map<time_t, SL_Record>> LegacyPetMap;
+
+static const int PET_IDS[] = {101, 102};
+static constexpr size_t BATCH_NEW = 500;     // records per pet only in the API batch
+static constexpr size_t BATCH_OVERLAP = 500; // records per pet in both
+static constexpr int SCAN_REPEATS = 200;
+
+struct ScanTotals
+{
+    size_t count = 0;
+    double weight = 0;
+    long duration = 0;
+};
+
+/**
+ * @brief Synthetic history for both pets, in log order (all pets interleaved by time).
+ */
+static std::vector<SL_Record> makeLog(size_t total)
+{
+    size_t perPet = total / 2;
+    time_t start = Fixture::NOW - (time_t)perPet * 6 * 3600;
+    std::vector<SL_Record> log;
+    log.reserve(total);
+    for (int id : PET_IDS)
+    {
+        std::vector<SL_Record> records = Fixture::makeRecords(id, perPet, start, 0x9E3779B9u * id);
+        log.insert(log.end(), records.begin(), records.end());
+    }
+    std::stable_sort(log.begin(), log.end(), [](const SL_Record &a, const SL_Record &b)
+                     { return a.timestamp < b.timestamp; });
+    return log;
+}
+
+// Load as the old DataManager did: one map insert per log record
+static void loadLegacy(const std::vector<SL_Record> &log, LegacyPetMap &petData)
+{
+    for (const auto &rec : log)
+        petData[rec.PetId][rec.timestamp] = rec;
+}
+
+// Load as RecordLog::load does: collect per pet, then one merge per pet
+static void loadStore(const std::vector<SL_Record> &log, PetDataStore &petData)
+{
+    std::map<int, std::vector<SL_Record>> perPet;
+    for (const auto &rec : log)
+        perPet[rec.PetId].push_back(rec);
+    for (auto const &petPair : perPet)
+        petData.pet(petPair.first).merge(petPair.second, petPair.first, nullptr);
+}
+
+// Merge as the old DataManager::mergeData did, queueing new or changed records
+static void mergeLegacy(LegacyPetMap &mainData, int petId, const std::vector<SL_Record> &newRecords, std::vector<SL_Record> &pending)
+{
+    auto &petRecords = mainData[petId];
+    for (const auto &record : newRecords)
+    {
+        auto it = petRecords.find(record.timestamp);
+        if (it != petRecords.end() &&
+            it->second.weight_lbs == record.weight_lbs &&
+            it->second.duration_seconds == record.duration_seconds)
+            continue;
+
+        SL_Record rec = record;
+        rec.PetId = petId;
+        petRecords[rec.timestamp] = rec;
+        pending.push_back(rec);
+    }
+}
+
+static ScanTotals scanLegacy(const LegacyPetMap &petData, time_t from, time_t to)
+{
+    ScanTotals totals;
+    for (auto const &petPair : petData)
+    {
+        const auto &records = petPair.second;
+        for (auto it = records.lower_bound(from); it != records.end() && it->first <= to; ++it)
+        {
+            totals.count++;
+            totals.weight += it->second.weight_lbs;
+            totals.duration += it->second.duration_seconds;
+        }
+    }
+    return totals;
+}
+
+static ScanTotals scanStore(const PetDataStore &petData, time_t from, time_t to)
+{
+    ScanTotals totals;
+    for (auto const &petPair : petData)
+    {
+        const PetSeries &series = petPair.second;
+        size_t end = series.upperBound(to);
+        for (size_t i = series.lowerBound(from); i < end; i++)
+        {
+            totals.count++;
+            totals.weight += series.weight(i);
+            totals.duration += (long)series.duration(i);
+        }
+    }
+    return totals;
+}
+
+static void assertSameContents(const LegacyPetMap &legacy, const PetDataStore &store)
+{
+    TEST_ASSERT_EQUAL_INT(legacy.size(), std::distance(store.begin(), store.end()));
+    for (auto const &petPair : legacy)
+    {
+        const PetSeries *series = store.find(petPair.first);
+        TEST_ASSERT_TRUE(series != nullptr);
+        TEST_ASSERT_EQUAL_INT(petPair.second.size(), series->size());
+        size_t i = 0;
+        for (auto const &entry : petPair.second)
+        {
+            TEST_ASSERT_TRUE(series->timestamp(i) == entry.first);
+            TEST_ASSERT_TRUE(series->weight(i) == entry.second.weight_lbs);
+            TEST_ASSERT_TRUE(series->duration(i) == (float)entry.second.duration_seconds);
+            i++;
+        }
+    }
+}
+
+/**
+ * @brief Builds both structures from the same records and times each operation.
+ *
+ * The log holds all but the last BATCH_NEW records of each pet. The API batch is the
+ * last BATCH_OVERLAP + BATCH_NEW records, with every fourth overlapping weight changed.
+ */
+static void compareAt(size_t total)
+{
+    Fixture::begin();
+    std::vector<SL_Record> all = makeLog(total);
+
+    std::vector<SL_Record> log;
+    std::map<int, std::vector<SL_Record>> batches;
+    std::map<int, size_t> remaining;
+    for (int id : PET_IDS)
+        remaining[id] = total / 2;
+    for (const auto &rec : all)
+    {
+        size_t left = remaining[rec.PetId]--;
+        if (left > BATCH_NEW)
+            log.push_back(rec);
+        if (left <= BATCH_NEW + BATCH_OVERLAP)
+        {
+            SL_Record fresh = rec;
+            if (left > BATCH_NEW && left % 4 == 0)
+                fresh.weight_lbs += 0.1f;
+            batches[rec.PetId].push_back(fresh);
+        }
+    }
+
+    LegacyPetMap legacy;
+    PetDataStore store;
+    uint32_t start = micros();
+    loadLegacy(log, legacy);
+    uint32_t legacyLoadUs = micros() - start;
+    start = micros();
+    loadStore(log, store);
+    uint32_t storeLoadUs = micros() - start;
+    assertSameContents(legacy, store);
+
+    std::vector<SL_Record> legacyPending, storePending;
+    start = micros();
+    for (auto const &batch : batches)
+        mergeLegacy(legacy, batch.first, batch.second, legacyPending);
+    uint32_t legacyMergeUs = micros() - start;
+    start = micros();
+    for (auto const &batch : batches)
+        store.pet(batch.first).merge(batch.second, batch.first, &storePending);
+    uint32_t storeMergeUs = micros() - start;
+    assertSameContents(legacy, store);
+    TEST_ASSERT_EQUAL_INT(legacyPending.size(), storePending.size());
+    TEST_ASSERT_EQUAL_INT(2 * (BATCH_NEW + BATCH_OVERLAP / 4), storePending.size());
+
+    // The dashboard ranges, ending at the newest record
+    static const int RANGE_DAYS[] = {7, 30, 90, 365};
+    time_t latest = store.latestTimestamp();
+    ScanTotals legacyTotals, storeTotals;
+    start = micros();
+    for (int r = 0; r < SCAN_REPEATS; r++)
+        for (int days : RANGE_DAYS)
+        {
+            ScanTotals t = scanLegacy(legacy, latest - days * 86400L, latest);
+            legacyTotals.count += t.count;
+            legacyTotals.weight += t.weight;
+            legacyTotals.duration += t.duration;
+        }
+    uint32_t legacyScanUs = micros() - start;
+    start = micros();
+    for (int r = 0; r < SCAN_REPEATS; r++)
+        for (int days : RANGE_DAYS)
+        {
+            ScanTotals t = scanStore(store, latest - days * 86400L, latest);
+            storeTotals.count += t.count;
+            storeTotals.weight += t.weight;
+            storeTotals.duration += t.duration;
+        }
+    uint32_t storeScanUs = micros() - start;
+    TEST_ASSERT_EQUAL_INT(legacyTotals.count, storeTotals.count);
+    TEST_ASSERT_TRUE(legacyTotals.weight == storeTotals.weight);
+    TEST_ASSERT_EQUAL_INT(legacyTotals.duration, storeTotals.duration);
+
+    Serial.printf("[PetDataStore] %u records, map vs columns: load %lu / %lu us, merge %u (%u new/changed) %lu / %lu us, "
+                  "%d range scans (%u records) %lu / %lu us\r\n",
+                  (unsigned)total, (unsigned long)legacyLoadUs, (unsigned long)storeLoadUs,
+                  (unsigned)(2 * (BATCH_NEW + BATCH_OVERLAP)), (unsigned)storePending.size(),
+                  (unsigned long)legacyMergeUs, (unsigned long)storeMergeUs,
+                  SCAN_REPEATS * (int)(sizeof(RANGE_DAYS) / sizeof(RANGE_DAYS[0])), (unsigned)storeTotals.count,
+                  (unsigned long)legacyScanUs, (unsigned long)storeScanUs);
+}
+
+static void test_pet_store_10k()
+{
+    compareAt(10000);
+}
+
+static void test_pet_store_100k()
+{
+    compareAt(100000);
+}
+
+void runPetStoreTests()
+{
+    RUN_TEST(test_pet_store_10k);
+    RUN_TEST(test_pet_store_100k);
+}
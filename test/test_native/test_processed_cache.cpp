@@ -0,0 +1,222 @@
+#include <unity.h>
+#include <vector>
+#include <algorithm>
+#include "fixture.h"
+#include "core/RenderArena.h"
+#include "core/SegmentStore.h"
+#include "ui/DataProcessor.h"
+#include "ui/ProcessedCache.h"
+
+// ProcessedCache against a full DataProcessor::process, step by step through a random
+// history: the clock moves on, records are appended, replaced and backfilled through
+// SegmentStore, the manifest is rebuilt, and a pet without visits gains some. Every
+// step, every range must come out of the cache exactly as a full process gives it.
+
+static constexpr int STEPS = 80;
+static constexpr int REBUILD_STEP = 30;   // manifest lost, rebuilt from the segments
+static constexpr int LATE_PET_STEP = 50;  // pet 103 logs its first visits
+static constexpr int HISTORY_DAYS = 200;
+static const char *DATA_DIR = "/data";
+static const char *MANIFEST_PATH = "/data/manifest.bin";
+static const std::vector<ColorPair> COLORS = {{0x0000, 0xFFFF}, {0xF800, 0xFFFF}, {0x001F, 0xFFFF}};
+static const DateRangeEnum RANGES[] = {LAST_7_DAYS, LAST_30_DAYS, LAST_90_DAYS, LAST_365_DAYS};
+static constexpr int RANGE_COUNT = sizeof(RANGES) / sizeof(RANGES[0]);
+
+// xorshift32, as the fixture uses
+struct StepRng
+{
+    uint32_t state;
+    uint32_t next()
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+    int32_t range(int32_t lo, int32_t hi) { return lo + (int32_t)(next() % (uint32_t)(hi - lo + 1)); }
+};
+
+// Which path ProcessedCache::process takes for a view cached at generation cached
+enum CachePath
+{
+    PATH_REUSE,
+    PATH_EXTEND,
+    PATH_FULL,
+};
+
+static CachePath expectedPath(bool cachedValid, uint32_t cached, uint32_t generation, uint32_t rewriteGeneration)
+{
+    if (!cachedValid)
+        return PATH_FULL;
+    if (cached == generation)
+        return PATH_REUSE;
+    if ((int32_t)(generation - cached) > 0 && (int32_t)(cached - rewriteGeneration) >= 0)
+        return PATH_EXTEND;
+    return PATH_FULL;
+}
+
+static void assertSameView(const DashboardData &expected, const DashboardData &actual, int step, const char *range)
+{
+    char message[96];
+    snprintf(message, sizeof(message), "step %d, %s", step, range);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(expected.timeStart, actual.timeStart, message);
+    TEST_ASSERT_TRUE_MESSAGE(expected.useRollups == actual.useRollups, message);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(expected.series.size(), actual.series.size(), message);
+    for (size_t s = 0; s < expected.series.size(); s++)
+    {
+        const ProcessedSeries &e = expected.series[s];
+        const ProcessedSeries &a = actual.series[s];
+        TEST_ASSERT_TRUE_MESSAGE(e.name == a.name, message);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(e.petId, a.petId, message);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(e.color, a.color, message);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(e.bgColor, a.bgColor, message);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(e.scatterPoints.size(), a.scatterPoints.size(), message);
+        for (size_t i = 0; i < e.scatterPoints.size(); i++)
+        {
+            TEST_ASSERT_TRUE_MESSAGE(e.scatterPoints[i].x == a.scatterPoints[i].x, message);
+            TEST_ASSERT_TRUE_MESSAGE(e.scatterPoints[i].y == a.scatterPoints[i].y, message);
+        }
+    }
+}
+
+/**
+ * @brief Appends up to maxPerPet visits per pet over the last day, all newer than any
+ * stored visit (of any pet, so the save counts as an append).
+ */
+static void appendVisits(PetDataStore &store, const std::vector<int> &petIds, int maxPerPet, StepRng &rng,
+                         std::vector<SL_Record> &pending)
+{
+    time_t now = time(NULL);
+    const time_t from = std::max(store.latestTimestamp(), now - 86400L);
+    for (int id : petIds)
+    {
+        PetSeries &series = store.pet(id);
+        time_t t = from;
+        std::vector<SL_Record> batch;
+        for (int n = rng.range(0, maxPerPet); n > 0; n--)
+        {
+            t += rng.range(600, 8 * 3600);
+            if (t > now)
+                break;
+            SL_Record rec = {};
+            rec.timestamp = t;
+            rec.weight_lbs = 8.0f + (id % 7) + rng.range(-200, 200) / 1000.0f;
+            rec.duration_seconds = rng.range(60, 480);
+            rec.PetId = id;
+            batch.push_back(rec);
+        }
+        series.merge(batch, id, &pending);
+    }
+}
+
+/**
+ * @brief Queues one change that is not an append: a visit of the last week re-reported
+ * with another weight, or a visit backfilled between two stored ones.
+ */
+static void rewriteVisit(PetDataStore &store, int petId, StepRng &rng, std::vector<SL_Record> &pending)
+{
+    PetSeries &series = store.pet(petId);
+    size_t first = series.lowerBound(time(NULL) - 7 * 86400L);
+    if (first + 1 >= series.size())
+        return;
+    size_t i = first + rng.range(0, (int32_t)(series.size() - first - 2));
+    SL_Record rec = series.record(i, petId);
+    if (rng.range(0, 1))
+        rec.weight_lbs += 0.25f;
+    else
+        rec.timestamp += (series.timestamp(i + 1) - rec.timestamp) / 2;
+    series.merge({rec}, petId, &pending);
+}
+
+static void test_processed_cache_matches_process()
+{
+    Fixture::begin();
+    const time_t start = Fixture::NOW - 30 * 86400L;
+    NativeClock::set(start);
+
+    std::vector<SL_Pet> pets = {{"101", "Mochi", 9.5f}, {"102", "Biscuit", 12.0f}, {"103", "Pickles", 10.0f}};
+    PetDataStore store;
+    for (int id : {101, 102})
+    {
+        std::vector<SL_Record> records =
+            Fixture::makeRecords(id, HISTORY_DAYS * 6, start - (time_t)HISTORY_DAYS * 86400L, 0x9E3779B9u * id);
+        while (!records.empty() && records.back().timestamp > start)
+            records.pop_back();
+        store.pet(id).merge(records, id, nullptr);
+    }
+
+    SegmentStore segments(DATA_DIR);
+    TEST_ASSERT_TRUE(segments.begin());
+    TEST_ASSERT_TRUE(segments.import(store));
+    ProcessedCache cache("/cache");
+
+    StepRng rng = {0x5EED1234u};
+    bool cachedValid[RANGE_COUNT] = {};
+    uint32_t cachedGeneration[RANGE_COUNT] = {};
+    int paths[3] = {};
+    int rewrites = 0;
+    for (int step = 0; step < STEPS; step++)
+    {
+        NativeClock::set(time(NULL) + rng.range(1, 30) * 3600);
+        uint32_t generation = segments.generation();
+        uint32_t rewriteGeneration = segments.rewriteGeneration();
+
+        std::vector<SL_Record> pending;
+        int action = rng.range(0, 9);
+        if (step == REBUILD_STEP)
+        {
+            SD.remove(MANIFEST_PATH);
+            SegmentStore reopened(DATA_DIR);
+            TEST_ASSERT_TRUE(reopened.begin());
+            TEST_ASSERT_TRUE(reopened.generation() != generation);
+            TEST_ASSERT_EQUAL_UINT32(reopened.generation(), reopened.rewriteGeneration());
+            segments = reopened;
+        }
+        else if (step == LATE_PET_STEP)
+            appendVisits(store, {103}, 4, rng, pending);
+        else if (action < 6)
+            appendVisits(store, {101, 102, 103}, 5, rng, pending);
+        else if (action < 8)
+            rewriteVisit(store, 101 + rng.range(0, 1), rng, pending);
+
+        if (!pending.empty())
+        {
+            segments.save(store, pending);
+            TEST_ASSERT_TRUE(segments.generation() != generation);
+            if (segments.rewriteGeneration() != rewriteGeneration)
+            {
+                TEST_ASSERT_EQUAL_UINT32(segments.generation(), segments.rewriteGeneration());
+                rewrites++;
+            }
+        }
+
+        for (int r = 0; r < RANGE_COUNT; r++)
+        {
+            DateRangeInfo range = Fixture::range(RANGES[r]);
+            {
+                DashboardData cached = cache.process(pets, store, range, COLORS, segments.generation(),
+                                                     segments.rewriteGeneration());
+                DashboardData full = DataProcessor::process(pets, store, range, COLORS);
+                assertSameView(full, cached, step, range.name);
+            }
+            RenderArena::reset();
+
+            // A pet gaining its first visits changes the series list, which is a miss
+            bool valid = cachedValid[r] && step != LATE_PET_STEP;
+            paths[expectedPath(valid, cachedGeneration[r], segments.generation(), segments.rewriteGeneration())]++;
+            cachedValid[r] = true;
+            cachedGeneration[r] = segments.generation();
+        }
+    }
+
+    Serial.printf("[ProcessedCache] %d steps x %d ranges: %d reused, %d extended, %d full (%d rewrites, 1 rebuild)\r\n",
+                  STEPS, RANGE_COUNT, paths[PATH_REUSE], paths[PATH_EXTEND], paths[PATH_FULL], rewrites);
+    TEST_ASSERT_TRUE(paths[PATH_REUSE] > 0);
+    TEST_ASSERT_TRUE(paths[PATH_EXTEND] > 0);
+    TEST_ASSERT_TRUE(rewrites > 0);
+}
+
+void runProcessedCacheTests()
+{
+    RUN_TEST(test_processed_cache_matches_process);
+}
@@ -0,0 +1,143 @@
+#include <unity.h>
+#include <SD.h>
+#include "fixture.h"
+#include "core/RenderArena.h"
+#include "ui/PlotManager.h"
+#include "ui/CaptureCanvas.h"
+#include "ui/PatternFill.h"
+#include "ui/MarkerSprite.h"
+
+// Full renders into a CaptureCanvas, compared pixel for pixel with the golden frames
+// in test/golden/<panel>/. Run with UPDATE_GOLDENS=1 to write the goldens instead; a
+// missing golden is written from the current frame and the test is ignored.
+// Every frame is also saved next to the scratch card (Fixture::cardPath() + "_frames").
+
+#if (EPD_SELECT == 1001)
+static const char *PANEL = "e1001";
+#else
+static const char *PANEL = "e1002";
+#endif
+
+static std::vector<WidgetConfig> whiskerLayout()
+{
+    // DataManager::defaultLayout() for a Litter-Robot
+    return {
+        WidgetConfig{"ScatterPlot", 0, 10, 800, 200, 0, 0, "Weight (lb) - %s", "scatter", 0, 0, "", 0xffff},
+        WidgetConfig{"ScatterPlot", 0, 210, 400, 150, 0, 0, "Temperature (C)", "temperature_history", 0, 0, "", 0xffff},
+        WidgetConfig{"ScatterPlot", 400, 210, 400, 150, 0, 0, "Humidity (%RH)", "humidity_history", 0, 0, "", 0xffff},
+        WidgetConfig{"Histogram", 0, 360, 300, 120, 28, 0, "Interval (Hours)", "interval", 0, 0, "", 0xffff},
+        WidgetConfig{"Histogram", 300, 360, 300, 120, 28, 0, "Weight Change (lb/Month)", "weight_change", 0, 0, "", 0xffff},
+        WidgetConfig{"LinearGauge", 725, 2, 59, 22, 0, 0, "", "battery", 0, 100, "%", 0xffff},
+        WidgetConfig{"TextLabel", 29, 8, 200, 20, 0, 0, "%b %d, %I:%M %p", "datetime", 0, 0, "", 0xffff},
+        WidgetConfig{"LinearGauge", 605, 380, 180, 35, 0, 0, "Litter: ", "litter", 0, 100, "%", 0xffff},
+        WidgetConfig{"LinearGauge", 605, 430, 180, 35, 0, 0, "Waste: ", "waste", 0, 100, "%", 0xffff},
+    };
+}
+
+static std::vector<WidgetConfig> petkitLayout()
+{
+    // The PetKit default with title bar colors and the widget kinds and sources the
+    // Litter-Robot one lacks
+    std::vector<WidgetConfig> layout = {
+        WidgetConfig{"ScatterPlot", 0, 10, 800, 300, 0, 0, "Weight (lb) - %s", "scatter", 0, 0, "", EPD_BLUE},
+        WidgetConfig{"Histogram", 0, 310, 270, 170, 0, 0, "Interval (Hours)", "interval", 0, 0, "", EPD_GREEN},
+        WidgetConfig{"Histogram", 270, 310, 270, 170, 0, 0, "Duration (Minutes)", "duration", 0, 0, "", EPD_RED},
+        WidgetConfig{"LinearGauge", 725, 2, 59, 22, 0, 0, "", "battery", 0, 100, "%", 0xffff},
+        WidgetConfig{"TextLabel", 29, 8, 200, 20, 0, 0, "%m/%d %H:%M", "datetime", 0, 0, "", EPD_BLACK},
+        WidgetConfig{"RingGauge", 600, 375, 45, 12, 135, 405, "Litter", "litter", 0, 100, "%", EPD_BLUE},
+        WidgetConfig{"TextLabel", 680, 350, 110, 20, 0, 0, "", "temperature", 0, 0, "", EPD_BLACK},
+        WidgetConfig{"TextLabel", 680, 385, 110, 20, 0, 0, "", "humidity", 0, 0, "", EPD_BLACK},
+        WidgetConfig{"StatusBox", 610, 435, 175, 38, 0, 0, "", "petkit_status", 0, 0, "", 0xffff},
+    };
+    layout[0].decimation = "lttb";
+    return layout;
+}
+
+/**
+ * @brief Renders one scene and checks it against its golden frame.
+ *
+ * Logs per-widget draw time and pixel writes (PlotManager::profile) on the way.
+ */
+static void renderScene(const char *scene, const std::vector<WidgetConfig> &layout, ApiType api, DateRangeEnum rangeType)
+{
+    Fixture::begin();
+    DataManager dataManager;
+    SPIClass spi;
+    dataManager.begin(spi);
+    dataManager.saveLayout(layout);
+    Fixture::recordEnv(dataManager);
+
+    std::vector<SL_Pet> pets;
+    PetDataStore store;
+    Fixture::makePets(pets, store);
+
+    TEST_ASSERT_TRUE(RenderArena::begin(Config::RENDER_ARENA_BYTES));
+    CaptureCanvas canvas;
+    TEST_ASSERT_TRUE(canvas.begin());
+    PlotManager plotManager(&canvas, &dataManager);
+    plotManager.prepare(pets, store, Fixture::range(rangeType), Fixture::status(api), 3.9f);
+    plotManager.profile(canvas);
+    plotManager.release();
+    RenderArena::reset();
+
+    // The frame goes next to the scratch card, which the next test wipes
+    char path[64];
+    snprintf(path, sizeof(path), "/%s", scene);
+    std::string frameDir = Fixture::cardPath() + "_frames/" + PANEL;
+    SD.mount(frameDir);
+    TEST_ASSERT_TRUE(canvas.writeImage(path));
+
+    std::string goldenDir = Fixture::testPath("golden/") + PANEL;
+    SD.mount(goldenDir);
+    const char *update = getenv("UPDATE_GOLDENS");
+    if (update && update[0] == '1')
+    {
+        TEST_ASSERT_TRUE(canvas.writeImage(path));
+        TEST_MESSAGE("golden image updated");
+        return;
+    }
+    char message[256];
+    if (!SD.exists(String(path) + CaptureCanvas::IMAGE_EXT))
+    {
+        TEST_ASSERT_TRUE(canvas.writeImage(path));
+        snprintf(message, sizeof(message), "no golden image yet, wrote %s%s%s from this run: check it and commit it",
+                 goldenDir.c_str(), path, CaptureCanvas::IMAGE_EXT);
+        TEST_IGNORE_MESSAGE(message);
+    }
+
+    int32_t diff = canvas.compareImage(path);
+    if (diff < 0)
+        snprintf(message, sizeof(message), "golden image %s%s%s is unreadable or has another size", goldenDir.c_str(),
+                 path, CaptureCanvas::IMAGE_EXT);
+    else
+        snprintf(message, sizeof(message), "%ld pixels differ from %s%s%s, frame in %s", (long)diff, goldenDir.c_str(),
+                 path, CaptureCanvas::IMAGE_EXT, frameDir.c_str());
+    TEST_ASSERT_EQUAL_INT32_MESSAGE(0, diff, message);
+}
+
+static void test_render_whisker_week()
+{
+    renderScene("whisker_week", whiskerLayout(), WHISKER, LAST_7_DAYS);
+}
+
+static void test_render_petkit_year()
+{
+    renderScene("petkit_year", petkitLayout(), PETKIT, LAST_365_DAYS);
+}
+
+// The fast paths against their per-pixel equivalents, as App::profileView runs them
+static void test_draw_benchmarks()
+{
+    Fixture::begin();
+    CaptureCanvas canvas;
+    TEST_ASSERT_TRUE(canvas.begin());
+    TEST_ASSERT_TRUE_MESSAGE(PatternFill::benchmark(canvas), "pattern fill paths drew different frames");
+    TEST_ASSERT_TRUE_MESSAGE(MarkerSprite::benchmark(canvas), "stamped markers differ from the primitives");
+}
+
+void runRenderTests()
+{
+    RUN_TEST(test_render_whisker_week);
+    RUN_TEST(test_render_petkit_year);
+    RUN_TEST(test_draw_benchmarks);
+}